@@ -98,6 +98,10 @@ protected:
 	// called by according driver for fetching new sound-data
 	fpp_t getNextBuffer(SampleFrame* _ab);
 
+	// same as getNextBuffer() but without copying: _ab points to the
+	// engine's period which stays valid until the next call
+	fpp_t getNextBufferView(const SampleFrame*& _ab);
+
 	// convert a given audio-buffer to a buffer in signed 16-bit samples
 	// returns num of bytes in outbuf
 	int convertToS16(const SampleFrame* _ab,
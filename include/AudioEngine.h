@@ -30,6 +30,7 @@
 #include <QThread>
 #include <samplerate.h>
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -37,7 +38,7 @@
 #include "lmms_basics.h"
 #include "SampleFrame.h"
 #include "LocklessList.h"
-#include "FifoBuffer.h"
+#include "PeriodRing.h"
 #include "AudioEngineProfiler.h"
 #include "PlayHandle.h"
 
@@ -173,12 +174,7 @@ public:
 
 
 	// audio-port-stuff
-	inline void addAudioPort(AudioPort * port)
-	{
-		requestChangeInModel();
-		m_audioPorts.push_back(port);
-		doneChangeInModel();
-	}
+	void addAudioPort(AudioPort * port);
 
 	void removeAudioPort(AudioPort * port);
 
@@ -236,6 +232,36 @@ public:
 	}
 
 
+	//! In pipelined mode the instruments of a period are rendered while the
+	//! effects and the master mix of the previous period are processed.
+	//! This increases throughput on many cores at the cost of one period of
+	//! additional latency.
+	bool isPipelined() const
+	{
+		return m_pipelined;
+	}
+
+	void setPipelined(bool pipelined);
+
+	//! Frames between a note starting and it being heard at the master
+	//! output, not counting the buffering of the audio device: the latency
+	//! of the effects on the longest path through the mixer plus the
+	//! period added in pipelined mode
+	f_cnt_t processingLatency() const;
+
+	//! Index of the play handle buffer instruments render into
+	int playHandleWriteBuffer() const
+	{
+		return m_pipelined ? m_playHandleBufferIndex : 0;
+	}
+
+	//! Index of the play handle buffer audio ports mix from
+	int playHandleReadBuffer() const
+	{
+		return m_pipelined ? 1 - m_playHandleBufferIndex : 0;
+	}
+
+
 	sample_rate_t baseSampleRate() const { return m_baseSampleRate; }
 
 
@@ -295,9 +321,13 @@ public:
 		return m_inputBufferFrames[ m_inputBufferRead ];
 	}
 
-	inline const SampleFrame* nextBuffer()
+	//! Return the next period for the audio device. The buffer stays valid
+	//! until the next call, nullptr is returned once processing stopped.
+	const SampleFrame* nextBuffer();
+
+	PeriodRing::Statistics fifoStatistics() const
 	{
-		return hasFifoWriter() ? m_fifo->read() : renderNextBuffer();
+		return m_fifo->statistics();
 	}
 
 	void changeQuality(const struct qualitySettings & qs);
@@ -322,19 +352,17 @@ signals:
 
 
 private:
-	using Fifo = FifoBuffer<SampleFrame*>;
-
 	class fifoWriter : public QThread
 	{
 	public:
-		fifoWriter( AudioEngine * audioEngine, Fifo * fifo );
+		fifoWriter( AudioEngine * audioEngine, PeriodRing * fifo );
 
 		void finish();
 
 
 	private:
 		AudioEngine * m_audioEngine;
-		Fifo * m_fifo;
+		PeriodRing * m_fifo;
 		volatile bool m_writing;
 
 		void run() override;
@@ -356,8 +384,16 @@ private:
 	void renderStageNoteSetup();
 	void renderStageInstruments();
 	void renderStageEffects();
+	void renderStagesPipelined();
 	void renderStageMix();
 
+	void removeFinishedPlayHandles();
+	//! detaches the play handle from its audio port and deletes it
+	void deletePlayHandle(PlayHandle* handle);
+
+	// called by AudioPort when it has been processed
+	void audioPortProcessed();
+
 	const SampleFrame* renderNextBuffer();
 
 	void swapBuffers();
@@ -389,11 +425,19 @@ private:
 	// place where new playhandles are added temporarily
 	LocklessList<PlayHandle *> m_newPlayHandles;
 	ConstPlayHandleList m_playHandlesToRemove;
+	// removed play handles whose last output is mixed in the current period,
+	// they are deleted at the start of the next one
+	PlayHandleList m_playHandlesToDelete;
 
 
 	struct qualitySettings m_qualitySettings;
 	float m_masterGain;
 
+	// pipelining stuff
+	bool m_pipelined;
+	int m_playHandleBufferIndex;
+	std::atomic_size_t m_pendingAudioPorts;
+
 	// audio device stuff
 	void doSetAudioDevice( AudioDevice *_dev );
 	AudioDevice * m_audioDev;
@@ -406,8 +450,9 @@ private:
 	QString m_midiClientName;
 
 	// FIFO stuff
-	Fifo * m_fifo;
+	PeriodRing * m_fifo;
 	fifoWriter * m_fifoWriter;
+	bool m_fifoReadPending;
 
 	AudioEngineProfiler m_profiler;
 
@@ -417,6 +462,7 @@ private:
 
 	friend class Engine;
 	friend class AudioEngineWorkerThread;
+	friend class AudioPort;
 	friend class ProjectRenderer;
 } ;
 
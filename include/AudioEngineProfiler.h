@@ -27,10 +27,14 @@
 
 #include <array>
 #include <atomic>
-#include <QFile>
+#include <cstdint>
+#include <vector>
+#include <QString>
 
+#include "AudioEngineTracer.h"
 #include "lmms_basics.h"
 #include "MicroTimer.h"
+#include "XrunForensics.h"
 
 namespace lmms
 {
@@ -39,21 +43,39 @@ class AudioEngineProfiler
 {
 public:
 	AudioEngineProfiler();
-	~AudioEngineProfiler() = default;
+	~AudioEngineProfiler();
 
 	void startPeriod()
 	{
 		m_periodTimer.reset();
+		m_periodBegin = AudioEngineTracer::Clock::now();
 	}
 
-	void finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod );
+	void finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod, std::size_t playHandles );
 
 	int cpuLoad() const
 	{
 		return m_cpuLoad;
 	}
 
-	void setOutputFile( const QString& outputFile );
+	//! Records a trace of the audio engine into \p outputFile, see AudioEngineTracer
+	bool setOutputFile( const QString& outputFile );
+
+	//! Logs the recent periods to \p logFile whenever one misses its deadline, see XrunForensics
+	bool setXrunLogFile( const QString& logFile )
+	{
+		return m_xrunForensics.setLogFile( logFile );
+	}
+
+	struct PluginLoad
+	{
+		QString name;
+		float load; // averaged share of the period budget, in percent
+		float peakLoad;
+	};
+
+	//! Loads of all instruments and effects, heaviest first - not realtime safe
+	static std::vector<PluginLoad> pluginLoads();
 
 	enum class DetailType {
 		NoteSetup,
@@ -70,12 +92,27 @@ public:
 		return m_detailLoad[static_cast<std::size_t>(type)].load(std::memory_order_relaxed);
 	}
 
+	//! Periods rendered since the last resetTotals()
+	std::uint64_t periodCount() const
+	{
+		return m_periodCount.load(std::memory_order_relaxed);
+	}
+
+	//! Time spent in a render stage since the last resetTotals(), in microseconds
+	std::uint64_t detailTotal(const DetailType type) const
+	{
+		return m_detailTotal[static_cast<std::size_t>(type)].load(std::memory_order_relaxed);
+	}
+
+	void resetTotals();
+
 	class Probe
 	{
 	public:
 		Probe(AudioEngineProfiler& profiler, AudioEngineProfiler::DetailType type)
 			: m_profiler(profiler)
 			, m_type(type)
+			, m_trace({AudioEngineTracer::Category::Stage, detailName(type)})
 		{
 			profiler.startDetail(type);
 		}
@@ -87,9 +124,12 @@ public:
 	private:
 		AudioEngineProfiler &m_profiler;
 		const AudioEngineProfiler::DetailType m_type;
+		AudioEngineTracer::Scope m_trace;
 	};
 
 private:
+	static const char* detailName(DetailType type);
+
 	void startDetail(const DetailType type) { m_detailTimer[static_cast<std::size_t>(type)].reset(); }
 	void finishDetail(const DetailType type)
 	{
@@ -97,13 +137,18 @@ private:
 	}
 
 	MicroTimer m_periodTimer;
+	AudioEngineTracer::Clock::time_point m_periodBegin;
 	std::atomic<float> m_cpuLoad;
-	QFile m_outputFile;
 
 	// Use arrays to avoid dynamic allocations in realtime code
 	std::array<MicroTimer, DetailCount> m_detailTimer;
 	std::array<int, DetailCount> m_detailTime{0};
 	std::array<std::atomic<float>, DetailCount> m_detailLoad{0};
+
+	std::atomic<std::uint64_t> m_periodCount{0};
+	std::array<std::atomic<std::uint64_t>, DetailCount> m_detailTotal{};
+
+	XrunForensics m_xrunForensics;
 };
 
 } // namespace lmms
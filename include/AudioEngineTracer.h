@@ -0,0 +1,137 @@
+/*
+ * AudioEngineTracer.h - realtime safe trace recorder for the audio engine
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_AUDIO_ENGINE_TRACER_H
+#define LMMS_AUDIO_ENGINE_TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "lmms_export.h"
+
+class QString;
+
+namespace lmms
+{
+
+/**
+	Records what the audio engine threads spend their time on and writes it
+	to a Chrome trace file (JSON), which chrome://tracing and Perfetto can open.
+
+	Recording is realtime safe: every thread writes its events into its own
+	preallocated lock-free ring, and a background thread drains the rings
+	into the file. Events that don't fit into a full ring are dropped and
+	counted.
+*/
+class LMMS_EXPORT AudioEngineTracer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class Category : std::uint8_t
+	{
+		Period,
+		Stage,
+		NotePlayHandle,
+		PlayHandle,
+		AudioPort,
+		MixerChannel,
+		Effect,
+		Job
+	};
+
+	//! What a traced piece of work belongs to
+	struct Tag
+	{
+		Category category = Category::Job;
+		//! Static name, e.g. of a render stage or plugin
+		const char* name = nullptr;
+		//! Object whose label (see setLabel()) names the event, e.g. the AudioPort of a track
+		const void* owner = nullptr;
+		//! Mixer channel the work feeds, or -1
+		int channel = -1;
+	};
+
+	//! Starts recording into \p outputFile, replacing a running trace - returns false if the file can't be written
+	static bool start( const QString& outputFile );
+	//! Stops recording and finishes the file
+	static void stop();
+
+	static bool isEnabled()
+	{
+		return s_enabled.load( std::memory_order_relaxed );
+	}
+
+	//! Adds an event to the calling thread's ring
+	static void record( const Tag& tag, Clock::time_point begin, Clock::time_point end );
+
+	//! Names the calling thread in the trace - \p name must be a static string
+	static void setThreadName( const char* name );
+
+	//! Sets the label used for events owned by \p owner, not realtime safe
+	static void setLabel( const void* owner, const QString& label );
+	static void removeLabel( const void* owner );
+	static QString label( const void* owner );
+
+	static const char* categoryName( Category category );
+
+	//! Records the time between its construction and destruction, if tracing was enabled when constructed
+	class Scope
+	{
+	public:
+		explicit Scope( const Tag& tag ) :
+			m_tag( tag ),
+			m_active( isEnabled() )
+		{
+			if( m_active )
+			{
+				m_begin = Clock::now();
+			}
+		}
+
+		~Scope()
+		{
+			if( m_active )
+			{
+				record( m_tag, m_begin, Clock::now() );
+			}
+		}
+
+		Scope( const Scope& ) = delete;
+		Scope& operator=( const Scope& ) = delete;
+
+	private:
+		const Tag m_tag;
+		const bool m_active;
+		Clock::time_point m_begin;
+	};
+
+private:
+	static std::atomic_bool s_enabled;
+};
+
+} // namespace lmms
+
+#endif // LMMS_AUDIO_ENGINE_TRACER_H
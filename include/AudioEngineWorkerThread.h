@@ -28,8 +28,7 @@
 #include <QThread>
 
 #include <atomic>
-
-class QWaitCondition;
+#include <cstdint>
 
 namespace lmms
 {
@@ -41,39 +40,81 @@ class AudioEngineWorkerThread : public QThread
 {
 	Q_OBJECT
 public:
-	// internal representation of the job queue - all functions are thread-safe
-	class JobQueue
+	//! Bounded work-stealing deque (Chase-Lev). push() and pop() may only be
+	//! called by the owning worker, steal() may be called from any thread.
+	class JobDeque
 	{
 	public:
-		enum class OperationMode
+		static constexpr std::int64_t CAPACITY = 4096;
+
+		JobDeque() :
+			m_items(),
+			m_top(0),
+			m_bottom(0)
 		{
-			Static,	// no jobs added while processing queue
-			Dynamic	// jobs can be added while processing queue
-		} ;
+			std::fill(m_items, m_items + CAPACITY, nullptr);
+		}
 
+		//! Returns false if the deque is full
+		bool push(ThreadableJob* job);
+		ThreadableJob* pop();
+		ThreadableJob* steal();
+
+	private:
+		static constexpr std::int64_t MASK = CAPACITY - 1;
+		static_assert((CAPACITY & MASK) == 0, "CAPACITY must be a power of two");
+
+		std::atomic<ThreadableJob*> m_items[CAPACITY];
+		alignas(64) std::atomic<std::int64_t> m_top;
+		alignas(64) std::atomic<std::int64_t> m_bottom;
+	} ;
+
+	// internal representation of the job queue - all functions are thread-safe
+	//
+	// Jobs added from outside a worker (e.g. when filling the queue for a
+	// render stage) go into a shared injection queue. Jobs added from within a
+	// running job (e.g. mixer channels whose dependencies are met) are pushed
+	// onto the calling worker's own deque. Idle workers steal from each other.
+	class JobQueue
+	{
+	public:
 		static constexpr size_t JOB_QUEUE_SIZE = 8192;
 
 		JobQueue() :
 			m_items(),
-			m_writeIndex( 0 ),
-			m_itemsDone( 0 ),
-			m_opMode( OperationMode::Static )
+			m_writeIndex(0),
+			m_readIndex(0),
+			m_pending(0),
+			m_sleepers(0)
 		{
 			std::fill(m_items, m_items + JOB_QUEUE_SIZE, nullptr);
 		}
 
-		void reset( OperationMode _opMode );
-
 		void addJob( ThreadableJob * _job );
 
-		void run();
-		void wait();
+		//! Process jobs until all queued jobs (including the ones queued
+		//! while processing) are done
+		void run( AudioEngineWorkerThread * worker );
+
+		bool hasPendingJobs() const
+		{
+			return m_pending.load() > 0;
+		}
 
 	private:
+		void push(ThreadableJob* job);
+		ThreadableJob* take();
+		ThreadableJob* steal(AudioEngineWorkerThread* thief);
+		void jobDone();
+		void backoff(unsigned int idleRounds);
+
 		std::atomic<ThreadableJob*> m_items[JOB_QUEUE_SIZE];
-		std::atomic_size_t m_writeIndex;
-		std::atomic_size_t m_itemsDone;
-		OperationMode m_opMode;
+		// both indices only ever grow so stale readers can't take a slot twice
+		alignas(64) std::atomic<std::uint64_t> m_writeIndex;
+		alignas(64) std::atomic<std::uint64_t> m_readIndex;
+		// number of jobs queued but not yet processed
+		alignas(64) std::atomic<std::int64_t> m_pending;
+		std::atomic_int m_sleepers;
 	} ;
 
 
@@ -82,12 +123,6 @@ public:
 
 	virtual void quit();
 
-	static void resetJobQueue( JobQueue::OperationMode _opMode =
-													JobQueue::OperationMode::Static )
-	{
-		globalJobQueue.reset( _opMode );
-	}
-
 	static void addJob( ThreadableJob * _job )
 	{
 		globalJobQueue.addJob( _job );
@@ -96,27 +131,29 @@ public:
 	// a convenient helper function allowing to pass a container with pointers
 	// to ThreadableJob objects
 	template<typename T>
-	static void fillJobQueue( const T & _vec,
-							JobQueue::OperationMode _opMode = JobQueue::OperationMode::Static )
+	static void fillJobQueue( const T & _vec )
 	{
-		resetJobQueue( _opMode );
 		for (const auto& job : _vec)
 		{
 			addJob(job);
 		}
 	}
 
+	//! Wake up all workers and process the queue until it is empty. Jobs may
+	//! be added while processing, e.g. successors in a dependency graph.
 	static void startAndWaitForJobs();
 
 
 private:
 	void run() override;
 
+	JobDeque m_deque;
+
 	static JobQueue globalJobQueue;
-	static QWaitCondition * queueReadyWaitCond;
+	static std::atomic<std::uint64_t> s_generation;
 	static QList<AudioEngineWorkerThread *> workerThreads;
 
-	volatile bool m_quit;
+	std::atomic_bool m_quit;
 } ;
 
 } // namespace lmms
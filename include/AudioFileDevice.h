@@ -49,6 +49,13 @@ public:
 
 	OutputSettings const & getOutputSettings() const { return m_outputSettings; }
 
+	//! Encode the given frames directly, for writers that don't pull their
+	//! periods from the audio engine
+	void writeFrames(const SampleFrame* buffer, const fpp_t frames)
+	{
+		writeBuffer(buffer, frames);
+	}
+
 
 protected:
 	int writeData( const void* data, int len );
@@ -34,6 +34,7 @@
 #include <weak_libjack.h>
 #endif
 
+#include <QTimer>
 #include <atomic>
 #include <vector>
 
@@ -87,6 +88,7 @@ public:
 
 private slots:
 	void restartAfterZombified();
+	void updateLatency();
 
 private:
 	bool initJackClient();
@@ -100,7 +102,10 @@ private:
 
 	int processCallback(jack_nframes_t nframes);
 
+	void latencyCallback(jack_latency_callback_mode_t mode);
+
 	static int staticProcessCallback(jack_nframes_t nframes, void* udata);
+	static void staticLatencyCallback(jack_latency_callback_mode_t mode, void* udata);
 	static void shutdownCallback(void* _udata);
 
 	jack_client_t* m_client;
@@ -111,11 +116,15 @@ private:
 	std::atomic<MidiJack*> m_midiClient;
 	std::vector<jack_port_t*> m_outputPorts;
 	jack_default_audio_sample_t** m_tempOutBufs;
-	SampleFrame* m_outBuf;
+	const SampleFrame* m_outBuf;
 
 	f_cnt_t m_framesDoneInCurBuf;
 	f_cnt_t m_framesToDoInCurBuf;
 
+	//! processing latency JACK was last told about, polled by m_latencyTimer
+	f_cnt_t m_reportedLatency;
+	QTimer m_latencyTimer;
+
 #ifdef AUDIO_PORT_SUPPORT
 	struct StereoPort
 	{
@@ -29,6 +29,8 @@
 #include <QString>
 #include <QMutex>
 
+#include "CompensationDelay.h"
+#include "CpuTimeCounter.h"
 #include "PlayHandle.h"
 
 namespace lmms
@@ -37,6 +39,7 @@ namespace lmms
 class EffectChain;
 class FloatModel;
 class BoolModel;
+class PeriodRing;
 
 class AudioPort : public ThreadableJob
 {
@@ -96,20 +99,51 @@ public:
 
 	void setName( const QString & _new_name );
 
+	//! Copy each processed period into @p tap (nullptr to stop)
+	void setStemTap( PeriodRing * tap )
+	{
+		m_stemTap = tap;
+	}
+
 
 	bool processEffects();
 
+	//! Latency of the port's effects, in frames
+	f_cnt_t latency() const;
+
+	//! Delay the output to line it up with other inputs of the mixer channel
+	void setCompensationDelay( f_cnt_t frames )
+	{
+		m_compensation.setDelay( frames );
+	}
+
 	// ThreadableJob stuff
 	void doProcessing() override;
 	bool requiresProcessing() const override
 	{
 		return true;
 	}
+	AudioEngineTracer::Tag traceTag() const override
+	{
+		return { AudioEngineTracer::Category::AudioPort, nullptr, this, m_nextMixerChannel };
+	}
+	CpuTimeCounter* cpuTimeCounter() override
+	{
+		return &m_cpuTime;
+	}
+
+	//! Time spent mixing the port's play handles and running its effects
+	const CpuTimeCounter& cpuTime() const
+	{
+		return m_cpuTime;
+	}
 
 	void addPlayHandle( PlayHandle * handle );
 	void removePlayHandle( PlayHandle * handle );
 
 private:
+	void writeStemTap( bool silent );
+
 	volatile bool m_bufferUsage;
 
 	SampleFrame* m_portBuffer;
@@ -129,6 +163,12 @@ private:
 	FloatModel * m_panningModel;
 	BoolModel * m_mutedModel;
 
+	PeriodRing * m_stemTap;
+
+	CompensationDelay m_compensation;
+
+	CpuTimeCounter m_cpuTime;
+
 	friend class AudioEngine;
 	friend class AudioEngineWorkerThread;
 
@@ -1,5 +1,5 @@
 /*
- * AudioResampler.h - wrapper around libsamplerate
+ * AudioResampler.h - lightweight streaming resampler
  *
  * Copyright (c) 2023 saker <sakertooth@gmail.com>
  *
@@ -25,12 +25,27 @@
 #ifndef LMMS_AUDIO_RESAMPLER_H
 #define LMMS_AUDIO_RESAMPLER_H
 
+#include <array>
 #include <samplerate.h>
 
 #include "lmms_export.h"
 
 namespace lmms {
 
+//! Streaming resampler with a small, allocation-free state, meant to be used
+//! once per voice.
+//!
+//! The interpolation mode is given as a libsamplerate converter type, so the
+//! existing quality settings can be passed on unchanged:
+//! SRC_ZERO_ORDER_HOLD and SRC_LINEAR are what their names say,
+//! SRC_SINC_FASTEST uses cubic Hermite interpolation, SRC_SINC_MEDIUM_QUALITY
+//! and SRC_SINC_BEST_QUALITY use a 16 and 32 tap Kaiser-windowed sinc. The
+//! sinc kernels are band limited to the lower of both rates.
+//!
+//! When upsampling, the sinc coefficients come from a polyphase filter bank
+//! which is shared by all resamplers of the same quality. When downsampling,
+//! the cutoff follows the ratio, which changes with every pitch bend, so the
+//! coefficients are computed from lookup tables for each output frame instead.
 class LMMS_EXPORT AudioResampler
 {
 public:
@@ -41,24 +56,63 @@ public:
 		long outputFramesGenerated;
 	};
 
+	static constexpr int MaxTaps = 32;
+
+	//! Dot product of a window of coefficients with both channels
+	using DotProduct = void (*)(const float* coeffs, const float* left, const float* right, int taps,
+		float& outLeft, float& outRight);
+
 	AudioResampler(int interpolationMode, int channels);
 	AudioResampler(const AudioResampler&) = delete;
 	AudioResampler(AudioResampler&&) = delete;
-	~AudioResampler();
+	~AudioResampler() = default;
 
 	AudioResampler& operator=(const AudioResampler&) = delete;
 	AudioResampler& operator=(AudioResampler&&) = delete;
 
+	//! Resample interleaved frames. Input is only consumed as far as it is
+	//! needed for the requested output, the first call consumes some frames
+	//! ahead to fill the interpolation window.
 	auto resample(const float* in, long inputFrames, float* out, long outputFrames, double ratio) -> ProcessResult;
 	auto interpolationMode() const -> int { return m_interpolationMode; }
 	auto channels() const -> int { return m_channels; }
-	void setRatio(double ratio);
+	//! The ratio is passed to every resample() call, so there is nothing to do here
+	void setRatio(double) {}
+	//! Forget all buffered input, as if the resampler was just created
+	void reset();
 
 private:
+	enum class Kernel
+	{
+		Hold,
+		Linear,
+		Cubic,
+		Sinc
+	};
+
+	struct FilterBank;
+
+	void push(float left, float right);
+	void interpolate(float position, float cutoff, DotProduct dotProduct, float& left, float& right) const;
+
 	int m_interpolationMode = -1;
 	int m_channels = 0;
-	int m_error = 0;
-	SRC_STATE* m_state = nullptr;
+	Kernel m_kernel = Kernel::Linear;
+	int m_taps = 2;
+	float m_rolloff = 1.0f;
+	//! coefficients for ratios of 1 and above, only used by the sinc kernel
+	const FilterBank* m_filterBank = nullptr;
+
+	//! position of the next output frame in input frames, relative to the
+	//! frame before the middle of the window; at 1 or above, input has to be
+	//! consumed first
+	double m_position = 0;
+	int m_writePos = 0;
+
+	// the window is stored twice so it can always be read contiguously
+	// starting at m_writePos
+	alignas(32) std::array<float, 2 * MaxTaps> m_left = {};
+	alignas(32) std::array<float, 2 * MaxTaps> m_right = {};
 };
 } // namespace lmms
 
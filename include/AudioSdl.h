@@ -84,7 +84,7 @@ private:
 
 	SDL_AudioSpec m_audioHandle;
 
-	SampleFrame* m_outBuf;
+	const SampleFrame* m_outBuf;
 
 	size_t m_currentBufferFramePos;
 	size_t m_currentBufferFramesCount;
@@ -25,7 +25,10 @@
 #ifndef LMMS_AUTOMATABLE_MODEL_H
 #define LMMS_AUTOMATABLE_MODEL_H
 
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <vector>
 #include <QMap>
 #include <QMutex>
 #include <QRegularExpression>
@@ -151,29 +154,22 @@ public:
 	template<class T>
 	inline T value( int frameOffset = 0 ) const
 	{
-		if (m_controllerConnection)
+		if (s_pipelined)
 		{
-			if (!m_useControllerValue)
-			{
-				return castValue<T>(m_value);
-			}
-			else
-			{
-				return castValue<T>(controllerValue(frameOffset));
-			}
+			return castValue<T>(pipelinedValue(frameOffset));
 		}
-		else if (hasLinkedModels())
-		{
-			return castValue<T>( controllerValue( frameOffset ) );
-		}
-
-		return castValue<T>( m_value );
+		return castValue<T>(currentValue(frameOffset));
 	}
 
 	float controllerValue( int frameOffset ) const;
 
+	//! the value in the period this thread processes, see PreviousPeriodScope
+	float pipelinedValue( int frameOffset ) const;
+
 	//! @brief Function that returns sample-exact data as a ValueBuffer
 	//! @return pointer to model's valueBuffer when s.ex.data exists, NULL otherwise
+	//! The buffer is filled by updateValueBuffers() at the start of each period,
+	//! so this never blocks.
 	ValueBuffer * valueBuffer();
 
 	template<class T>
@@ -213,6 +209,10 @@ public:
 	void setInitValue( const float value );
 
 	void setAutomatedValue( const float value );
+	//! @brief Sets sample-exact automation for the frames [offset, offset + frames)
+	//! of the current period, taking values in the same range as setAutomatedValue().
+	//! The rest of the period holds the last value until the next block is set.
+	void setAutomatedValueBlock( const float* values, f_cnt_t offset, f_cnt_t frames );
 	void setValue( const float value );
 
 	void incValue( int steps )
@@ -302,16 +302,55 @@ public:
 		m_hasStrictStepSize = b;
 	}
 
+	//! Only called by the audio thread, other threads read the counter to
+	//! find out which periods the audio thread has finished
 	static void incrementPeriodCounter()
 	{
-		++s_periodCounter;
+		s_periodCounter.fetch_add( 1, std::memory_order_release );
 	}
 
 	static void resetPeriodCounter()
 	{
-		s_periodCounter = 0;
+		s_periodCounter.store( 0, std::memory_order_release );
 	}
 
+	static long periodCounter()
+	{
+		return s_periodCounter.load( std::memory_order_acquire );
+	}
+
+	//! Fills the value buffers of all models which are controlled, linked or
+	//! whose value changed since the last period. Called once per period by
+	//! the audio engine before any instrument or effect is processed.
+	static void updateValueBuffers();
+
+	//! In pipelined mode the audio ports and mixer channels process the
+	//! period before the one whose instruments are rendered, so models keep
+	//! the value buffers of both periods. A period sees what the model held
+	//! when updateValueBuffers() ran for it: every write, be it from the GUI,
+	//! MIDI, automation or a linked model, keeps the old value for readers of
+	//! the previous period, and controlled models are updated every period.
+	//! Reading the value costs a check of this flag on top.
+	static void setPipelined( bool pipelined )
+	{
+		s_pipelined = pipelined;
+	}
+
+	//! While alive, value() and valueBuffer() on this thread return what the
+	//! model held in the previous period, as long as the engine is pipelined
+	class LMMS_EXPORT PreviousPeriodScope
+	{
+	public:
+		PreviousPeriodScope();
+		~PreviousPeriodScope();
+
+		PreviousPeriodScope( const PreviousPeriodScope& ) = delete;
+		PreviousPeriodScope& operator=( const PreviousPeriodScope& ) = delete;
+
+	private:
+		bool m_wasPrevious;
+	};
+
 	bool useControllerValue()
 	{
 		return m_useControllerValue;
@@ -379,6 +418,34 @@ private:
 	//! @param value will be modified to rounded value
 	template<class T> void roundAt( T &value, const T &where ) const;
 
+	//! value() as seen in the period being set up
+	float currentValue( int frameOffset ) const
+	{
+		if (m_controllerConnection)
+		{
+			return m_useControllerValue ? controllerValue(frameOffset) : m_value;
+		}
+		else if (hasLinkedModels())
+		{
+			return controllerValue( frameOffset );
+		}
+
+		return m_value;
+	}
+
+	//! computes the value buffer for the current period if not done yet
+	void updateValueBuffer();
+	//! remembers the value before the first write since the last update, so
+	//! readers of the previous period don't see writes made for this one
+	void holdValueForPreviousPeriod();
+	//! stamps the previous period with what it held unless it has been
+	//! computed, so readers of that period don't see what is set up for this one
+	void holdPreviousPeriod();
+	//! makes the next updateValueBuffers() recompute this model
+	void queueValueBufferUpdate();
+	//! adds/removes this model to/from the list of controlled models
+	void updateControlRegistration();
+
 
 	ScaleType m_scaleType; //!< scale type, linear by default
 	float m_value;
@@ -406,14 +473,30 @@ private:
 	ControllerConnection* m_controllerConnection;
 
 
-	ValueBuffer m_valueBuffer;
-	long m_lastUpdatedPeriod;
-	static long s_periodCounter;
-
-	bool m_hasSampleExactData;
-
-	// prevent several threads from attempting to write the same vb at the same time
-	QMutex m_valueBufferMutex;
+	//! value buffers of the current and the previous period, indexed by the
+	//! parity of the period they were computed in
+	std::array<ValueBuffer, 2> m_valueBuffers;
+	std::array<long, 2> m_lastUpdatedPeriods;
+	std::array<bool, 2> m_hasSampleExactData;
+	//! what value() returned in the period, for readers of the previous one
+	std::array<float, 2> m_periodValues;
+	//! value before the first setValue()/setAutomatedValue() since the last
+	//! update, valid while m_hasHeldValue is set
+	float m_heldValue;
+	std::atomic<bool> m_hasHeldValue;
+	static std::atomic<long> s_periodCounter;
+	static bool s_pipelined;
+
+	//! whether this model is in s_controlledModels
+	bool m_isControlled;
+	//! whether this model is in the s_queuedModels list
+	std::atomic<bool> m_valueBufferQueued;
+	AutomatableModel* m_nextQueued;
+
+	//! models with a controller connection or linked models, guarded by the audio engine's change mutex
+	static std::vector<AutomatableModel*> s_controlledModels;
+	//! head of the lock-free list of models whose value changed
+	static std::atomic<AutomatableModel*> s_queuedModels;
 
 	bool m_useControllerValue;
 
@@ -29,6 +29,9 @@
 
 #include <QMap>
 #include <QPointer>
+#include <atomic>
+#include <utility>
+#include <vector>
 #if (QT_VERSION >= QT_VERSION_CHECK(5,14,0))
 	#include <QRecursiveMutex>
 #endif
@@ -67,9 +70,34 @@ public:
 
 	using TimemapIterator = timeMap::const_iterator;
 
+	//! Immutable copy of the nodes and curve settings. The audio thread reads
+	//! the current snapshot without locking, edits publish a new one.
+	struct Snapshot
+	{
+		struct Node
+		{
+			int pos;
+			float inValue;
+			float outValue;
+			float inTangent;
+			float outTangent;
+		};
+
+		std::vector<Node> nodes;
+		ProgressionType progressionType;
+		float tension;
+
+		float valueAt(float time) const;
+		//! Values for frames at time, time + step, ..., holding the value at end
+		void fill(float time, float step, float end, int frames, float* out) const;
+		//! Value between two consecutive nodes, offset being the distance to the first one
+		static float segmentValue(const Node& node, const Node& next, float offset,
+			ProgressionType progressionType, float tension);
+	};
+
 	AutomationClip( AutomationTrack * _auto_track );
 	AutomationClip( const AutomationClip & _clip_to_copy );
-	~AutomationClip() override = default;
+	~AutomationClip() override;
 
 	bool addObject( AutomatableModel * _obj, bool _search_dup = true );
 
@@ -170,9 +198,20 @@ public:
 		return supportsTangentEditing(m_progressionType);
 	}
 
+	//! Lock-free, safe to call from the audio thread
 	float valueAt( const TimePos & _time ) const;
 	float *valuesAfter( const TimePos & _time ) const;
 
+	//! Render one value per frame at the current tempo, starting at the given
+	//! (fractional) tick relative to the clip start. Past the end of clips that
+	//! don't auto-resize, the value at the end is held like during playback.
+	//! Lock-free, safe to call from the audio thread.
+	void fillBlock(float time, fpp_t frames, float* out) const;
+
+	//! Publish the nodes to the audio thread; only needed after changing
+	//! nodes through getTimeMap() directly
+	void updateSnapshot();
+
 	QString name() const;
 
 	// settings-management
@@ -191,7 +230,7 @@ public:
 	static void resolveAllIDs();
 
 	bool isRecording() const { return m_isRecording; }
-	void setRecording( const bool b ) { m_isRecording = b; }
+	void setRecording( const bool b );
 
 	static int quantization() { return s_quantization; }
 	static void setQuantization(int q) { s_quantization = q; }
@@ -208,6 +247,7 @@ private:
 	void generateTangents();
 	void generateTangents(timeMap::iterator it, int numToGenerate);
 	float valueAt( timeMap::const_iterator v, int offset ) const;
+	float timeMapValueAt( const TimePos & _time ) const;
 
 	/**
 	 * @brief
@@ -218,6 +258,9 @@ private:
 	 */
 	static std::vector<Track*> combineAllTracks();
 
+	//! Frees @p snapshot once the audio thread can't be reading it anymore
+	static void retireSnapshot(const Snapshot* snapshot);
+
 	// Mutex to make methods involving automation clips thread safe
 	// Mutable so we can lock it from const objects
 #if (QT_VERSION >= QT_VERSION_CHECK(5,14,0))
@@ -245,6 +288,8 @@ private:
 	bool m_isRecording;
 	float m_lastRecordedValue;
 
+	std::atomic<const Snapshot*> m_snapshot = nullptr;
+
 	static int s_quantization;
 
 	static const float DEFAULT_MIN_VALUE;
@@ -0,0 +1,144 @@
+/*
+ * AutomationTimeline.h - incrementally evaluated index of the song's automation
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_AUTOMATION_TIMELINE_H
+#define LMMS_AUTOMATION_TIMELINE_H
+
+#include <QHash>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "AutomatableModel.h"
+#include "TimePos.h"
+#include "lmms_export.h"
+
+namespace lmms {
+
+class AutomationClip;
+class Clip;
+class Song;
+class Track;
+
+//! Index of the automation and pattern clips of a song, sorted by start position.
+//!
+//! valuesAt() yields the same result as
+//! TrackContainer::automatedValuesFromTracks() for the song's tracks, but
+//! keeps a cursor into the index while time moves forward. Clips whose models
+//! are all overridden by later clips are dropped from evaluation, so the cost
+//! per tick depends on the number of clips that still matter instead of on
+//! every clip before the playhead. Going back in time rewinds the cursor.
+//!
+//! The index is rebuilt lazily after invalidate(), which has to be called when
+//! tracks are added, removed, reordered or (un)muted. Changes to single clips
+//! are reported with clipChanged() and clipRemoved() instead, which only update
+//! the entry of that clip.
+class LMMS_EXPORT AutomationTimeline
+{
+public:
+	explicit AutomationTimeline(Song* song);
+
+	//! Marks the index of every timeline as outdated, safe to call from any thread
+	static void invalidate();
+
+	//! Updates the entry of \p clip after it was added to its track, moved,
+	//! resized, (un)muted or got new models, safe to call from any thread.
+	//! Clips that are not on one of the song's automation or pattern tracks are
+	//! ignored.
+	static void clipChanged(Clip* clip);
+	//! Drops the entry of \p clip after it was removed from its track, \p clip
+	//! may be destroyed right after
+	static void clipRemoved(Clip* clip);
+
+	auto valuesAt(TimePos time) -> AutomatedValueMap;
+
+	//! Clips on regular automation tracks that are playing at the time last
+	//! passed to valuesAt(), regardless of whether they are muted
+	auto playingClips() const -> const std::vector<AutomationClip*>& { return m_playingClips; }
+
+	//! Number of clips that were evaluated by the last call to valuesAt()
+	auto liveClips() const -> std::size_t { return m_live.size(); }
+
+	//! The clip that decided the value of each model in the last call to
+	//! valuesAt(), for models automated by song clips directly (not through a
+	//! pattern)
+	auto sources() const -> const std::vector<std::pair<AutomatableModel*, const AutomationClip*>>&
+	{
+		return m_sources;
+	}
+
+private:
+	struct Entry
+	{
+		Clip* clip;
+		int start;
+		int end;
+		//! position of the clip's track, the global automation track comes first
+		int trackIndex;
+		AutomationClip* automation;
+		Track* pattern;
+		bool muted;
+		bool recordable;
+		//! hasAutomation() of the clip when it was passed by the cursor
+		bool automated = false;
+		//! number of models this clip is the latest automation for
+		int owned = 0;
+	};
+
+	static auto isIndexed(const Clip* clip) -> bool;
+	static auto entryFor(Clip* clip, int trackIndex) -> Entry;
+
+	void rebuild();
+	void applyClipChanges();
+	void rewind();
+	void advance(int time);
+	auto evaluate(int time, AutomatedValueMap& values) -> bool;
+
+	static std::atomic<unsigned> s_generation;
+
+	//! clips reported by clipChanged() and clipRemoved() since the last call to valuesAt()
+	static std::mutex s_clipChangesMutex;
+	static std::vector<Clip*> s_changedClips;
+	static std::vector<Clip*> s_removedClips;
+
+	Song* m_song;
+	unsigned m_generation;
+	std::vector<Entry> m_entries;
+
+	//! entries before the cursor start at or before m_time
+	std::size_t m_cursor = 0;
+	int m_time = -1;
+	//! indices of the passed entries that are not overridden by later ones, in order
+	std::vector<std::size_t> m_live;
+	QHash<const AutomatableModel*, std::size_t> m_modelOwners;
+	QHash<const Track*, std::size_t> m_patternOwners;
+	std::vector<AutomationClip*> m_playingClips;
+	QHash<AutomatableModel*, const AutomationClip*> m_sourceMap;
+	std::vector<std::pair<AutomatableModel*, const AutomationClip*>> m_sources;
+};
+
+} // namespace lmms
+
+#endif // LMMS_AUTOMATION_TIMELINE_H
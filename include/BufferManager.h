@@ -26,21 +26,41 @@
 #ifndef LMMS_BUFFER_MANAGER_H
 #define LMMS_BUFFER_MANAGER_H
 
+#include <cstddef>
+
 #include "lmms_export.h"
 #include "lmms_basics.h"
+#include "LocklessPool.h"
 
 namespace lmms
 {
 
 class SampleFrame;
 
+//! Hands out zeroed buffers of one period from a lock-free pool. Each thread
+//! keeps a small magazine of buffers, so acquire() and release() usually
+//! don't even touch the shared pool. Both are safe to call from the audio
+//! threads. acquire() only returns nullptr if the system is out of memory.
 class LMMS_EXPORT BufferManager
 {
 public:
+	using Statistics = LocklessPool::Statistics;
+
+	//! Rough number of buffers a track needs while playing, used to pre-size
+	//! the pool when loading projects
+	static constexpr std::size_t BuffersPerTrack = 16;
+
 	static void init( fpp_t fpp );
 	static SampleFrame* acquire();
 	static void release( SampleFrame* buf );
 
+	//! Grow the pool to at least @p count buffers. Don't call this from the
+	//! audio threads.
+	static void reserve(std::size_t count);
+
+	//! Statistics of the shared pool. Buffers in the magazines count as used.
+	static Statistics statistics();
+
 private:
 	static fpp_t s_framesPerPeriod;
 };
@@ -49,6 +49,7 @@ public:
 
 protected:
 	void paintEvent( QPaintEvent * _ev ) override;
+	void contextMenuEvent( QContextMenuEvent * _ev ) override;
 
 
 protected slots:
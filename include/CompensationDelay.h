@@ -0,0 +1,94 @@
+/*
+ * CompensationDelay.h - delay line lining up paths with different latencies
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_COMPENSATION_DELAY_H
+#define LMMS_COMPENSATION_DELAY_H
+
+#include <vector>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+#include "SampleFrame.h"
+
+namespace lmms
+{
+
+/**
+ * Delays a signal by a whole number of frames, so it arrives together with
+ * signals which went through effects with more latency.
+ *
+ * The delay can be changed from the audio thread without allocating: the
+ * line is sized for MaxDelay up front. The signal already in the line is
+ * kept and the output crossfades from the old to the new delay.
+ */
+class LMMS_EXPORT CompensationDelay
+{
+public:
+	//! Longest delay in frames, larger ones are clamped (Mixer::updateLatencies() warns about them)
+	static constexpr f_cnt_t MaxDelay = 8192;
+	//! Length of the crossfade after the delay changed
+	static constexpr f_cnt_t FadeFrames = 64;
+
+	CompensationDelay();
+
+	f_cnt_t delay() const
+	{
+		return m_delay;
+	}
+
+	//! Changes the delay, crossfading from the old one
+	void setDelay( f_cnt_t frames );
+
+	//! Delays @p src into @p dst, which may be the same buffer
+	void process( const SampleFrame* src, SampleFrame* dst, fpp_t frames );
+
+	//! Writes the rest of the delayed signal to @p dst after the input
+	//! went silent
+	void drain( SampleFrame* dst, fpp_t frames );
+
+	//! Whether the line still holds signal which drain() has to output
+	bool hasPendingOutput() const
+	{
+		return m_pending > 0;
+	}
+
+	void clear();
+
+private:
+	//! Writes one input frame and returns the delayed output
+	SampleFrame tick( const SampleFrame& in );
+	f_cnt_t readPosition( f_cnt_t delay ) const;
+
+	std::vector<SampleFrame> m_buffer;
+	f_cnt_t m_delay = 0;
+	f_cnt_t m_writePosition = 0;
+	f_cnt_t m_pending = 0;
+	//! delay faded out after setDelay() and the frames left of the crossfade
+	f_cnt_t m_fadeDelay = 0;
+	f_cnt_t m_fadeRemaining = 0;
+} ;
+
+} // namespace lmms
+
+#endif // LMMS_COMPENSATION_DELAY_H
@@ -199,6 +199,12 @@ public:
 		return m_backgroundPicFile;
 	}
 
+	//! the file the configuration was loaded from and is saved to
+	const QString & configFile() const
+	{
+		return m_lmmsRcFile;
+	}
+
 	QString trackIconsDir() const
 	{
 		return m_dataDir + TRACK_ICON_PATH;
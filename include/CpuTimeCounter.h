@@ -0,0 +1,109 @@
+/*
+ * CpuTimeCounter.h - processing time accounting for tracks, plugins and mixer channels
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_CPU_TIME_COUNTER_H
+#define LMMS_CPU_TIME_COUNTER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+	Counts the time the audio engine spends processing one instrument, effect,
+	audio port or mixer channel.
+
+	Threads add to the counter lock-free while processing. Once per period,
+	AudioEngineProfiler turns what was added into a share of the period's time
+	budget, which anyone can read with load() and peakLoad().
+*/
+class LMMS_EXPORT CpuTimeCounter
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	CpuTimeCounter();
+	~CpuTimeCounter();
+
+	CpuTimeCounter( const CpuTimeCounter& ) = delete;
+	CpuTimeCounter& operator=( const CpuTimeCounter& ) = delete;
+
+	void add( Clock::duration time )
+	{
+		m_periodTime.fetch_add( std::chrono::duration_cast<std::chrono::nanoseconds>( time ).count(),
+			std::memory_order_relaxed );
+	}
+
+	//! Averaged share of the period budget, in percent
+	float load() const
+	{
+		return m_load.load( std::memory_order_relaxed );
+	}
+
+	//! Highest share of the period budget a single period took, in percent. Falls
+	//! by half each second, so it shows recent spikes.
+	float peakLoad() const
+	{
+		return m_peakLoad.load( std::memory_order_relaxed );
+	}
+
+	//! Adds the time between its construction and destruction to a counter
+	class Scope
+	{
+	public:
+		explicit Scope( CpuTimeCounter& counter ) :
+			m_counter( counter ),
+			m_begin( Clock::now() )
+		{
+		}
+
+		~Scope()
+		{
+			m_counter.add( Clock::now() - m_begin );
+		}
+
+		Scope( const Scope& ) = delete;
+		Scope& operator=( const Scope& ) = delete;
+
+	private:
+		CpuTimeCounter& m_counter;
+		const Clock::time_point m_begin;
+	};
+
+	//! Updates the loads of all counters, called by AudioEngineProfiler at the end of each period
+	static void finishPeriod( std::int64_t periodBudgetNs );
+
+private:
+	std::atomic<std::int64_t> m_periodTime = 0;
+	std::atomic<float> m_load = 0.f;
+	std::atomic<float> m_peakLoad = 0.f;
+};
+
+} // namespace lmms
+
+#endif // LMMS_CPU_TIME_COUNTER_H
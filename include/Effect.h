@@ -30,6 +30,7 @@
 #include "Engine.h"
 #include "AudioEngine.h"
 #include "AutomatableModel.h"
+#include "CpuTimeCounter.h"
 #include "TempoSyncKnobModel.h"
 
 namespace lmms
@@ -160,6 +161,13 @@ public:
 		return &m_autoQuitModel;
 	}
 
+	//! Returns by how many frames the effect delays the signal, e.g. for
+	//! lookahead. The mixer delays parallel paths by the same amount.
+	virtual f_cnt_t latency() const
+	{
+		return 0;
+	}
+
 	EffectChain * effectChain() const
 	{
 		return m_parent;
@@ -220,6 +228,12 @@ protected:
 			Engine::audioEngine()->framesPerPeriod() * _src_sr /
 				Engine::audioEngine()->outputSampleRate() );
 	}
+	//! Time spent in processAudioBuffer()
+	CpuTimeCounter& cpuTime()
+	{
+		return m_cpuTime;
+	}
+
 	void reinitSRC();
 
 	virtual void onEnabledChanged() {}
@@ -254,6 +268,8 @@ private:
 	
 	bool m_autoQuitDisabled;
 
+	CpuTimeCounter m_cpuTime;
+
 	SRC_DATA m_srcData[2];
 	SRC_STATE * m_srcState[2];
 
@@ -66,6 +66,17 @@ public:
 	bool processAudioBuffer( SampleFrame* _buf, const fpp_t _frames, bool hasInputNoise );
 	void startRunning();
 
+	//! Whether any effect still produces output (e.g. a reverb tail) without getting input
+	bool isRunning() const;
+
+	//! Sum of the latencies of all enabled effects, in frames
+	f_cnt_t latency() const;
+
+	const std::vector<Effect*>& effects() const
+	{
+		return m_effects;
+	}
+
 	void clear();
 
 
@@ -126,6 +126,7 @@ protected slots:
 	void saveSettingsBtnClicked();
 	void viewNextInstrument();
 	void viewPrevInstrument();
+	void updateCpuLoad();
 
 private:
 	void modelChanged() override;
@@ -140,6 +141,7 @@ private:
 	// widgets on the top of an instrument-track-window
 	QLineEdit * m_nameLineEdit;
 	LeftRightNav * m_leftRightNav;
+	QLabel* m_cpuLoadLabel;
 	Knob * m_volumeKnob;
 	Knob * m_panningKnob;
 	Knob * m_pitchKnob;
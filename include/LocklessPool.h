@@ -0,0 +1,151 @@
+/*
+ * LocklessPool.h - growable lock-free pool of fixed-size memory blocks
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_LOCKLESS_POOL_H
+#define LMMS_LOCKLESS_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "lmms_export.h"
+
+
+namespace lmms
+{
+
+
+/**
+ * A pool of fixed-size, cache-line aligned memory blocks.
+ *
+ * alloc() and free() are lock-free and can be called from any thread,
+ * including the audio threads. Memory is allocated in slabs which are never
+ * given back until the pool is destroyed. If a low-water mark is given, a
+ * background thread (shared by all pools) grows the pool whenever fewer
+ * blocks are left, so the audio threads only have to allocate if that
+ * thread can't keep up. Once the pool has reached its maximum size, further
+ * blocks are allocated one by one, so alloc() only fails if the system is
+ * out of memory.
+ */
+class LMMS_EXPORT LocklessPool
+{
+public:
+	struct Statistics
+	{
+		std::size_t capacity;		//!< number of blocks allocated
+		std::size_t inUse;			//!< number of blocks handed out
+		std::size_t highWaterMark;	//!< maximum of inUse so far
+		std::size_t exhaustions;	//!< times alloc() had to grow the pool itself
+		std::size_t unpooled;		//!< blocks allocated on their own at the maximum size
+	};
+
+	LocklessPool(std::size_t blockSize, std::size_t initialCapacity = 0, std::size_t lowWaterMark = 0);
+	virtual ~LocklessPool();
+
+	void* alloc();
+	void free(void* ptr);
+
+	//! Grow the pool to hold at least @p capacity blocks. This allocates
+	//! and may block, so don't call it from the audio threads.
+	void reserve(std::size_t capacity);
+
+	Statistics statistics() const;
+
+	//! Sum of the exhaustions of all pools so far, including allocations
+	//! which no pool could serve, see countUnpooledAllocation()
+	static std::size_t totalExhaustions();
+
+	//! For users of pools which allocate from the system allocator what is
+	//! too large for their pools, so it shows up in totalExhaustions()
+	static void countUnpooledAllocation();
+
+	static constexpr std::size_t CacheLineSize = 64;
+
+private:
+	struct BlockHeader;
+	class Grower;
+
+	static constexpr std::size_t SlabSize = 64;
+	static constexpr std::size_t MaxSlabs = 4096;
+	static constexpr std::uint32_t NoBlock = UINT32_MAX;
+
+	BlockHeader* header(std::uint32_t index) const;
+	void push(std::uint32_t index);
+	std::uint32_t pop();
+	bool grow();
+	void* allocOutsideSlabs();
+
+	const std::size_t m_blockStride;
+	const std::size_t m_lowWaterMark;
+
+	std::atomic<char*> m_slabs[MaxSlabs];
+	std::size_t m_numSlabs;
+	std::mutex m_growMutex;
+
+	// index of the first free block + 1 in the lower, ABA tag in the upper half
+	alignas(CacheLineSize) std::atomic<std::uint64_t> m_freeList;
+
+	alignas(CacheLineSize) std::atomic_size_t m_capacity;
+	std::atomic_size_t m_inUse;
+	std::atomic_size_t m_highWaterMark;
+	std::atomic_size_t m_exhaustions;
+	std::atomic_size_t m_unpooled;
+
+	std::atomic_bool m_growRequested;
+} ;
+
+
+
+
+template<typename T>
+class LocklessPoolT : private LocklessPool
+{
+public:
+	LocklessPoolT(std::size_t initialCapacity = 0, std::size_t lowWaterMark = 0) :
+		LocklessPool(sizeof(T), initialCapacity, lowWaterMark)
+	{
+		static_assert(alignof(T) <= CacheLineSize, "T is over-aligned");
+	}
+
+	~LocklessPoolT() override = default;
+
+	T* alloc()
+	{
+		return static_cast<T*>(LocklessPool::alloc());
+	}
+
+	void free(T* ptr)
+	{
+		LocklessPool::free(ptr);
+	}
+
+	using LocklessPool::reserve;
+	using LocklessPool::statistics;
+} ;
+
+
+} // namespace lmms
+
+#endif // LMMS_LOCKLESS_POOL_H
@@ -89,6 +89,9 @@ public:
 	bool hasGui() const { return m_hasGUI; }
 	void setHasGui(bool val) { m_hasGUI = val; }
 
+	//! Largest latency reported by the processors, in frames
+	f_cnt_t latency() const;
+
 protected:
 	/*
 		ctor/dtor
@@ -162,6 +162,8 @@ public:
 	class AutomatableModel *modelAtPort(const QString &uri); // unused currently
 	std::size_t controlCount() const { return LinkedModelGroup::modelNum(); }
 	bool hasNoteInput() const;
+	//! Latency reported by the plugin in its last run, in frames
+	f_cnt_t latency() const;
 
 protected:
 	/*
@@ -189,6 +191,7 @@ private:
 	// quick reference to specific, unique ports
 	StereoPortRef m_inPorts, m_outPorts;
 	Lv2Ports::AtomSeq *m_midiIn = nullptr, *m_midiOut = nullptr;
+	const Lv2Ports::Control* m_latencyPort = nullptr;
 
 	// MIDI
 	// many things here may be moved into the `Instrument` class
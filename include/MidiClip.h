@@ -26,6 +26,8 @@
 #ifndef LMMS_MIDI_CLIP_H
 #define LMMS_MIDI_CLIP_H
 
+#include <utility>
+
 #include "Clip.h"
 #include "Note.h"
 
@@ -76,6 +78,10 @@ public:
 		return m_notes;
 	}
 
+	//! Returns the notes starting at @a time. The position found is kept,
+	//! so calls for consecutive times only look at the notes in between.
+	std::pair<NoteVector::const_iterator, NoteVector::const_iterator> notesStartingAt( const TimePos& time );
+
 	Note * addStepNote( int step );
 	void setStep( int step, bool enabled );
 
@@ -143,6 +149,9 @@ private:
 	NoteVector m_notes;
 	int m_steps;
 
+	//! index of the first note after the ones returned by notesStartingAt()
+	std::size_t m_playCursor;
+
 	MidiClip * adjacentMidiClipByOffset(int offset) const;
 
 	friend class gui::MidiClipView;
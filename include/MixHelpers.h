@@ -36,6 +36,28 @@ class SampleFrame;
 namespace MixHelpers
 {
 
+/*! \brief Instruction sets the vectorized mixing kernels can be dispatched to */
+enum class InstructionSet
+{
+	Scalar,
+	SSE2,
+	AVX2,
+	AVX512,
+	NEON
+};
+
+/*! \brief Returns the instruction set currently used by the mixing kernels
+ *
+ * Picked at first use from the best one the CPU supports.
+ */
+InstructionSet instructionSet();
+
+/*! \brief Forces the mixing kernels to use \p set - returns false if it is not supported by this build or CPU */
+bool setInstructionSet( InstructionSet set );
+
+/*! \brief Returns a human readable name for \p set */
+const char* instructionSetName( InstructionSet set );
+
 bool isSilent( const SampleFrame* src, int frames );
 
 bool useNaNHandler();
@@ -50,6 +72,13 @@ void add( SampleFrame* dst, const SampleFrame* src, int frames );
 /*! \brief Multiply samples from `dst` by `coeff` */
 void multiply(SampleFrame* dst, float coeff, int frames);
 
+/*! \brief Multiply samples from `dst` by volume and panning given in percent
+ *
+ * Per-frame values from \p volumeBuf and \p panningBuf are used instead of \p volume and \p panning when given.
+ */
+void multiplyByVolumeAndPanning(SampleFrame* dst, float volume, const ValueBuffer* volumeBuf,
+	float panning, const ValueBuffer* panningBuf, int frames);
+
 /*! \brief Add samples from src multiplied by coeffSrc to dst */
 void addMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames );
 
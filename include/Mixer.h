@@ -27,18 +27,23 @@
 
 #include "Model.h"
 #include "EffectChain.h"
+#include "CompensationDelay.h"
+#include "CpuTimeCounter.h"
 #include "JournallingObject.h"
 #include "ThreadableJob.h"
 
 #include <atomic>
 #include <optional>
+#include <vector>
 #include <QColor>
 
 namespace lmms
 {
 
 
+class AudioPort;
 class MixerRoute;
+class PeriodRing;
 using MixerRouteVector = std::vector<MixerRoute*>;
 
 class MixerChannel : public ThreadableJob
@@ -53,6 +58,9 @@ class MixerChannel : public ThreadableJob
 		bool m_hasInput;
 		// set to true if any effect in the channel is enabled and running
 		bool m_stillRunning;
+		// true as long as nothing has been written to m_buffer this period,
+		// i.e. it is still clear. Silent channels aren't processed at all.
+		bool m_silent;
 
 		float m_peakLeft;
 		float m_peakRight;
@@ -62,10 +70,22 @@ class MixerChannel : public ThreadableJob
 		BoolModel m_soloModel;
 		FloatModel m_volumeModel;
 		QString m_name;
-		QMutex m_lock;
 		int m_channelIndex; // what channel index are we
 		bool m_queued; // are we queued up for rendering yet?
 		bool m_muted; // are we muted? updated per period so we don't have to call m_muteModel.value() twice
+		PeriodRing * m_stemTap; // receives a copy of each period after the fader while exporting stems
+
+		// latency of the latest input arriving at this channel and of its output, in frames
+		f_cnt_t m_inputLatency;
+		f_cnt_t m_latency;
+		int m_latencyPass; // Mixer::updateLatencies() run which computed the values above
+		CpuTimeCounter m_cpuTime; // time spent processing the channel and its effects
+		SampleFrame* m_delayBuffer; // delayed output of a sender while mixing it in
+
+		// buffers of the audio ports feeding this channel in the current period, summed by
+		// doProcessing(); ports claim a slot with m_inputCount instead of locking the channel
+		std::vector<const SampleFrame*> m_inputs;
+		std::atomic_size_t m_inputCount;
 
 		// pointers to other channels that this one sends to
 		MixerRouteVector m_sends;
@@ -74,6 +94,14 @@ class MixerChannel : public ThreadableJob
 		MixerRouteVector m_receives;
 
 		bool requiresProcessing() const override { return true; }
+		AudioEngineTracer::Tag traceTag() const override
+		{
+			return { AudioEngineTracer::Category::MixerChannel, nullptr, this, m_channelIndex };
+		}
+		CpuTimeCounter* cpuTimeCounter() override { return &m_cpuTime; }
+		// true if no input arrives this period and no effect tail is left,
+		// so the channel can sleep instead of being queued
+		bool canSleep() const;
 		void unmuteForSolo();
 
 		auto color() const -> const std::optional<QColor>& { return m_color; }
@@ -82,6 +110,8 @@ class MixerChannel : public ThreadableJob
 		std::atomic_size_t m_dependenciesMet;
 		void incrementDeps();
 		void processed();
+		void sleep();
+		void writeStemTap();
 		
 	private:
 		void doProcessing() override;
@@ -123,10 +153,23 @@ public:
 
 	void updateName();
 
+	// true if the sender has nothing to send this period, not even the delayed end of its signal
+	bool isSilent() const
+	{
+		return m_from->m_silent && !m_compensation.hasPendingOutput();
+	}
+
+	// delays the sender's output to line it up with the receiver's other inputs
+	CompensationDelay & compensation()
+	{
+		return m_compensation;
+	}
+
 	private:
 		MixerChannel * m_from;
 		MixerChannel * m_to;
 		FloatModel m_amount;
+		CompensationDelay m_compensation;
 };
 
 
@@ -139,9 +182,28 @@ public:
 
 	void mixToChannel( const SampleFrame* _buf, mix_ch_t _ch );
 
-	void prepareMasterMix();
+	// makes room for each of the given number of audio ports to feed a channel
+	// in one period, call with the audio engine's change lock held
+	void reserveInputs( std::size_t audioPorts );
 	void masterMix( SampleFrame* _buf );
 
+	// the two halves of masterMix() for when the channels are processed
+	// along with other jobs: startMasterMix() queues the channels without
+	// inputs, finishMasterMix() is called once all jobs are done
+	void startMasterMix();
+	void finishMasterMix( SampleFrame* _buf );
+
+	// compute the latency of every channel from the effects feeding it and
+	// set the delays of the audio ports and routes so that all inputs of a
+	// channel line up. Called once per period before processing
+	void updateLatencies( const std::vector<AudioPort*> & ports );
+
+	// latency of the whole mixer graph, in frames
+	f_cnt_t latency() const
+	{
+		return m_latency;
+	}
+
 	void saveSettings( QDomDocument & _doc, QDomElement & _parent ) override;
 	void loadSettings( const QDomElement & _this ) override;
 
@@ -216,7 +278,17 @@ private:
 	// make sure we have at least num channels
 	void allocateChannelsTo(int num);
 
+	f_cnt_t channelLatency( MixerChannel * ch );
+
 	int m_lastSoloed;
+
+	// input slots of each channel, see reserveInputs()
+	std::size_t m_inputSlots;
+
+	int m_latencyPass;
+	std::atomic<f_cnt_t> m_latency;
+	//! whether a delay exceeded CompensationDelay::MaxDelay in the last pass
+	bool m_delaysClamped;
 } ;
 
 
@@ -62,6 +62,7 @@ public:
 	void mousePressEvent(QMouseEvent*) override;
 	void mouseDoubleClickEvent(QMouseEvent*) override;
 	bool eventFilter(QObject* dist, QEvent* event) override;
+	bool event(QEvent* event) override;
 
 	void reset();
 	int channelIndex() const { return m_channelIndex; }
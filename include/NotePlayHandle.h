@@ -27,14 +27,15 @@
 #define LMMS_NOTE_PLAY_HANDLE_H
 
 #include <memory>
+#include <new>
+#include <utility>
 
 #include "BasicFilters.h"
+#include "LocklessPool.h"
 #include "Note.h"
 #include "PlayHandle.h"
 #include "Track.h"
 
-class QReadWriteLock;
-
 namespace lmms
 {
 
@@ -44,11 +45,18 @@ class NotePlayHandle;
 using NotePlayHandleList = QList<NotePlayHandle*>;
 using ConstNotePlayHandleList = QList<const NotePlayHandle*>;
 
+//! Deleter for per-note objects created by NotePlayHandleManager::create()
+template<typename T>
+struct NotePoolDeleter
+{
+	void operator()(T* obj) const;
+};
+
 class LMMS_EXPORT NotePlayHandle : public PlayHandle, public Note
 {
 public:
 	void * m_pluginData;
-	std::unique_ptr<BasicFilters<>> m_filter;
+	std::unique_ptr<BasicFilters<>, NotePoolDeleter<BasicFilters<>>> m_filter;
 
 	// length of the declicking fade in
 	fpp_t m_fadeInLength;
@@ -127,6 +135,8 @@ public:
 	/*! Returns whether the play handle plays on a certain track */
 	bool isFromTrack( const Track* _track ) const override;
 
+	AudioEngineTracer::Tag traceTag() const override;
+
 	/*! Releases the note (and plays release frames) */
 	void noteOff( const f_cnt_t offset = 0 );
 
@@ -334,9 +344,14 @@ private:
 
 
 const int INITIAL_NPH_CACHE = 256;
-const int NPH_CACHE_INCREMENT = 16;
-
-class NotePlayHandleManager
+//! upper limit of the configurable voice budget
+const int MAXIMUM_NPH_CACHE = 16384;
+
+//! Hands out memory for note play handles and their per-note data from
+//! lock-free pools, so starting a note neither locks nor allocates as long
+//! as the voice budget isn't exceeded. The pools are grown in the
+//! background when running low.
+class LMMS_EXPORT NotePlayHandleManager
 {
 public:
 	static void init();
@@ -348,17 +363,44 @@ public:
 					int midiEventChannel = -1,
 					NotePlayHandle::Origin origin = NotePlayHandle::Origin::MidiClip );
 	static void release( NotePlayHandle * nph );
-	static void extend( int i );
+	//! Make room for @p voices note play handles. Don't call this from the
+	//! audio threads.
+	static void reserve( std::size_t voices );
 	static void free();
 
+	//! Statistics of the note play handle pool, exhaustions are the times
+	//! a note start had to allocate
+	static LocklessPool::Statistics statistics();
+
+	//! Create per-note objects (e.g. plugin data) in pooled memory. They
+	//! have to be destroyed by destroy() with the same type.
+	template<typename T, typename... Args>
+	static T* create(Args&&... args)
+	{
+		return new (allocPayload(sizeof(T))) T(std::forward<Args>(args)...);
+	}
+
+	template<typename T>
+	static void destroy(T* obj)
+	{
+		if (obj == nullptr) { return; }
+		obj->~T();
+		freePayload(obj, sizeof(T));
+	}
+
 private:
-	static NotePlayHandle ** s_available;
-	static QReadWriteLock s_mutex;
-	static std::atomic_int s_availableIndex;
-	static int s_size;
+	static void* allocPayload(std::size_t size);
+	static void freePayload(void* ptr, std::size_t size);
 };
 
 
+template<typename T>
+void NotePoolDeleter<T>::operator()(T* obj) const
+{
+	NotePlayHandleManager::destroy(obj);
+}
+
+
 } // namespace lmms
 
 #endif // LMMS_NOTE_PLAY_HANDLE_H
@@ -0,0 +1,117 @@
+/*
+ * ParallelRenderer.h - render a project in independently rendered segments
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef LMMS_PARALLEL_RENDERER_H
+#define LMMS_PARALLEL_RENDERER_H
+
+#include <QTemporaryDir>
+#include <QThread>
+#include <vector>
+
+#include "ProjectRenderer.h"
+#include "lmms_export.h"
+
+
+namespace lmms
+{
+
+
+/**
+ * Experimental export which splits the song into segments at points where
+ * no clip is playing, renders every segment in its own LMMS process and
+ * stitches the results together.
+ *
+ * Split points are placed at the end of silent gaps of at least
+ * MinimumGapBars bars, on a tick which starts on a whole frame, so the
+ * segments can be joined without resampling. Effect tails and LFO phases
+ * don't carry over from one segment to the next; the verification mode
+ * renders the song sequentially as well and reports the difference.
+ */
+class LMMS_EXPORT ParallelRenderer : public QThread
+{
+	Q_OBJECT
+public:
+	static constexpr int MinimumGapBars = 2;
+
+	ParallelRenderer( const AudioEngine::qualitySettings & qualitySettings,
+				const OutputSettings & outputSettings,
+				ProjectRenderer::ExportFileFormat fileFormat,
+				const QString & outputFilename,
+				int jobs, bool verify );
+	~ParallelRenderer() override;
+
+	bool isReady() const
+	{
+		return m_fileDev != nullptr && !m_segments.empty();
+	}
+
+	//! Whether the verification render matched (only meaningful if
+	//! verification was requested and the render finished)
+	bool verified() const
+	{
+		return m_verified;
+	}
+
+public slots:
+	void startProcessing();
+	void abortProcessing();
+
+	void updateConsoleProgress();
+
+signals:
+	void progressChanged( int );
+
+private:
+	struct Segment
+	{
+		tick_t begin;
+		tick_t end;
+		f_cnt_t frames;	//!< frames taken from this segment, 0 for all of them
+		QString file;
+	};
+
+	void run() override;
+
+	void findSegments( int jobs );
+	bool startsOnFrame( tick_t tick ) const;
+	f_cnt_t tickToFrame( tick_t tick ) const;
+	QStringList renderArguments( const QString & outputFile, const Segment * segment ) const;
+	bool stitch();
+
+	AudioFileDevice * m_fileDev;
+	AudioEngine::qualitySettings m_qualitySettings;
+	sample_rate_t m_sampleRate;
+	QString m_projectFile;
+	QTemporaryDir m_tempDir;
+	std::vector<Segment> m_segments;
+	bool m_verify;
+	bool m_verified;
+
+	volatile int m_progress;
+	volatile bool m_abort;
+} ;
+
+
+} // namespace lmms
+
+#endif // LMMS_PARALLEL_RENDERER_H
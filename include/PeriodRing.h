@@ -0,0 +1,120 @@
+/*
+ * PeriodRing.h - single-producer/single-consumer ring of audio periods
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef LMMS_PERIOD_RING_H
+#define LMMS_PERIOD_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+
+namespace lmms
+{
+
+class SampleFrame;
+
+
+/**
+ * A fixed-capacity ring of pre-allocated audio periods, handed from the
+ * render thread to the audio device.
+ *
+ * Exactly one thread may write and exactly one thread may read. Neither side
+ * allocates: the writer fills a slot between beginWrite() and endWrite(), the
+ * reader uses the slot in place between beginRead() and endRead(). The audio
+ * engine renders into its own output buffer and copies the period into the
+ * slot, which costs one copy of a period per period. A side only blocks if the
+ * ring is full (writer) or empty (reader).
+ */
+class LMMS_EXPORT PeriodRing
+{
+public:
+	struct Statistics
+	{
+		std::size_t capacity;		//!< number of periods in the ring
+		std::size_t fillLevel;		//!< periods rendered but not yet read
+		std::size_t minFillLevel;	//!< lowest fill level seen by the reader
+		std::size_t underruns;		//!< times the reader found the ring empty
+	};
+
+	PeriodRing(std::size_t capacity, fpp_t framesPerPeriod);
+	~PeriodRing();
+
+	//! Wait for a free slot and return it for writing
+	SampleFrame* beginWrite();
+	//! Publish the slot returned by beginWrite()
+	void endWrite();
+	//! Publish an end-of-stream marker; beginRead() returns nullptr for it
+	void close();
+	//! Wait until the reader has released all published slots
+	void waitUntilRead();
+
+	//! Wait for the next published slot and return it, or nullptr at the
+	//! end of the stream. The slot stays valid until endRead().
+	const SampleFrame* beginRead();
+	void endRead();
+
+	//! Drop all contents. Neither side may be active.
+	void reset();
+
+	std::size_t capacity() const
+	{
+		return m_capacity;
+	}
+
+	std::size_t fillLevel() const
+	{
+		return m_writeIndex.load(std::memory_order_relaxed) - m_readIndex.load(std::memory_order_relaxed);
+	}
+
+	Statistics statistics() const;
+	void resetStatistics();
+
+private:
+	SampleFrame* period(std::uint32_t index) const;
+	std::uint32_t waitForFreeSlot();
+
+	static constexpr std::size_t CacheLineSize = 64;
+
+	const std::size_t m_capacity;
+	const fpp_t m_framesPerPeriod;
+	std::unique_ptr<SampleFrame[]> m_periods;
+	std::unique_ptr<bool[]> m_endOfStream;
+
+	// monotonic, the slot is the index modulo the capacity
+	alignas(CacheLineSize) std::atomic<std::uint32_t> m_writeIndex;
+	alignas(CacheLineSize) std::atomic<std::uint32_t> m_readIndex;
+
+	// only written by the reader
+	alignas(CacheLineSize) std::atomic<std::size_t> m_minFillLevel;
+	std::atomic<std::size_t> m_underruns;
+};
+
+
+} // namespace lmms
+
+#endif // LMMS_PERIOD_RING_H
@@ -94,9 +94,11 @@ public:
 		return !isFinished();
 	}
 
+	AudioEngineTracer::Tag traceTag() const override;
+
 	void lock()
 	{
-		m_processingLock.lock();
+		XrunForensics::lock(m_processingLock);
 	}
 	void unlock()
 	{
@@ -144,17 +146,27 @@ public:
 		m_audioPort = port;
 	}
 	
+	// buffer() and releaseBuffer() refer to the buffer audio ports mix
+	// from, which in pipelined mode is not the one being rendered into
 	void releaseBuffer();
+	void releaseBuffers();
 	
 	SampleFrame* buffer();
 
+	//! Whether there is rendered output which has not been mixed yet
+	bool hasPendingBuffer() const
+	{
+		return !m_bufferReleased[0] || !m_bufferReleased[1];
+	}
+
 private:
 	Type m_type;
 	f_cnt_t m_offset;
 	QThread* m_affinity;
 	QMutex m_processingLock;
-	SampleFrame* m_playHandleBuffer;
-	bool m_bufferReleased;
+	// double-buffered for the pipelined mode of the audio engine
+	SampleFrame* m_playHandleBuffer[2];
+	bool m_bufferReleased[2];
 	bool m_usesBuffer;
 	AudioPort * m_audioPort;
 } ;
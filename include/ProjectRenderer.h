@@ -25,6 +25,9 @@
 #ifndef LMMS_PROJECT_RENDERER_H
 #define LMMS_PROJECT_RENDERER_H
 
+#include <memory>
+#include <vector>
+
 #include "AudioFileDevice.h"
 #include "lmmsconfig.h"
 #include "AudioEngine.h"
@@ -35,6 +38,9 @@
 namespace lmms
 {
 
+class AudioPort;
+class MixerChannel;
+
 
 class LMMS_EXPORT ProjectRenderer : public QThread
 {
@@ -61,15 +67,39 @@ public:
 	} ;
 
 
+	//! A signal written to its own file while rendering: either the output
+	//! of an audio port (after its effects) or of a mixer channel (after its
+	//! fader)
+	struct Stem
+	{
+		AudioPort* port;
+		MixerChannel* channel;
+		QString outputFile;
+	};
+
+
 	ProjectRenderer( const AudioEngine::qualitySettings & _qs,
 				const OutputSettings & _os,
 				ExportFileFormat _file_format,
 				const QString & _out_file );
-	~ProjectRenderer() override = default;
+	//! Render the song once, writing each stem concurrently to its own file.
+	//! The master output is discarded.
+	ProjectRenderer( const AudioEngine::qualitySettings & _qs,
+				const OutputSettings & _os,
+				ExportFileFormat _file_format,
+				const std::vector<Stem> & _stems );
+	~ProjectRenderer() override;
 
 	bool isReady() const
 	{
-		return m_fileDev != nullptr;
+		return m_device != nullptr;
+	}
+
+	//! Overlap the instruments of each period with the effects and the
+	//! mixer of the previous one. Defaults to the audio engine's setting.
+	void setPipelined( bool pipelined )
+	{
+		m_pipelined = pipelined;
 	}
 
 	static ExportFileFormat getFileFormatFromExtension(
@@ -77,6 +107,11 @@ public:
 
 	static QString getFileExtensionFromFormat( ExportFileFormat fmt );
 
+	//! Create the encoder for the given format, nullptr on failure
+	static AudioFileDevice * createFileDevice( const OutputSettings & _os,
+				ExportFileFormat _file_format,
+				const QString & _out_file );
+
 	static const std::array<FileEncodeDevice, 5> fileEncodeDevices;
 
 public slots:
@@ -91,13 +126,24 @@ signals:
 
 
 private:
+	class StemWriter;
+
 	void run() override;
 
+	void connectStems( bool enable );
+
+	AudioDevice * m_device;
 	AudioFileDevice * m_fileDev;
 	AudioEngine::qualitySettings m_qualitySettings;
 
+	std::vector<Stem> m_stems;
+	std::vector<std::unique_ptr<StemWriter>> m_stemWriters;
+
 	volatile int m_progress;
 	volatile bool m_abort;
+	bool m_pipelined;
+	//! mode of the audio engine before the export, restored afterwards
+	bool m_wasPipelined;
 
 } ;
 
@@ -28,6 +28,7 @@
 
 #include <memory>
 
+#include "ParallelRenderer.h"
 #include "ProjectRenderer.h"
 #include "OutputSettings.h"
 
@@ -51,9 +52,17 @@ public:
 	/// Export all unmuted tracks into a single file
 	void renderProject();
 
+	/// Export into a single file, rendering up to @p jobs segments of the
+	/// song in parallel (experimental, see ParallelRenderer)
+	void renderProjectParallel( int jobs, bool verify );
+
 	/// Export all unmuted tracks into individual file
 	void renderTracks();
 
+	/// Export all unmuted tracks into individual files, rendering the song
+	/// only once. Optionally also exports each mixer channel.
+	void renderStems( bool includeMixerChannels = false );
+
 	void abortProcessing();
 
 signals:
@@ -62,13 +71,16 @@ signals:
 
 private slots:
 	void renderNextTrack();
+	void parallelRenderFinished();
 	void updateConsoleProgress();
 
 private:
 	QString pathForTrack( const Track *track, int num );
+	QString pathForMixerChannel( int channel );
 	void restoreMutedState();
 
 	void render( QString outputPath );
+	void startRenderer();
 
 	const AudioEngine::qualitySettings m_qualitySettings;
 	const AudioEngine::qualitySettings m_oldQualitySettings;
@@ -77,6 +89,7 @@ private:
 	QString m_outputPath;
 
 	std::unique_ptr<ProjectRenderer> m_activeRenderer;
+	std::unique_ptr<ParallelRenderer> m_parallelRenderer;
 
 	std::vector<Track*> m_tracksToRender;
 	std::vector<Track*> m_unmuted;
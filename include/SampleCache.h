@@ -0,0 +1,57 @@
+/*
+ * SampleCache.h - shares decoded audio files between samples
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SAMPLE_CACHE_H
+#define LMMS_SAMPLE_CACHE_H
+
+#include <QString>
+#include <memory>
+
+#include "lmms_export.h"
+
+namespace lmms {
+
+class SampleBuffer;
+
+//! Process-wide cache of decoded audio files.
+//!
+//! Buffers are looked up by their absolute, cleaned path and reused as long as
+//! the file's modification time and size did not change. Their audioFile() is
+//! derived from that path, so it doesn't depend on how the file was named by
+//! whoever loaded it first. The cache only keeps weak references, so a buffer
+//! is freed as soon as the last sample using it goes away.
+class LMMS_EXPORT SampleCache
+{
+public:
+	//! Return the buffer for the given file, decoding it if it is not in use
+	//! already. Throws std::runtime_error like SampleBuffer(const QString&).
+	static auto get(const QString& audioFile) -> std::shared_ptr<const SampleBuffer>;
+
+	//! Number of files that are currently loaded
+	static auto size() -> std::size_t;
+};
+
+} // namespace lmms
+
+#endif // LMMS_SAMPLE_CACHE_H
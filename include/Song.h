@@ -27,11 +27,14 @@
 
 #include <array>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <QHash>
 #include <QString>
 
 #include "AudioEngine.h"
+#include "AutomationTimeline.h"
 #include "Controller.h"
 #include "Metronome.h"
 #include "lmms_constants.h"
@@ -451,6 +454,9 @@ private:
 	void restoreKeymapStates(const QDomElement &element);
 
 	void processAutomations(const TrackList& tracks, TimePos timeStart, fpp_t frames);
+	//! Render the automation clips found by the last processAutomations() call
+	//! sample-exactly into their models' value buffers
+	void processAutomationBlock(f_cnt_t offset, fpp_t frames);
 	void processMetronome(size_t bufferOffset);
 
 	void setModified(bool value);
@@ -516,6 +522,10 @@ private:
 	std::shared_ptr<Keymap> m_keymaps[MaxKeymapCount];
 
 	AutomatedValueMap m_oldAutomatedValues;
+	AutomationTimeline m_automationTimeline;
+	std::vector<std::pair<AutomatableModel*, const AutomationClip*>> m_sampleExactAutomation;
+	//! one period, the period size is fixed once the audio engine is created
+	std::vector<float> m_automationBlock;
 
 	Metronome m_metronome;
 
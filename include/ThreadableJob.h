@@ -25,6 +25,9 @@
 #ifndef LMMS_THREADABLE_JOB_H
 #define LMMS_THREADABLE_JOB_H
 
+#include "AudioEngineTracer.h"
+#include "CpuTimeCounter.h"
+#include "XrunForensics.h"
 #include "lmms_basics.h"
 
 #include <atomic>
@@ -74,13 +77,41 @@ public:
 		auto expected = ProcessingState::Queued;
 		if (m_state.compare_exchange_strong(expected, ProcessingState::InProgress))
 		{
+			CpuTimeCounter* const counter = cpuTimeCounter();
+			const bool tracing = AudioEngineTracer::isEnabled();
+			const bool logging = XrunForensics::isLogging();
+			if (!counter && !tracing && !logging)
+			{
+				doProcessing();
+				m_state = ProcessingState::Done;
+				return;
+			}
+
+			// one measurement for the load counter, the tracer and the xrun log
+			const auto begin = AudioEngineTracer::Clock::now();
 			doProcessing();
+			const auto duration = AudioEngineTracer::Clock::now() - begin;
+
+			if (counter) { counter->add(duration); }
+			if (tracing) { AudioEngineTracer::record(traceTag(), begin, begin + duration); }
+			if (logging) { XrunForensics::jobFinished(*this, duration); }
 			m_state = ProcessingState::Done;
 		}
 	}
 
 	virtual bool requiresProcessing() const = 0;
 
+	//! Tells the tracer which track, plugin or channel this job's work belongs to
+	virtual AudioEngineTracer::Tag traceTag() const
+	{
+		return {};
+	}
+
+	//! Counter the time spent in doProcessing() is added to, if any
+	virtual CpuTimeCounter* cpuTimeCounter()
+	{
+		return nullptr;
+	}
 
 protected:
 	virtual void doProcessing() = 0;
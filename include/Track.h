@@ -25,6 +25,7 @@
 #ifndef LMMS_TRACK_H
 #define LMMS_TRACK_H
 
+#include <atomic>
 #include <vector>
 
 #include <QColor>
@@ -121,6 +122,11 @@ public:
 	// -- for usage by Clip only ---------------
 	Clip * addClip( Clip * clip );
 	void removeClip( Clip * clip );
+	//! to be called whenever a clip of this track was moved or resized
+	void invalidateClipIndex()
+	{
+		m_clipIndexDirty = true;
+	}
 	// -------------------------------------------------------
 	void deleteClips();
 
@@ -211,6 +217,17 @@ private:
 	void saveTrack(QDomDocument& doc, QDomElement& element, bool presetMode);
 	void loadTrack(const QDomElement& element, bool presetMode);
 
+	//! entry of the position index used by getClipsInRange()
+	struct ClipIndexEntry
+	{
+		tick_t start;
+		tick_t end;
+		tick_t maxEnd; //!< largest end of this and all previous entries
+		Clip* clip;
+	};
+
+	void rebuildClipIndex();
+
 private:
 	TrackContainer* m_trackContainer;
 	Type m_type;
@@ -226,6 +243,13 @@ private:
 
 	clipVector m_clips;
 
+	//! m_clips sorted by start position, rebuilt lazily after edits
+	std::vector<ClipIndexEntry> m_clipIndex;
+	//! first entry which was not over at the start of the last query
+	std::size_t m_clipIndexCursor;
+	std::atomic<bool> m_clipIndexDirty;
+	QMutex m_clipIndexMutex;
+
 	QMutex m_processingLock;
 	
 	std::optional<QColor> m_color;
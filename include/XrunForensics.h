@@ -0,0 +1,129 @@
+/*
+ * XrunForensics.h - keeps the timing of recent periods to explain xruns
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_XRUN_FORENSICS_H
+#define LMMS_XRUN_FORENSICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "AudioEngineTracer.h"
+#include "lmms_export.h"
+
+class QString;
+
+namespace lmms
+{
+
+class ThreadableJob;
+
+/**
+	Keeps detailed timing of the last periods the audio engine rendered: how
+	long each render stage took, the slowest jobs, how many play handles were
+	running, how often buffer pools had to allocate and how long threads waited
+	for locks.
+
+	When a period takes longer than its budget, these records are handed to a
+	background thread which appends them to a log file as one line of JSON, so
+	intermittent xruns can be examined after the fact. Everything done on the
+	audio threads is realtime safe.
+*/
+class LMMS_EXPORT XrunForensics
+{
+public:
+	using Clock = AudioEngineTracer::Clock;
+
+	static constexpr std::size_t HistorySize = 64; //!< Periods kept
+	static constexpr std::size_t SlowJobCount = 4; //!< Slowest jobs kept per period
+	static constexpr std::size_t StageCount = 4;
+
+	struct SlowJob
+	{
+		AudioEngineTracer::Tag tag;
+		std::int32_t us = 0;
+	};
+
+	struct Period
+	{
+		Clock::time_point begin;
+		std::int32_t elapsedUs = 0;
+		std::array<std::int32_t, StageCount> stageUs{};
+		std::int32_t playHandles = 0;
+		std::uint32_t allocations = 0; //!< Times a buffer pool had to allocate on an audio thread
+		std::uint32_t lockWaits = 0;
+		std::int32_t lockWaitUs = 0;
+		std::array<SlowJob, SlowJobCount> slowestJobs{}; //!< Slowest first, unused entries have us == 0
+	};
+
+	XrunForensics();
+	~XrunForensics();
+
+	//! Starts appending the records of periods around xruns to \p logFile - returns false if it can't be written
+	bool setLogFile( const QString& logFile );
+
+	//! Whether a log file is set, jobs are only timed for the log if it is
+	static bool isLogging()
+	{
+		return s_logging.load( std::memory_order_relaxed );
+	}
+
+	//! Adds a record for the period which just ended, called by AudioEngineProfiler
+	void finishPeriod( Clock::time_point begin, int elapsedUs, int budgetUs,
+		const std::array<int, StageCount>& stageUs, std::size_t playHandles );
+
+	//! Notes the time a job took, called by ThreadableJob::process() on any thread while logging
+	static void jobFinished( const ThreadableJob& job, Clock::duration time );
+
+	//! Locks \p mutex, counting the time spent waiting if it is held by another thread
+	template<typename Mutex>
+	static void lock( Mutex& mutex )
+	{
+		if( !mutex.tryLock() )
+		{
+			const auto begin = Clock::now();
+			mutex.lock();
+			lockWaited( Clock::now() - begin );
+		}
+	}
+
+private:
+	class Writer;
+
+	static void lockWaited( Clock::duration time );
+
+	static std::atomic_bool s_logging;
+
+	std::array<Period, HistorySize> m_history;
+	std::size_t m_next = 0; // index of the record the next period goes into
+	std::size_t m_allocations = 0; // LocklessPool::totalExhaustions() at the end of the last period
+	Clock::time_point m_lastCapture;
+
+	std::unique_ptr<Writer> m_writer;
+};
+
+} // namespace lmms
+
+#endif // LMMS_XRUN_FORENSICS_H
@@ -26,6 +26,7 @@
 #include "AudioFileProcessorView.h"
 
 #include "InstrumentTrack.h"
+#include "NotePlayHandle.h"
 #include "PathUtil.h"
 #include "SampleLoader.h"
 #include "Song.h"
@@ -144,7 +145,7 @@ void AudioFileProcessor::playNote( NotePlayHandle * _n,
 				srcmode = SRC_SINC_MEDIUM_QUALITY;
 				break;
 		}
-		_n->m_pluginData = new Sample::PlaybackState(_n->hasDetuningInfo(), srcmode);
+		_n->m_pluginData = NotePlayHandleManager::create<Sample::PlaybackState>(_n->hasDetuningInfo(), srcmode);
 		static_cast<Sample::PlaybackState*>(_n->m_pluginData)->setFrameIndex(m_nextPlayStartPoint);
 		static_cast<Sample::PlaybackState*>(_n->m_pluginData)->setBackwards(m_nextPlayBackwards);
 
@@ -186,7 +187,7 @@ void AudioFileProcessor::playNote( NotePlayHandle * _n,
 
 void AudioFileProcessor::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<Sample::PlaybackState*>(_n->m_pluginData);
+	NotePlayHandleManager::destroy(static_cast<Sample::PlaybackState*>(_n->m_pluginData));
 }
 
 
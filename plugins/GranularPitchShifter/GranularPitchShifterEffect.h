@@ -28,6 +28,8 @@
 #include "Effect.h"
 #include "GranularPitchShifterControls.h"
 
+#include <algorithm>
+
 #include "BasicFilters.h"
 #include "interpolation.h"
 
@@ -55,6 +57,14 @@ public:
 	{
 		return &m_granularpitchshifterControls;
 	}
+
+	//! The grains start at least this far behind the input. Faster grains
+	//! start further behind, but that changes with every grain, so only the
+	//! stable minimum is reported.
+	f_cnt_t latency() const override
+	{
+		return std::max(static_cast<int>(m_granularpitchshifterControls.m_minLatencyModel.value() * m_sampleRate), SafetyLatency);
+	}
 	
 	// double index and fraction are required for good quality
 	float getHermiteSample(double index, int ch)
@@ -24,6 +24,8 @@
 
 #include "AudioEngine.h"
 
+#include <algorithm>
+
 #include "MixHelpers.h"
 #include "denormals.h"
 
@@ -84,9 +86,13 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 	m_newPlayHandles( PlayHandle::MaxNumber ),
 	m_qualitySettings(qualitySettings::Interpolation::Linear),
 	m_masterGain( 1.0f ),
+	m_pipelined(ConfigManager::inst()->value("audioengine", "pipelined").toInt()),
+	m_playHandleBufferIndex(0),
+	m_pendingAudioPorts(0),
 	m_audioDev( nullptr ),
 	m_oldAudioDev( nullptr ),
 	m_audioDevStartFailed( false ),
+	m_fifoReadPending( false ),
 	m_profiler(),
 	m_clearSignal(false)
 {
@@ -129,15 +135,29 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 		}
 	}
 
+	// the FIFO depth can be raised to trade latency for headroom
+	const int fifoDepth = ConfigManager::inst()->value("audioengine", "fifodepth").toInt();
+	if (fifoDepth > fifoSize)
+	{
+		fifoSize = fifoDepth;
+	}
+
 	// allocte the FIFO from the determined size
-	m_fifo = new Fifo( fifoSize );
+	m_fifo = new PeriodRing(fifoSize, m_framesPerPeriod);
 
 	// now that framesPerPeriod is fixed initialize global BufferManager
 	BufferManager::init( m_framesPerPeriod );
 
+	// pre-size the voice slabs so note-ons never allocate in the render path;
+	// the budget is only set in the configuration file, so don't trust it
+	const int voiceBudget = ConfigManager::inst()->value("audioengine", "voicebudget",
+		QString::number(INITIAL_NPH_CACHE)).toInt();
+	NotePlayHandleManager::reserve(std::clamp(voiceBudget, INITIAL_NPH_CACHE, MAXIMUM_NPH_CACHE));
+
 	m_outputBufferRead = std::make_unique<SampleFrame[]>(m_framesPerPeriod);
 	m_outputBufferWrite = std::make_unique<SampleFrame[]>(m_framesPerPeriod);
 
+	AutomatableModel::setPipelined(m_pipelined);
 
 	for( int i = 0; i < m_numWorkers+1; ++i )
 	{
@@ -167,10 +187,6 @@ AudioEngine::~AudioEngine()
 		m_workers[w]->wait( 500 );
 	}
 
-	while( m_fifo->available() )
-	{
-		delete[] m_fifo->read();
-	}
 	delete m_fifo;
 
 	delete m_midiClient;
@@ -209,6 +225,8 @@ void AudioEngine::startProcessing(bool needsFifo)
 {
 	if (needsFifo)
 	{
+		m_fifo->reset();
+		m_fifoReadPending = false;
 		m_fifoWriter = new fifoWriter( this, m_fifo );
 		m_fifoWriter->start( QThread::HighPriority );
 	}
@@ -289,6 +307,13 @@ void AudioEngine::renderStageNoteSetup()
 		clearInternal();
 	}
 
+	// the audio ports have mixed what these rendered before they were removed
+	for( PlayHandle * handle : m_playHandlesToDelete )
+	{
+		deletePlayHandle( handle );
+	}
+	m_playHandlesToDelete.clear();
+
 	// remove all play-handles that have to be deleted and delete
 	// them if they still exist...
 	// maybe this algorithm could be optimized...
@@ -299,12 +324,16 @@ void AudioEngine::renderStageNoteSetup()
 
 		if( it != m_playHandles.end() )
 		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::Type::NotePlayHandle )
+			if( ( *it )->hasPendingBuffer() )
 			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
+				// in pipelined mode, the output of the previous period is
+				// mixed during this one, so only stop rendering for now
+				m_playHandlesToDelete.push_back( *it );
+			}
+			else
+			{
+				deletePlayHandle( *it );
 			}
-			else delete *it;
 			m_playHandles.erase( it );
 		}
 
@@ -313,9 +342,8 @@ void AudioEngine::renderStageNoteSetup()
 
 	swapBuffers();
 
-	// prepare master mix (clear internal buffers etc.)
-	Mixer * mixer = Engine::mixer();
-	mixer->prepareMasterMix();
+	// line up the paths through the mixer, effects may have changed their latency
+	Engine::mixer()->updateLatencies( m_audioPorts );
 
 	// create play-handles for new notes, samples etc.
 	Engine::getSong()->processNextBuffer();
@@ -328,6 +356,10 @@ void AudioEngine::renderStageNoteSetup()
 		m_newPlayHandles.free( e );
 		e = next;
 	}
+
+	// automation and controllers are known now, compute the value buffers
+	// every instrument and effect will read during this period
+	AutomatableModel::updateValueBuffers();
 }
 
 
@@ -350,7 +382,48 @@ void AudioEngine::renderStageEffects()
 	AudioEngineWorkerThread::fillJobQueue(m_audioPorts);
 	AudioEngineWorkerThread::startAndWaitForJobs();
 
-	// removed all play handles which are done
+	removeFinishedPlayHandles();
+}
+
+
+
+void AudioEngine::renderStagesPipelined()
+{
+	{
+		AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Instruments);
+
+		// STAGE 1 of this period runs alongside STAGES 2 and 3 of the previous
+		// one: play handles render into one of their buffers while audio ports
+		// mix the other one. The mixer channels are queued by the last audio
+		// port, so all of this is processed in one go.
+		m_pendingAudioPorts = m_audioPorts.size();
+		AudioEngineWorkerThread::fillJobQueue(m_playHandles);
+		AudioEngineWorkerThread::fillJobQueue(m_audioPorts);
+		if (m_audioPorts.empty())
+		{
+			Engine::mixer()->startMasterMix();
+		}
+		AudioEngineWorkerThread::startAndWaitForJobs();
+	}
+
+	removeFinishedPlayHandles();
+}
+
+
+
+void AudioEngine::audioPortProcessed()
+{
+	if (m_pipelined && --m_pendingAudioPorts == 0)
+	{
+		Engine::mixer()->startMasterMix();
+	}
+}
+
+
+
+void AudioEngine::removeFinishedPlayHandles()
+{
+	// removed all play handles which are done and whose output has been mixed
 	for( PlayHandleList::Iterator it = m_playHandles.begin();
 						it != m_playHandles.end(); )
 	{
@@ -360,7 +433,7 @@ void AudioEngine::renderStageEffects()
 			++it;
 			continue;
 		}
-		if( ( *it )->isFinished() )
+		if( ( *it )->isFinished() && !( *it )->hasPendingBuffer() )
 		{
 			( *it )->audioPort()->removePlayHandle( ( *it ) );
 			if( ( *it )->type() == PlayHandle::Type::NotePlayHandle )
@@ -379,12 +452,34 @@ void AudioEngine::renderStageEffects()
 
 
 
+void AudioEngine::deletePlayHandle(PlayHandle* handle)
+{
+	handle->audioPort()->removePlayHandle(handle);
+	if (handle->type() == PlayHandle::Type::NotePlayHandle)
+	{
+		NotePlayHandleManager::release(static_cast<NotePlayHandle*>(handle));
+	}
+	else { delete handle; }
+}
+
+
+
 void AudioEngine::renderStageMix()
 {
 	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Mixing);
 
 	Mixer *mixer = Engine::mixer();
-	mixer->masterMix(m_outputBufferWrite.get());
+	if (m_pipelined)
+	{
+		// the mixer channels have already been processed along with the
+		// instruments of the next period
+		const AutomatableModel::PreviousPeriodScope previousPeriod;
+		mixer->finishMasterMix(m_outputBufferWrite.get());
+	}
+	else
+	{
+		mixer->masterMix(m_outputBufferWrite.get());
+	}
 
 	MixHelpers::multiply(m_outputBufferWrite.get(), m_masterGain, m_framesPerPeriod);
 
@@ -404,14 +499,22 @@ const SampleFrame* AudioEngine::renderNextBuffer()
 
 	m_profiler.startPeriod();
 	s_renderingThread = true;
+	if (AudioEngineTracer::isEnabled()) { AudioEngineTracer::setThreadName("Audio engine"); }
 
 	renderStageNoteSetup();     // STAGE 0: clear old play handles and buffers, setup new play handles
-	renderStageInstruments();   // STAGE 1: run and render all play handles
-	renderStageEffects();       // STAGE 2: process effects of all instrument- and sampletracks
+	if (m_pipelined)
+	{
+		renderStagesPipelined(); // STAGE 1 of this period, STAGES 2 and 3 of the previous period
+	}
+	else
+	{
+		renderStageInstruments(); // STAGE 1: run and render all play handles
+		renderStageEffects();     // STAGE 2: process effects of all instrument- and sampletracks
+	}
 	renderStageMix();           // STAGE 3: do master mix in mixer
 
 	s_renderingThread = false;
-	m_profiler.finishPeriod(outputSampleRate(), m_framesPerPeriod);
+	m_profiler.finishPeriod(outputSampleRate(), m_framesPerPeriod, m_playHandles.size());
 
 	return m_outputBufferRead.get();
 }
@@ -419,6 +522,27 @@ const SampleFrame* AudioEngine::renderNextBuffer()
 
 
 
+const SampleFrame* AudioEngine::nextBuffer()
+{
+	if (!hasFifoWriter()) { return renderNextBuffer(); }
+
+	// the previous period was in use by the device until now
+	if (m_fifoReadPending) { m_fifo->endRead(); }
+
+	const SampleFrame* buffer = m_fifo->beginRead();
+	m_fifoReadPending = buffer != nullptr;
+	if (!buffer)
+	{
+		// release the end-of-stream marker right away, the device won't
+		// ask for another period
+		m_fifo->endRead();
+	}
+	return buffer;
+}
+
+
+
+
 void AudioEngine::swapBuffers()
 {
 	m_inputBufferWrite = (m_inputBufferWrite + 1) % 2;
@@ -427,6 +551,29 @@ void AudioEngine::swapBuffers()
 
 	std::swap(m_outputBufferRead, m_outputBufferWrite);
 	zeroSampleFrames(m_outputBufferWrite.get(), m_framesPerPeriod);
+
+	m_playHandleBufferIndex = 1 - m_playHandleBufferIndex;
+}
+
+
+
+
+void AudioEngine::setPipelined(bool pipelined)
+{
+	const auto guard = requestChangesGuard();
+
+	// drop output that has been rendered but not mixed yet, so it doesn't
+	// show up in a later period
+	for (auto ph : m_playHandles)
+	{
+		ph->releaseBuffers();
+	}
+	for (auto ph : m_playHandlesToDelete)
+	{
+		ph->releaseBuffers();
+	}
+	m_pipelined = pipelined;
+	AutomatableModel::setPipelined(pipelined);
 }
 
 void AudioEngine::clear()
@@ -556,6 +703,21 @@ void AudioEngine::restoreAudioDevice()
 
 
 
+void AudioEngine::addAudioPort(AudioPort * port)
+{
+	requestChangeInModel();
+	m_audioPorts.push_back(port);
+	if (Engine::mixer())
+	{
+		// so each port finds a free input slot in its mixer channel
+		Engine::mixer()->reserveInputs(m_audioPorts.size());
+	}
+	doneChangeInModel();
+}
+
+
+
+
 void AudioEngine::removeAudioPort(AudioPort * port)
 {
 	requestChangeInModel();
@@ -670,12 +832,34 @@ void AudioEngine::removePlayHandlesOfTypes(Track * track, PlayHandle::Types type
 			++it;
 		}
 	}
+	// their audio ports are about to go away as well
+	for (auto it = m_playHandlesToDelete.begin(); it != m_playHandlesToDelete.end();)
+	{
+		if ((*it)->isFromTrack(track) && ((*it)->type() & types))
+		{
+			deletePlayHandle(*it);
+			it = m_playHandlesToDelete.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
 	doneChangeInModel();
 }
 
 
 
 
+f_cnt_t AudioEngine::processingLatency() const
+{
+	const Mixer* mixer = Engine::mixer();
+	return ( mixer ? mixer->latency() : 0 ) + ( m_pipelined ? m_framesPerPeriod : 0 );
+}
+
+
+
+
 void AudioEngine::requestChangeInModel()
 {
 	if (s_renderingThread) { return; }
@@ -1081,7 +1265,7 @@ MidiClient * AudioEngine::tryMidiClients()
 
 
 
-AudioEngine::fifoWriter::fifoWriter( AudioEngine* audioEngine, Fifo * fifo ) :
+AudioEngine::fifoWriter::fifoWriter( AudioEngine* audioEngine, PeriodRing * fifo ) :
 	m_audioEngine( audioEngine ),
 	m_fifo( fifo ),
 	m_writing( true )
@@ -1107,14 +1291,16 @@ void AudioEngine::fifoWriter::run()
 	const fpp_t frames = m_audioEngine->framesPerPeriod();
 	while( m_writing )
 	{
-		auto buffer = new SampleFrame[frames];
+		// wait for a free slot before rendering so the period is as fresh
+		// as possible when the device picks it up
+		SampleFrame* buffer = m_fifo->beginWrite();
 		const SampleFrame* b = m_audioEngine->renderNextBuffer();
 		memcpy(buffer, b, frames * sizeof(SampleFrame));
-		m_fifo->write(buffer);
+		m_fifo->endWrite();
 	}
 
 	// Let audio backend stop processing
-	m_fifo->write(nullptr);
+	m_fifo->close();
 	m_fifo->waitUntilRead();
 }
 
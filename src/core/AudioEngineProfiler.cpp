@@ -26,19 +26,37 @@
 
 #include <cstdint>
 
+#include <algorithm>
+
+#include "CpuTimeCounter.h"
+#include "Effect.h"
+#include "Engine.h"
+#include "Instrument.h"
+#include "InstrumentTrack.h"
+#include "Mixer.h"
+#include "PatternStore.h"
+#include "SampleTrack.h"
+#include "Song.h"
+
 namespace lmms
 {
 
 AudioEngineProfiler::AudioEngineProfiler() :
 	m_periodTimer(),
-	m_cpuLoad( 0 ),
-	m_outputFile()
+	m_cpuLoad( 0 )
+{
+}
+
+
+
+AudioEngineProfiler::~AudioEngineProfiler()
 {
+	AudioEngineTracer::stop();
 }
 
 
 
-void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod )
+void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod, std::size_t playHandles )
 {
 	// Time taken to process all data and fill the audio buffer.
 	const unsigned int periodElapsed = m_periodTimer.elapsed();
@@ -57,21 +75,103 @@ void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPe
 		const auto newLoad = 100.f * m_detailTime[i] / timeLimit;
 		const auto oldLoad = m_detailLoad[i].load(std::memory_order_relaxed);
 		m_detailLoad[i].store(newLoad * 0.05f + oldLoad * 0.95f, std::memory_order_relaxed);
+		m_detailTotal[i].fetch_add(m_detailTime[i], std::memory_order_relaxed);
 	}
+	m_periodCount.fetch_add(1, std::memory_order_relaxed);
+
+	CpuTimeCounter::finishPeriod( static_cast<std::int64_t>( 1000000000 ) * framesPerPeriod / sampleRate );
 
-	if( m_outputFile.isOpen() )
+	static_assert( DetailCount == XrunForensics::StageCount );
+	m_xrunForensics.finishPeriod( m_periodBegin, periodElapsed, static_cast<int>( timeLimit ), m_detailTime, playHandles );
+
+	if( AudioEngineTracer::isEnabled() )
 	{
-		m_outputFile.write( QString( "%1\n" ).arg( periodElapsed ).toLatin1() );
+		AudioEngineTracer::record( { AudioEngineTracer::Category::Period, "Period" },
+			m_periodBegin, AudioEngineTracer::Clock::now() );
 	}
 }
 
 
 
-void AudioEngineProfiler::setOutputFile( const QString& outputFile )
+void AudioEngineProfiler::resetTotals()
 {
-	m_outputFile.close();
-	m_outputFile.setFileName( outputFile );
-	m_outputFile.open( QFile::WriteOnly | QFile::Truncate );
+	m_periodCount = 0;
+	for (auto& total : m_detailTotal)
+	{
+		total = 0;
+	}
+}
+
+
+
+bool AudioEngineProfiler::setOutputFile( const QString& outputFile )
+{
+	return AudioEngineTracer::start( outputFile );
+}
+
+
+
+std::vector<AudioEngineProfiler::PluginLoad> AudioEngineProfiler::pluginLoads()
+{
+	std::vector<PluginLoad> loads;
+
+	const auto addEffects = [&loads]( const QString& owner, const EffectChain* chain )
+	{
+		if( chain == nullptr ) { return; }
+		for( Effect* effect : chain->effects() )
+		{
+			loads.push_back( { owner + ": " + effect->displayName(),
+				effect->cpuTime().load(), effect->cpuTime().peakLoad() } );
+		}
+	};
+
+	for( const TrackContainer* container : { static_cast<TrackContainer*>( Engine::getSong() ),
+		static_cast<TrackContainer*>( Engine::patternStore() ) } )
+	{
+		if( container == nullptr ) { continue; }
+		for( Track* track : container->tracks() )
+		{
+			if( auto instrumentTrack = dynamic_cast<InstrumentTrack*>( track ) )
+			{
+				if( Instrument* instrument = instrumentTrack->instrument() )
+				{
+					loads.push_back( { track->name() + ": " + instrument->displayName(),
+						instrument->cpuTime().load(), instrument->cpuTime().peakLoad() } );
+				}
+				addEffects( track->name(), instrumentTrack->audioPort()->effects() );
+			}
+			else if( auto sampleTrack = dynamic_cast<SampleTrack*>( track ) )
+			{
+				addEffects( track->name(), sampleTrack->audioPort()->effects() );
+			}
+		}
+	}
+
+	if( Mixer* mixer = Engine::mixer() )
+	{
+		for( int i = 0; i < mixer->numChannels(); ++i )
+		{
+			addEffects( mixer->mixerChannel( i )->m_name, &mixer->mixerChannel( i )->m_fxChain );
+		}
+	}
+
+	std::sort( loads.begin(), loads.end(),
+		[]( const PluginLoad& a, const PluginLoad& b ) { return a.load > b.load; } );
+	return loads;
+}
+
+
+
+const char* AudioEngineProfiler::detailName( DetailType type )
+{
+	switch( type )
+	{
+		case DetailType::NoteSetup: return "Notes and setup";
+		case DetailType::Instruments: return "Instruments";
+		case DetailType::Effects: return "Effects";
+		case DetailType::Mixing: return "Mixing";
+		default: return "Unknown";
+	}
 }
 
 } // namespace lmms
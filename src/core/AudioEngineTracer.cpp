@@ -0,0 +1,443 @@
+/*
+ * AudioEngineTracer.cpp - realtime safe trace recorder for the audio engine
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AudioEngineTracer.h"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+namespace lmms
+{
+
+std::atomic_bool AudioEngineTracer::s_enabled = false;
+
+namespace
+{
+
+struct Event
+{
+	std::int64_t begin; // ns since the start of the trace
+	std::int64_t end;
+	const char* name;
+	const void* owner;
+	std::int32_t channel;
+	AudioEngineTracer::Category category;
+};
+
+constexpr std::size_t MaxThreads = 64;
+constexpr std::size_t RingSize = 4096; // per thread, must be a power of two
+constexpr auto DrainInterval = std::chrono::milliseconds{20};
+
+//! Single producer, single consumer ring of one thread's events
+struct Ring
+{
+	//! allocated by the first start() and kept, events is published once it's there
+	std::unique_ptr<Event[]> storage;
+	std::atomic<Event*> events = nullptr;
+	std::atomic_size_t head = 0; // advanced by the recording thread
+	std::atomic_size_t tail = 0; // advanced by the drain thread
+	std::atomic<const char*> threadName = nullptr;
+	//! whether a thread records into this ring
+	std::atomic_bool claimed = false;
+};
+
+std::array<Ring, MaxThreads> s_rings;
+std::atomic_size_t s_ringsUsed = 0; // rings up to the highest one ever claimed
+std::atomic_uint64_t s_dropped = 0;
+std::atomic<AudioEngineTracer::Clock::rep> s_epoch = 0;
+
+//! The ring of a thread, handed back when the thread exits
+struct RingClaim
+{
+	~RingClaim()
+	{
+		if( index < MaxThreads )
+		{
+			s_rings[index].threadName.store( nullptr, std::memory_order_relaxed );
+			s_rings[index].claimed.store( false, std::memory_order_release );
+		}
+	}
+
+	std::size_t index = MaxThreads + 1; // not claimed yet
+};
+
+thread_local RingClaim t_ring;
+
+std::mutex s_labelMutex;
+std::unordered_map<const void*, QString> s_labels;
+
+//! Returns the ring of the calling thread, claiming a free one on first use
+Ring* threadRing()
+{
+	if( t_ring.index > MaxThreads )
+	{
+		t_ring.index = MaxThreads;
+		for( std::size_t i = 0; i < MaxThreads; ++i )
+		{
+			bool claimed = false;
+			if( s_rings[i].claimed.compare_exchange_strong( claimed, true, std::memory_order_acquire ) )
+			{
+				t_ring.index = i;
+				auto used = s_ringsUsed.load( std::memory_order_relaxed );
+				while( used <= i && !s_ringsUsed.compare_exchange_weak( used, i + 1 ) )
+				{
+					// Empty loop (compare_exchange_weak updates used)
+				}
+				break;
+			}
+		}
+	}
+	return t_ring.index < MaxThreads ? &s_rings[t_ring.index] : nullptr;
+}
+
+QByteArray jsonString( const QString& text )
+{
+	QByteArray out = "\"";
+	for( const char c : text.toUtf8() )
+	{
+		switch( c )
+		{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if( static_cast<unsigned char>( c ) < 0x20 )
+				{
+					out += "\\u00" + QByteArray::number( static_cast<int>( c ), 16 ).rightJustified( 2, '0' );
+				}
+				else
+				{
+					out += c;
+				}
+		}
+	}
+	return out + "\"";
+}
+
+//! Owns the output file and the thread draining the rings into it
+class Session
+{
+public:
+	explicit Session( const QString& outputFile ) :
+		m_file( outputFile )
+	{
+	}
+
+	~Session()
+	{
+		finish();
+	}
+
+	bool open()
+	{
+		if( !m_file.open( QFile::WriteOnly | QFile::Truncate ) )
+		{
+			return false;
+		}
+		m_file.write( "{\"traceEvents\":[\n" );
+		m_file.write( "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"LMMS\"}}" );
+		m_thread = std::thread( [this] { run(); } );
+		return true;
+	}
+
+	void finish()
+	{
+		if( !m_thread.joinable() )
+		{
+			return;
+		}
+		{
+			const auto lock = std::lock_guard{ m_mutex };
+			m_quit = true;
+		}
+		m_wake.notify_one();
+		m_thread.join();
+
+		drain();
+		m_file.write( "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":"
+			+ QByteArray::number( static_cast<qulonglong>( s_dropped.load() ) ) + "}}\n" );
+		m_file.close();
+	}
+
+private:
+	void run()
+	{
+		auto lock = std::unique_lock{ m_mutex };
+		while( !m_quit )
+		{
+			m_wake.wait_for( lock, DrainInterval );
+			lock.unlock();
+			drain();
+			lock.lock();
+		}
+	}
+
+	void drain()
+	{
+		const auto threads = s_ringsUsed.load();
+		const auto labelLock = std::lock_guard{ s_labelMutex };
+		for( std::size_t tid = 0; tid < threads; ++tid )
+		{
+			Ring& ring = s_rings[tid];
+			const auto head = ring.head.load( std::memory_order_acquire );
+			auto tail = ring.tail.load( std::memory_order_relaxed );
+			if( tail == head )
+			{
+				continue;
+			}
+
+			// rings are handed on to new threads, so the name may change
+			const char* name = ring.threadName.load();
+			const auto [named, first] = m_threadNames.try_emplace( tid, name );
+			if( first || ( name && name != named->second ) )
+			{
+				named->second = name;
+				writeEvent( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number( static_cast<int>( tid ) )
+					+ ",\"args\":{\"name\":" + jsonString( QString::fromLatin1( name ? name : "Thread" ) ) + "}}" );
+			}
+
+			const Event* events = ring.events.load( std::memory_order_acquire );
+			for( ; tail != head; ++tail )
+			{
+				write( tid, events[tail & ( RingSize - 1 )] );
+			}
+			ring.tail.store( tail, std::memory_order_release );
+		}
+	}
+
+	void write( std::size_t tid, const Event& event )
+	{
+		const auto label = s_labels.find( event.owner );
+		const bool hasLabel = event.owner && label != s_labels.end();
+
+		QString name;
+		if( event.category == AudioEngineTracer::Category::MixerChannel )
+		{
+			name = QString( "Mixer channel %1" ).arg( event.channel );
+		}
+		else if( hasLabel )
+		{
+			name = label->second;
+		}
+		else if( event.name )
+		{
+			name = QString::fromUtf8( event.name );
+		}
+		else
+		{
+			name = QString::fromLatin1( AudioEngineTracer::categoryName( event.category ) );
+		}
+
+		QByteArray args;
+		if( hasLabel )
+		{
+			args += ",\"track\":" + jsonString( label->second );
+		}
+		if( event.name )
+		{
+			args += ",\"plugin\":" + jsonString( QString::fromUtf8( event.name ) );
+		}
+		if( event.channel >= 0 )
+		{
+			args += ",\"channel\":" + QByteArray::number( event.channel );
+		}
+		if( !args.isEmpty() )
+		{
+			args = ",\"args\":{" + args.mid( 1 ) + "}";
+		}
+
+		writeEvent( "{\"name\":" + jsonString( name )
+			+ ",\"cat\":\"" + AudioEngineTracer::categoryName( event.category )
+			+ "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + QByteArray::number( static_cast<int>( tid ) )
+			+ ",\"ts\":" + QByteArray::number( event.begin / 1000.0, 'f', 3 )
+			+ ",\"dur\":" + QByteArray::number( ( event.end - event.begin ) / 1000.0, 'f', 3 )
+			+ args + "}" );
+	}
+
+	void writeEvent( const QByteArray& json )
+	{
+		m_file.write( ",\n" );
+		m_file.write( json );
+	}
+
+	QFile m_file;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_quit = false;
+	std::unordered_map<std::size_t, const char*> m_threadNames;
+};
+
+std::mutex s_sessionMutex;
+std::unique_ptr<Session> s_session;
+
+} // namespace
+
+
+
+
+bool AudioEngineTracer::start( const QString& outputFile )
+{
+	const auto lock = std::lock_guard{ s_sessionMutex };
+	s_enabled = false;
+	s_session.reset();
+
+	for( Ring& ring : s_rings )
+	{
+		if( !ring.storage )
+		{
+			// threads may be recording right now, so publish the ring only once it's allocated
+			ring.storage = std::make_unique<Event[]>( RingSize );
+			ring.events.store( ring.storage.get(), std::memory_order_release );
+		}
+		// drop whatever was left over from an earlier trace
+		ring.tail.store( ring.head.load() );
+	}
+	s_dropped = 0;
+	s_epoch = Clock::now().time_since_epoch().count();
+
+	auto session = std::make_unique<Session>( outputFile );
+	if( !session->open() )
+	{
+		return false;
+	}
+	s_session = std::move( session );
+	s_enabled = true;
+	return true;
+}
+
+
+
+
+void AudioEngineTracer::stop()
+{
+	const auto lock = std::lock_guard{ s_sessionMutex };
+	s_enabled = false;
+	s_session.reset();
+}
+
+
+
+
+void AudioEngineTracer::record( const Tag& tag, Clock::time_point begin, Clock::time_point end )
+{
+	Ring* ring = threadRing();
+	Event* events = ring ? ring->events.load( std::memory_order_acquire ) : nullptr;
+	if( events == nullptr )
+	{
+		s_dropped.fetch_add( 1, std::memory_order_relaxed );
+		return;
+	}
+
+	const auto head = ring->head.load( std::memory_order_relaxed );
+	if( head - ring->tail.load( std::memory_order_acquire ) >= RingSize )
+	{
+		s_dropped.fetch_add( 1, std::memory_order_relaxed );
+		return;
+	}
+
+	const auto epoch = Clock::duration{ s_epoch.load( std::memory_order_relaxed ) };
+	const auto ns = []( Clock::duration d ) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>( d ).count();
+	};
+	events[head & ( RingSize - 1 )] = Event{
+		ns( begin.time_since_epoch() - epoch ),
+		ns( end.time_since_epoch() - epoch ),
+		tag.name,
+		tag.owner,
+		tag.channel,
+		tag.category
+	};
+	ring->head.store( head + 1, std::memory_order_release );
+}
+
+
+
+
+void AudioEngineTracer::setThreadName( const char* name )
+{
+	if( Ring* ring = threadRing() )
+	{
+		ring->threadName.store( name, std::memory_order_relaxed );
+	}
+}
+
+
+
+
+void AudioEngineTracer::setLabel( const void* owner, const QString& label )
+{
+	const auto lock = std::lock_guard{ s_labelMutex };
+	s_labels[owner] = label;
+}
+
+
+
+
+void AudioEngineTracer::removeLabel( const void* owner )
+{
+	const auto lock = std::lock_guard{ s_labelMutex };
+	s_labels.erase( owner );
+}
+
+
+
+
+QString AudioEngineTracer::label( const void* owner )
+{
+	const auto lock = std::lock_guard{ s_labelMutex };
+	const auto it = s_labels.find( owner );
+	return it != s_labels.end() ? it->second : QString{};
+}
+
+
+
+
+const char* AudioEngineTracer::categoryName( Category category )
+{
+	switch( category )
+	{
+		case Category::Period: return "period";
+		case Category::Stage: return "stage";
+		case Category::NotePlayHandle: return "note";
+		case Category::PlayHandle: return "playhandle";
+		case Category::AudioPort: return "audioport";
+		case Category::MixerChannel: return "mixer";
+		case Category::Effect: return "effect";
+		case Category::Job: return "job";
+	}
+	return "job";
+}
+
+} // namespace lmms
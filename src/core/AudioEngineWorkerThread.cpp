@@ -24,9 +24,7 @@
 
 #include "AudioEngineWorkerThread.h"
 
-#include <QDebug>
-#include <QMutex>
-#include <QWaitCondition>
+#include <thread>
 
 #include "denormals.h"
 #include "AudioEngine.h"
@@ -40,70 +38,248 @@ namespace lmms
 {
 
 AudioEngineWorkerThread::JobQueue AudioEngineWorkerThread::globalJobQueue;
-QWaitCondition * AudioEngineWorkerThread::queueReadyWaitCond = nullptr;
+std::atomic<std::uint64_t> AudioEngineWorkerThread::s_generation = 0;
 QList<AudioEngineWorkerThread *> AudioEngineWorkerThread::workerThreads;
 
-// implementation of internal JobQueue
-void AudioEngineWorkerThread::JobQueue::reset( OperationMode _opMode )
+// the worker whose deque the current thread owns, if any
+static thread_local AudioEngineWorkerThread* s_currentWorker = nullptr;
+
+// number of idle rounds before an idle thread yields resp. goes to sleep
+static constexpr unsigned int SPIN_ROUNDS = 256;
+static constexpr unsigned int YIELD_ROUNDS = SPIN_ROUNDS + 64;
+
+
+static inline void cpuRelax()
+{
+#ifdef __SSE__
+	_mm_pause();
+#endif
+}
+
+
+
+
+// implementation of per-worker deque
+bool AudioEngineWorkerThread::JobDeque::push(ThreadableJob* job)
+{
+	const auto bottom = m_bottom.load(std::memory_order_relaxed);
+	const auto top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= CAPACITY) { return false; }
+
+	m_items[bottom & MASK].store(job, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	return true;
+}
+
+
+
+
+ThreadableJob* AudioEngineWorkerThread::JobDeque::pop()
 {
-	m_writeIndex = 0;
-	m_itemsDone = 0;
-	m_opMode = _opMode;
+	const auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	auto top = m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// deque was empty
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	ThreadableJob* job = m_items[bottom & MASK].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// last item - race against thieves
+		if (!m_top.compare_exchange_strong(top, top + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
 }
 
 
 
 
+ThreadableJob* AudioEngineWorkerThread::JobDeque::steal()
+{
+	auto top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const auto bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom) { return nullptr; }
+
+	ThreadableJob* job = m_items[top & MASK].load(std::memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1,
+			std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		// lost the race against the owner or another thief
+		return nullptr;
+	}
+	return job;
+}
+
+
+
+
+// implementation of internal JobQueue
 void AudioEngineWorkerThread::JobQueue::addJob( ThreadableJob * _job )
 {
 	if( _job->requiresProcessing() )
 	{
 		// update job state
 		_job->queue();
-		// actually queue the job via atomic operations
-		auto index = m_writeIndex++;
-		if (index < JOB_QUEUE_SIZE) {
-			m_items[index] = _job;
-		} else {
-			qWarning() << "Job queue is full!";
-			++m_itemsDone;
+		++m_pending;
+		if (m_sleepers.load() > 0)
+		{
+			m_pending.notify_all();
+		}
+
+		// jobs spawned by a worker (e.g. mixer channels whose senders are
+		// done) stay on that worker's deque, others go to the shared queue
+		if (s_currentWorker == nullptr || !s_currentWorker->m_deque.push(_job))
+		{
+			push(_job);
 		}
 	}
 }
 
 
 
-void AudioEngineWorkerThread::JobQueue::run()
+
+void AudioEngineWorkerThread::JobQueue::push(ThreadableJob* job)
 {
-	bool processedJob = true;
-	while (processedJob && m_itemsDone < m_writeIndex)
+	auto index = m_writeIndex.load();
+	do
 	{
-		processedJob = false;
-		for (auto i = std::size_t{0}; i < m_writeIndex && i < JOB_QUEUE_SIZE; ++i)
+		const auto readIndex = m_readIndex.load();
+		if (index >= readIndex && index - readIndex >= JOB_QUEUE_SIZE)
 		{
-			ThreadableJob * job = m_items[i].exchange(nullptr);
-			if( job )
+			// queue is full, so process the job right away
+			job->process();
+			jobDone();
+			return;
+		}
+	}
+	while (!m_writeIndex.compare_exchange_weak(index, index + 1));
+
+	// the slot might not have been cleared yet by the reader of the
+	// previous lap
+	ThreadableJob* expected = nullptr;
+	while (!m_items[index % JOB_QUEUE_SIZE].compare_exchange_weak(expected, job))
+	{
+		expected = nullptr;
+		cpuRelax();
+	}
+}
+
+
+
+
+ThreadableJob* AudioEngineWorkerThread::JobQueue::take()
+{
+	auto index = m_readIndex.load();
+	while (index < m_writeIndex.load())
+	{
+		if (m_readIndex.compare_exchange_weak(index, index + 1))
+		{
+			// slot is reserved for us, but the writer might not have
+			// published the job yet
+			ThreadableJob* job;
+			while ((job = m_items[index % JOB_QUEUE_SIZE].exchange(nullptr)) == nullptr)
 			{
-				job->process();
-				processedJob = true;
-				++m_itemsDone;
+				cpuRelax();
 			}
+			return job;
 		}
-		// always exit loop if we're not in dynamic mode
-		processedJob = processedJob && ( m_opMode == OperationMode::Dynamic );
 	}
+	return nullptr;
 }
 
 
 
 
-void AudioEngineWorkerThread::JobQueue::wait()
+ThreadableJob* AudioEngineWorkerThread::JobQueue::steal(AudioEngineWorkerThread* thief)
 {
-	while (m_itemsDone < m_writeIndex)
+	// start with the neighbour so that thieves don't all go for the same victim
+	const auto numWorkers = workerThreads.size();
+	const auto start = thief ? workerThreads.indexOf(thief) + 1 : 0;
+	for (auto i = 0; i < numWorkers; ++i)
 	{
-#ifdef __SSE__
-		_mm_pause();
-#endif
+		AudioEngineWorkerThread* victim = workerThreads[(start + i) % numWorkers];
+		if (victim == thief) { continue; }
+		if (ThreadableJob* job = victim->m_deque.steal())
+		{
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+void AudioEngineWorkerThread::JobQueue::jobDone()
+{
+	if (--m_pending == 0 && m_sleepers.load() > 0)
+	{
+		m_pending.notify_all();
+	}
+}
+
+
+
+
+void AudioEngineWorkerThread::JobQueue::backoff(unsigned int idleRounds)
+{
+	if (idleRounds < SPIN_ROUNDS)
+	{
+		cpuRelax();
+	}
+	else if (idleRounds < YIELD_ROUNDS)
+	{
+		std::this_thread::yield();
+	}
+	else
+	{
+		// nothing to steal for a while (e.g. a long chain of dependent
+		// jobs), so sleep until a job is added or the queue drains
+		++m_sleepers;
+		const auto pending = m_pending.load();
+		if (pending > 0)
+		{
+			m_pending.wait(pending);
+		}
+		--m_sleepers;
+	}
+}
+
+
+
+
+void AudioEngineWorkerThread::JobQueue::run( AudioEngineWorkerThread * worker )
+{
+	auto idleRounds = 0u;
+	while (m_pending.load() > 0)
+	{
+		ThreadableJob* job = worker ? worker->m_deque.pop() : nullptr;
+		if (job == nullptr) { job = take(); }
+		if (job == nullptr) { job = steal(worker); }
+
+		if (job)
+		{
+			job->process();
+			jobDone();
+			idleRounds = 0;
+		}
+		else
+		{
+			backoff(idleRounds++);
+		}
 	}
 }
 
@@ -117,18 +293,10 @@ AudioEngineWorkerThread::AudioEngineWorkerThread( AudioEngine* audioEngine ) :
 	QThread( audioEngine ),
 	m_quit( false )
 {
-	// initialize global static data
-	if( queueReadyWaitCond == nullptr )
-	{
-		queueReadyWaitCond = new QWaitCondition;
-	}
-
 	// keep track of all instantiated worker threads - this is used for
 	// processing the last worker thread "inline", see comments in
 	// AudioEngineWorkerThread::startAndWaitForJobs() for details
 	workerThreads << this;
-
-	resetJobQueue();
 }
 
 
@@ -145,7 +313,6 @@ AudioEngineWorkerThread::~AudioEngineWorkerThread()
 void AudioEngineWorkerThread::quit()
 {
 	m_quit = true;
-	resetJobQueue();
 }
 
 
@@ -153,12 +320,15 @@ void AudioEngineWorkerThread::quit()
 
 void AudioEngineWorkerThread::startAndWaitForJobs()
 {
-	queueReadyWaitCond->wakeAll();
+	++s_generation;
+	s_generation.notify_all();
+
 	// The last worker-thread is never started. Instead it's processed "inline"
 	// i.e. within the global AudioEngine thread. This way we can reduce latencies
 	// that otherwise would be caused by synchronizing with another thread.
-	globalJobQueue.run();
-	globalJobQueue.wait();
+	s_currentWorker = workerThreads.isEmpty() ? nullptr : workerThreads.last();
+	globalJobQueue.run(s_currentWorker);
+	s_currentWorker = nullptr;
 }
 
 
@@ -167,14 +337,23 @@ void AudioEngineWorkerThread::startAndWaitForJobs()
 void AudioEngineWorkerThread::run()
 {
 	disable_denormals();
+	AudioEngineTracer::setThreadName("Worker thread");
+
+	s_currentWorker = this;
 
-	QMutex m;
+	auto generation = s_generation.load();
 	while( m_quit == false )
 	{
-		m.lock();
-		queueReadyWaitCond->wait( &m );
-		globalJobQueue.run();
-		m.unlock();
+		// stay awake for a short while as render stages usually follow
+		// each other closely, then sleep until the next stage starts
+		for (auto i = 0u; i < SPIN_ROUNDS && s_generation.load() == generation; ++i)
+		{
+			cpuRelax();
+		}
+		s_generation.wait(generation);
+		generation = s_generation.load();
+
+		globalJobQueue.run(this);
 	}
 }
 
@@ -1,5 +1,5 @@
 /*
- * AudioResampler.cpp - wrapper for libsamplerate
+ * AudioResampler.cpp - lightweight streaming resampler
  *
  * Copyright (c) 2023 saker <sakertooth@gmail.com>
  *
@@ -24,46 +24,454 @@
 
 #include "AudioResampler.h"
 
-#include <samplerate.h>
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define LMMS_AUDIO_RESAMPLER_X86
+#	define LMMS_AUDIO_RESAMPLER_TARGET(isa) __attribute__((target(isa)))
+#	include <immintrin.h>
+#elif defined(_M_X64)
+#	define LMMS_AUDIO_RESAMPLER_SSE2_ONLY
+#	define LMMS_AUDIO_RESAMPLER_TARGET(isa)
+#	include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#	define LMMS_AUDIO_RESAMPLER_NEON
+#	include <arm_neon.h>
+#endif
+
+#include "MixHelpers.h"
+#include "lmms_constants.h"
 
 namespace lmms {
 
+namespace {
+
+//! Table points per input frame for the sinc and per window length for the Kaiser window
+constexpr int SincResolution = 256;
+constexpr int WindowResolution = 4096;
+constexpr double KaiserBeta = 8.0;
+//! Phases of the filter bank per input frame
+constexpr int FilterBankPhases = 256;
+
+//! Zeroth order modified Bessel function of the first kind
+auto besselI0(double x) -> double
+{
+	auto sum = 1.0;
+	auto term = 1.0;
+	for (int k = 1; k < 64 && term > sum * 1e-12; ++k)
+	{
+		const auto factor = x / (2.0 * k);
+		term *= factor * factor;
+		sum += term;
+	}
+	return sum;
+}
+
+struct SincTables
+{
+	// both tables have a guard point so lookups at the end can interpolate
+	std::vector<float> sinc;
+	std::vector<float> window;
+
+	SincTables()
+		: sinc(AudioResampler::MaxTaps / 2 * SincResolution + 2)
+		, window(WindowResolution + 2)
+	{
+		for (auto i = std::size_t{0}; i < sinc.size(); ++i)
+		{
+			const auto x = D_PI * static_cast<double>(i) / SincResolution;
+			sinc[i] = i == 0 ? 1.f : static_cast<float>(std::sin(x) / x);
+		}
+
+		const auto norm = besselI0(KaiserBeta);
+		for (auto i = std::size_t{0}; i < window.size(); ++i)
+		{
+			const auto u = std::min(1.0, static_cast<double>(i) / WindowResolution);
+			window[i] = static_cast<float>(besselI0(KaiserBeta * std::sqrt(1.0 - u * u)) / norm);
+		}
+	}
+
+	static auto lookup(const std::vector<float>& table, float index) -> float
+	{
+		const auto i = static_cast<std::size_t>(index);
+		const auto frac = index - static_cast<float>(i);
+		return table[i] + frac * (table[i + 1] - table[i]);
+	}
+
+	static auto instance() -> const SincTables&
+	{
+		static const auto s_tables = SincTables{};
+		return s_tables;
+	}
+};
+
+//! Coefficient of the Kaiser-windowed sinc for a tap \p distance input frames away from the output frame
+auto windowedSinc(double distance, double cutoff, int half) -> double
+{
+	if (distance >= half) { return 0.0; }
+	const auto x = D_PI * distance * cutoff;
+	const auto sinc = x == 0.0 ? 1.0 : std::sin(x) / x;
+	const auto u = distance / half;
+	return sinc * besselI0(KaiserBeta * std::sqrt(1.0 - u * u)) / besselI0(KaiserBeta);
+}
+
+// Dot products of the coefficients with both channels of the window. The vectorized versions are
+// picked at run time, following the instruction set MixHelpers dispatches to.
+
+void dotProductScalar(const float* coeffs, const float* left, const float* right, int taps,
+	float& outLeft, float& outRight)
+{
+	auto sumLeft = 0.f;
+	auto sumRight = 0.f;
+	for (int i = 0; i < taps; ++i)
+	{
+		sumLeft += coeffs[i] * left[i];
+		sumRight += coeffs[i] * right[i];
+	}
+	outLeft = sumLeft;
+	outRight = sumRight;
+}
+
+#if defined(LMMS_AUDIO_RESAMPLER_X86) || defined(LMMS_AUDIO_RESAMPLER_SSE2_ONLY)
+
+LMMS_AUDIO_RESAMPLER_TARGET("sse2")
+void dotProductSse2(const float* coeffs, const float* left, const float* right, int taps,
+	float& outLeft, float& outRight)
+{
+	int i = 0;
+	auto accLeft = _mm_setzero_ps();
+	auto accRight = _mm_setzero_ps();
+	for (; i + 4 <= taps; i += 4)
+	{
+		const auto c = _mm_load_ps(coeffs + i);
+		accLeft = _mm_add_ps(accLeft, _mm_mul_ps(c, _mm_loadu_ps(left + i)));
+		accRight = _mm_add_ps(accRight, _mm_mul_ps(c, _mm_loadu_ps(right + i)));
+	}
+	alignas(16) float partial[4];
+	auto sumLeft = 0.f;
+	auto sumRight = 0.f;
+	_mm_store_ps(partial, accLeft);
+	for (auto p : partial) { sumLeft += p; }
+	_mm_store_ps(partial, accRight);
+	for (auto p : partial) { sumRight += p; }
+	for (; i < taps; ++i)
+	{
+		sumLeft += coeffs[i] * left[i];
+		sumRight += coeffs[i] * right[i];
+	}
+	outLeft = sumLeft;
+	outRight = sumRight;
+}
+
+#endif // LMMS_AUDIO_RESAMPLER_X86 || LMMS_AUDIO_RESAMPLER_SSE2_ONLY
+
+#ifdef LMMS_AUDIO_RESAMPLER_X86
+
+LMMS_AUDIO_RESAMPLER_TARGET("avx2")
+void dotProductAvx2(const float* coeffs, const float* left, const float* right, int taps,
+	float& outLeft, float& outRight)
+{
+	int i = 0;
+	auto accLeft = _mm256_setzero_ps();
+	auto accRight = _mm256_setzero_ps();
+	for (; i + 8 <= taps; i += 8)
+	{
+		const auto c = _mm256_load_ps(coeffs + i);
+		accLeft = _mm256_add_ps(accLeft, _mm256_mul_ps(c, _mm256_loadu_ps(left + i)));
+		accRight = _mm256_add_ps(accRight, _mm256_mul_ps(c, _mm256_loadu_ps(right + i)));
+	}
+	alignas(32) float partial[8];
+	auto sumLeft = 0.f;
+	auto sumRight = 0.f;
+	_mm256_store_ps(partial, accLeft);
+	for (auto p : partial) { sumLeft += p; }
+	_mm256_store_ps(partial, accRight);
+	for (auto p : partial) { sumRight += p; }
+	// avoid the AVX-SSE transition penalty in the scalar tail
+	_mm256_zeroupper();
+	for (; i < taps; ++i)
+	{
+		sumLeft += coeffs[i] * left[i];
+		sumRight += coeffs[i] * right[i];
+	}
+	outLeft = sumLeft;
+	outRight = sumRight;
+}
+
+#endif // LMMS_AUDIO_RESAMPLER_X86
+
+#ifdef LMMS_AUDIO_RESAMPLER_NEON
+
+void dotProductNeon(const float* coeffs, const float* left, const float* right, int taps,
+	float& outLeft, float& outRight)
+{
+	int i = 0;
+	auto accLeft = vdupq_n_f32(0.f);
+	auto accRight = vdupq_n_f32(0.f);
+	for (; i + 4 <= taps; i += 4)
+	{
+		const auto c = vld1q_f32(coeffs + i);
+		accLeft = vmlaq_f32(accLeft, c, vld1q_f32(left + i));
+		accRight = vmlaq_f32(accRight, c, vld1q_f32(right + i));
+	}
+	float partial[4];
+	auto sumLeft = 0.f;
+	auto sumRight = 0.f;
+	vst1q_f32(partial, accLeft);
+	for (auto p : partial) { sumLeft += p; }
+	vst1q_f32(partial, accRight);
+	for (auto p : partial) { sumRight += p; }
+	for (; i < taps; ++i)
+	{
+		sumLeft += coeffs[i] * left[i];
+		sumRight += coeffs[i] * right[i];
+	}
+	outLeft = sumLeft;
+	outRight = sumRight;
+}
+
+#endif // LMMS_AUDIO_RESAMPLER_NEON
+
+//! Returns the dot product matching the instruction set the mixing kernels currently use
+auto dotProductFor(MixHelpers::InstructionSet set) -> AudioResampler::DotProduct
+{
+	using MixHelpers::InstructionSet;
+	switch (set)
+	{
+#ifdef LMMS_AUDIO_RESAMPLER_X86
+	// MixHelpers only picks these if the CPU supports them; 32 taps are too few for AVX-512 to pay off
+	case InstructionSet::AVX512:
+	case InstructionSet::AVX2:
+		return &dotProductAvx2;
+	case InstructionSet::SSE2:
+		return &dotProductSse2;
+#elif defined(LMMS_AUDIO_RESAMPLER_SSE2_ONLY)
+	case InstructionSet::SSE2:
+		return &dotProductSse2;
+#elif defined(LMMS_AUDIO_RESAMPLER_NEON)
+	case InstructionSet::NEON:
+		return &dotProductNeon;
+#endif
+	default:
+		return &dotProductScalar;
+	}
+}
+
+} // namespace
+
+//! Normalized coefficients for FilterBankPhases + 1 positions between two input frames, the
+//! last one being the first one of the next frame, so a position can be interpolated between
+//! two phases
+struct AudioResampler::FilterBank
+{
+	struct alignas(32) Phase
+	{
+		std::array<float, MaxTaps> coeffs = {};
+	};
+
+	std::vector<Phase> phases;
+
+	FilterBank(int taps, float cutoff)
+		: phases(FilterBankPhases + 1)
+	{
+		const auto half = taps / 2;
+		for (int phase = 0; phase <= FilterBankPhases; ++phase)
+		{
+			const auto position = static_cast<double>(phase) / FilterBankPhases;
+			auto& coeffs = phases[phase].coeffs;
+			auto sum = 0.0;
+			for (int i = 0; i < taps; ++i)
+			{
+				const auto coeff = windowedSinc(std::abs(i - half + 1 - position), cutoff, half);
+				coeffs[i] = static_cast<float>(coeff);
+				sum += coeff;
+			}
+			for (int i = 0; i < taps; ++i)
+			{
+				coeffs[i] = static_cast<float>(coeffs[i] / sum);
+			}
+		}
+	}
+
+	//! Returns the bank of the given quality, the banks are built on first use
+	static auto instance(int taps, float rolloff) -> const FilterBank&
+	{
+		if (taps == MaxTaps)
+		{
+			static const auto s_best = FilterBank{taps, rolloff};
+			return s_best;
+		}
+		static const auto s_medium = FilterBank{taps, rolloff};
+		return s_medium;
+	}
+};
+
 AudioResampler::AudioResampler(int interpolationMode, int channels)
 	: m_interpolationMode(interpolationMode)
 	, m_channels(channels)
-	, m_state(src_new(interpolationMode, channels, &m_error))
 {
-	if (!m_state)
+	if (channels != 1 && channels != 2)
 	{
-		const auto errorMessage = std::string{src_strerror(m_error)};
-		const auto fullMessage = std::string{"Failed to create an AudioResampler: "} + errorMessage;
-		throw std::runtime_error{fullMessage};
+		throw std::runtime_error{"Failed to create an AudioResampler: unsupported channel count "
+			+ std::to_string(channels)};
 	}
-}
 
-AudioResampler::~AudioResampler()
-{
-	src_delete(m_state);
+	switch (interpolationMode)
+	{
+	case SRC_ZERO_ORDER_HOLD: m_kernel = Kernel::Hold; m_taps = 2; break;
+	case SRC_LINEAR: m_kernel = Kernel::Linear; m_taps = 2; break;
+	case SRC_SINC_FASTEST: m_kernel = Kernel::Cubic; m_taps = 4; break;
+	case SRC_SINC_MEDIUM_QUALITY: m_kernel = Kernel::Sinc; m_taps = 16; m_rolloff = 0.95f; break;
+	case SRC_SINC_BEST_QUALITY: m_kernel = Kernel::Sinc; m_taps = MaxTaps; m_rolloff = 0.97f; break;
+	default:
+		throw std::runtime_error{"Failed to create an AudioResampler: unknown interpolation mode "
+			+ std::to_string(interpolationMode)};
+	}
+
+	// make sure the tables are not built on the audio thread
+	if (m_kernel == Kernel::Sinc)
+	{
+		SincTables::instance();
+		m_filterBank = &FilterBank::instance(m_taps, m_rolloff);
+	}
+
+	reset();
 }
 
 auto AudioResampler::resample(const float* in, long inputFrames, float* out, long outputFrames, double ratio)
 	-> ProcessResult
 {
-	auto data = SRC_DATA{};
-	data.data_in = in;
-	data.input_frames = inputFrames;
-	data.data_out = out;
-	data.output_frames = outputFrames;
-	data.src_ratio = ratio;
-	data.end_of_input = 0;
-	return {src_process(m_state, &data), data.input_frames_used, data.output_frames_gen};
+	const auto step = 1.0 / ratio;
+	const auto cutoff = m_rolloff * static_cast<float>(std::min(ratio, 1.0));
+
+	const auto dotProduct = m_kernel == Kernel::Sinc
+		? dotProductFor(MixHelpers::instructionSet())
+		: &dotProductScalar;
+
+	long inputUsed = 0;
+	long outputGenerated = 0;
+	while (outputGenerated < outputFrames)
+	{
+		while (m_position >= 1.0)
+		{
+			if (inputUsed == inputFrames) { return {0, inputUsed, outputGenerated}; }
+
+			if (m_channels == 2) { push(in[2 * inputUsed], in[2 * inputUsed + 1]); }
+			else { push(in[inputUsed], in[inputUsed]); }
+
+			++inputUsed;
+			m_position -= 1.0;
+		}
+
+		auto left = 0.f;
+		auto right = 0.f;
+		interpolate(static_cast<float>(m_position), cutoff, dotProduct, left, right);
+
+		if (m_channels == 2)
+		{
+			out[2 * outputGenerated] = left;
+			out[2 * outputGenerated + 1] = right;
+		}
+		else { out[outputGenerated] = left; }
+
+		++outputGenerated;
+		m_position += step;
+	}
+
+	return {0, inputUsed, outputGenerated};
+}
+
+void AudioResampler::reset()
+{
+	m_left.fill(0.f);
+	m_right.fill(0.f);
+	m_writePos = 0;
+	// consume enough input so the first input frame lands right before the
+	// middle of the window
+	m_position = m_taps / 2 + 1;
 }
 
-void AudioResampler::setRatio(double ratio)
+void AudioResampler::push(float left, float right)
 {
-	src_set_ratio(m_state, ratio);
+	m_left[m_writePos] = m_left[m_writePos + m_taps] = left;
+	m_right[m_writePos] = m_right[m_writePos + m_taps] = right;
+	if (++m_writePos == m_taps) { m_writePos = 0; }
+}
+
+void AudioResampler::interpolate(float position, float cutoff, DotProduct dotProduct,
+	float& left, float& right) const
+{
+	// oldest frame first, position is relative to l[half - 1]
+	const auto* l = m_left.data() + m_writePos;
+	const auto* r = m_right.data() + m_writePos;
+
+	switch (m_kernel)
+	{
+	case Kernel::Hold:
+		left = l[0];
+		right = r[0];
+		break;
+	case Kernel::Linear:
+		left = l[0] + position * (l[1] - l[0]);
+		right = r[0] + position * (r[1] - r[0]);
+		break;
+	case Kernel::Cubic:
+	{
+		const auto hermite = [position](const float* x) {
+			const auto c1 = 0.5f * (x[2] - x[0]);
+			const auto c2 = x[0] - 2.5f * x[1] + 2.f * x[2] - 0.5f * x[3];
+			const auto c3 = 0.5f * (x[3] - x[0]) + 1.5f * (x[1] - x[2]);
+			return ((c3 * position + c2) * position + c1) * position + x[1];
+		};
+		left = hermite(l);
+		right = hermite(r);
+		break;
+	}
+	case Kernel::Sinc:
+	{
+		if (cutoff == m_rolloff)
+		{
+			// the bank was built for this cutoff, interpolate between the two nearest phases
+			const auto index = position * FilterBankPhases;
+			const auto phase = std::min(static_cast<int>(index), FilterBankPhases - 1);
+			const auto frac = index - static_cast<float>(phase);
+			auto left1 = 0.f;
+			auto right1 = 0.f;
+			dotProduct(m_filterBank->phases[phase].coeffs.data(), l, r, m_taps, left, right);
+			dotProduct(m_filterBank->phases[phase + 1].coeffs.data(), l, r, m_taps, left1, right1);
+			left += frac * (left1 - left);
+			right += frac * (right1 - right);
+			break;
+		}
+
+		const auto& tables = SincTables::instance();
+		const auto half = m_taps / 2;
+		const auto windowScale = static_cast<float>(WindowResolution) / half;
+		const auto sincScale = cutoff * SincResolution;
+
+		alignas(32) std::array<float, MaxTaps> coeffs;
+		auto sum = 0.f;
+		for (int i = 0; i < m_taps; ++i)
+		{
+			const auto distance = std::abs(static_cast<float>(i - half + 1) - position);
+			const auto coeff = distance >= half
+				? 0.f
+				: SincTables::lookup(tables.sinc, distance * sincScale)
+					* SincTables::lookup(tables.window, distance * windowScale);
+			coeffs[i] = coeff;
+			sum += coeff;
+		}
+
+		dotProduct(coeffs.data(), l, r, m_taps, left, right);
+		left /= sum;
+		right /= sum;
+		break;
+	}
+	}
 }
 
 } // namespace lmms
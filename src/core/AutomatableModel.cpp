@@ -24,19 +24,93 @@
 
 #include "AutomatableModel.h"
 
+#include <algorithm>
+
 #include "lmms_math.h"
 
 #include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
 #include "AutomationClip.h"
 #include "ControllerConnection.h"
 #include "LocaleHelper.h"
 #include "ProjectJournal.h"
 #include "Song.h"
+#include "ThreadableJob.h"
 
 namespace lmms
 {
 
-long AutomatableModel::s_periodCounter = 0;
+std::atomic<long> AutomatableModel::s_periodCounter = 0;
+bool AutomatableModel::s_pipelined = false;
+std::vector<AutomatableModel*> AutomatableModel::s_controlledModels;
+std::atomic<AutomatableModel*> AutomatableModel::s_queuedModels{nullptr};
+
+
+namespace
+{
+
+//! Computes the value buffers of a slice of the models to update
+class ValueBufferJob : public ThreadableJob
+{
+public:
+	void setModels( AutomatableModel* const* begin, AutomatableModel* const* end, void (*update)(AutomatableModel*) )
+	{
+		m_begin = begin;
+		m_end = end;
+		m_update = update;
+	}
+
+	bool requiresProcessing() const override
+	{
+		return m_begin != m_end;
+	}
+
+protected:
+	void doProcessing() override
+	{
+		for( auto it = m_begin; it != m_end; ++it )
+		{
+			m_update( *it );
+		}
+	}
+
+private:
+	AutomatableModel* const* m_begin = nullptr;
+	AutomatableModel* const* m_end = nullptr;
+	void (*m_update)(AutomatableModel*) = nullptr;
+};
+
+//! below this many models per job, the workers cost more than they save
+constexpr std::size_t MinModelsPerJob = 64;
+constexpr std::size_t MaxValueBufferJobs = 16;
+
+std::vector<AutomatableModel*> s_modelsToUpdate;
+ValueBufferJob s_valueBufferJobs[MaxValueBufferJobs];
+//! number of existing models, each of them can be queued once
+std::atomic<std::size_t> s_modelCount = 0;
+
+//! Make room for \p count models in s_modelsToUpdate, so updateValueBuffers() doesn't allocate.
+//! Grows in large steps, so the audio engine rarely has to be locked for it.
+void reserveModelsToUpdate( std::size_t count )
+{
+	if( count <= s_modelsToUpdate.capacity() ) { return; }
+
+	AudioEngine* engine = Engine::audioEngine();
+	if( engine ) { engine->requestChangeInModel(); }
+	s_modelsToUpdate.reserve( std::max( count, 2 * s_modelsToUpdate.capacity() ) );
+	if( engine ) { engine->doneChangeInModel(); }
+}
+
+//! whether this thread processes the period before the current one
+thread_local bool t_readsPreviousPeriod = false;
+
+//! slot of the value buffers a period is kept in
+int periodSlot( long period )
+{
+	return static_cast<int>( period & 1 );
+}
+
+} // namespace
 
 
 
@@ -54,13 +128,24 @@ AutomatableModel::AutomatableModel(
 	m_setValueDepth( 0 ),
 	m_hasStrictStepSize( false ),
 	m_controllerConnection( nullptr ),
-	m_valueBuffer( static_cast<int>( Engine::audioEngine()->framesPerPeriod() ) ),
-	m_lastUpdatedPeriod( -1 ),
-	m_hasSampleExactData(false),
+	m_valueBuffers{ ValueBuffer( static_cast<int>( Engine::audioEngine()->framesPerPeriod() ) ),
+		ValueBuffer( static_cast<int>( Engine::audioEngine()->framesPerPeriod() ) ) },
+	m_lastUpdatedPeriods{ -1, -1 },
+	m_hasSampleExactData{ false, false },
+	m_periodValues{},
+	m_heldValue( 0 ),
+	m_hasHeldValue( false ),
+	m_isControlled(false),
+	m_valueBufferQueued(false),
+	m_nextQueued(nullptr),
 	m_useControllerValue(true)
 
 {
 	m_value = fittedValue( val );
+
+	// the controlled models and the queued ones, which can be any model
+	reserveModelsToUpdate( s_controlledModels.size() + ++s_modelCount );
+
 	setInitValue( val );
 }
 
@@ -78,9 +163,29 @@ AutomatableModel::~AutomatableModel()
 	if( m_controllerConnection )
 	{
 		delete m_controllerConnection;
+		m_controllerConnection = nullptr;
+	}
+
+	updateControlRegistration();
+
+	if( m_valueBufferQueued.load() )
+	{
+		// take ourselves out of the queue before the audio engine sees a dangling pointer
+		AudioEngine* engine = Engine::audioEngine();
+		if( engine ) { engine->requestChangeInModel(); }
+		AutomatableModel* model = s_queuedModels.exchange( nullptr );
+		while( model )
+		{
+			AutomatableModel* next = model->m_nextQueued;
+			model->m_valueBufferQueued = false;
+			if( model != this ) { model->queueValueBufferUpdate(); }
+			model = next;
+		}
+		if( engine ) { engine->doneChangeInModel(); }
 	}
 
-	m_valueBuffer.clear();
+	for( auto& buffer : m_valueBuffers ) { buffer.clear(); }
+	--s_modelCount;
 
 	emit destroyed( id() );
 }
@@ -298,6 +403,7 @@ void AutomatableModel::setValue( const float value )
 	++m_setValueDepth;
 	const float old_val = m_value;
 
+	holdValueForPreviousPeriod();
 	m_value = fittedValue( value );
 	if( old_val != m_value )
 	{
@@ -315,6 +421,7 @@ void AutomatableModel::setValue( const float value )
 			}
 		}
 		m_valueChanged = true;
+		queueValueBufferUpdate();
 		emit dataChanged();
 	}
 	else
@@ -370,6 +477,7 @@ void AutomatableModel::setAutomatedValue( const float value )
 
 	const float scaled_value = scaledValue( value );
 
+	holdValueForPreviousPeriod();
 	m_value = fittedValue( scaled_value );
 
 	if( oldValue != m_value )
@@ -384,6 +492,7 @@ void AutomatableModel::setAutomatedValue( const float value )
 			}
 		}
 		m_valueChanged = true;
+		queueValueBufferUpdate();
 		emit dataChanged();
 	}
 	--m_setValueDepth;
@@ -392,6 +501,36 @@ void AutomatableModel::setAutomatedValue( const float value )
 
 
 
+void AutomatableModel::setAutomatedValueBlock( const float* values, f_cnt_t offset, f_cnt_t frames )
+{
+	const long period = periodCounter();
+	const int slot = periodSlot( period );
+	float* buffer = m_valueBuffers[slot].values();
+	const auto length = static_cast<f_cnt_t>( m_valueBuffers[slot].length() );
+	frames = std::min( frames, length - std::min( offset, length ) );
+	if( frames == 0 ) { return; }
+
+	if( m_lastUpdatedPeriods[slot] != period || !m_hasSampleExactData[slot] )
+	{
+		// first block in this period, the frames before it keep the current value
+		holdPreviousPeriod();
+		std::fill( buffer, buffer + offset, m_value );
+	}
+
+	for( f_cnt_t i = 0; i < frames; ++i )
+	{
+		buffer[offset + i] = fittedValue( scaledValue( values[i] ) );
+	}
+	std::fill( buffer + offset + frames, buffer + length, buffer[offset + frames - 1] );
+
+	m_lastUpdatedPeriods[slot] = period;
+	m_hasSampleExactData[slot] = true;
+	m_periodValues[slot] = m_value;
+}
+
+
+
+
 void AutomatableModel::setRange( const float min, const float max,
 							const float step )
 {
@@ -464,6 +603,7 @@ void AutomatableModel::linkModel( AutomatableModel* model )
 	if (!containsModel && model != this)
 	{
 		m_linkedModels.push_back( model );
+		updateControlRegistration();
 
 		if( !model->hasLinkedModels() )
 		{
@@ -482,6 +622,7 @@ void AutomatableModel::unlinkModel( AutomatableModel* model )
 	if( it != m_linkedModels.end() )
 	{
 		m_linkedModels.erase( it );
+		updateControlRegistration();
 	}
 }
 
@@ -496,7 +637,9 @@ void AutomatableModel::linkModels( AutomatableModel* model1, AutomatableModel* m
 	if (!model1ContainsModel2 && model1 != model2)
 	{
 		// copy data
+		model1->holdValueForPreviousPeriod();
 		model1->m_value = model2->m_value;
+		model1->queueValueBufferUpdate();
 		if (model1->valueBuffer() && model2->valueBuffer())
 		{
 			std::copy_n(model2->valueBuffer()->data(),
@@ -538,6 +681,7 @@ void AutomatableModel::unlinkAllModels()
 void AutomatableModel::setControllerConnection( ControllerConnection* c )
 {
 	m_controllerConnection = c;
+	updateControlRegistration();
 	if( c )
 	{
 		QObject::connect( m_controllerConnection, SIGNAL(valueChanged()),
@@ -587,17 +731,106 @@ float AutomatableModel::controllerValue( int frameOffset ) const
 }
 
 
-ValueBuffer * AutomatableModel::valueBuffer()
+float AutomatableModel::pipelinedValue( int frameOffset ) const
 {
-	QMutexLocker m( &m_valueBufferMutex );
-	// if we've already calculated the valuebuffer this period, return the cached buffer
-	if( m_lastUpdatedPeriod == s_periodCounter )
+	if( !t_readsPreviousPeriod ) { return currentValue( frameOffset ); }
+
+	const long period = periodCounter() - 1;
+	const int slot = periodSlot( period );
+	if( m_lastUpdatedPeriods[slot] != period )
 	{
-		return m_hasSampleExactData
-			? &m_valueBuffer
-			: nullptr;
+		// nothing has changed since the previous period, except for what has
+		// been written since this one was set up
+		return m_hasHeldValue.load( std::memory_order_acquire ) ? m_heldValue : currentValue( frameOffset );
 	}
 
+	const bool controlled = ( m_controllerConnection && m_useControllerValue ) || hasLinkedModels();
+	return controlled && m_hasSampleExactData[slot]
+		? m_valueBuffers[slot].value( frameOffset )
+		: m_periodValues[slot];
+}
+
+
+
+
+ValueBuffer * AutomatableModel::valueBuffer()
+{
+	// models without an up to date buffer had nothing sample-exact to offer
+	// when updateValueBuffers() ran
+	const long period = s_pipelined && t_readsPreviousPeriod ? periodCounter() - 1 : periodCounter();
+	const int slot = periodSlot( period );
+	return m_lastUpdatedPeriods[slot] == period && m_hasSampleExactData[slot]
+		? &m_valueBuffers[slot]
+		: nullptr;
+}
+
+
+
+
+AutomatableModel::PreviousPeriodScope::PreviousPeriodScope() :
+	m_wasPrevious( t_readsPreviousPeriod )
+{
+	t_readsPreviousPeriod = s_pipelined;
+}
+
+
+
+
+AutomatableModel::PreviousPeriodScope::~PreviousPeriodScope()
+{
+	t_readsPreviousPeriod = m_wasPrevious;
+}
+
+
+
+
+void AutomatableModel::holdValueForPreviousPeriod()
+{
+	if( !s_pipelined || m_hasHeldValue.load( std::memory_order_relaxed ) ) { return; }
+
+	m_heldValue = m_value;
+	m_hasHeldValue.store( true, std::memory_order_release );
+	// the audio thread must not see the new value before the held one
+	std::atomic_thread_fence( std::memory_order_release );
+}
+
+
+
+
+void AutomatableModel::holdPreviousPeriod()
+{
+	const bool held = m_hasHeldValue.load( std::memory_order_acquire );
+	const float value = held ? m_heldValue : m_value;
+	m_hasHeldValue.store( false, std::memory_order_relaxed );
+	if( !s_pipelined ) { return; }
+
+	const long previous = periodCounter() - 1;
+	const int slot = periodSlot( previous );
+	if( m_lastUpdatedPeriods[slot] == previous ) { return; }
+
+	m_periodValues[slot] = value;
+	m_hasSampleExactData[slot] = false;
+	m_lastUpdatedPeriods[slot] = previous;
+}
+
+
+
+
+void AutomatableModel::updateValueBuffer()
+{
+	// updateValueBuffers() computes every model once, from one thread, so no lock is needed
+	const long period = periodCounter();
+	const int slot = periodSlot( period );
+	// if we've already calculated the valuebuffer this period, keep it
+	if( m_lastUpdatedPeriods[slot] == period ) { return; }
+
+	// whatever the previous period saw has to outlive this update
+	holdPreviousPeriod();
+
+	ValueBuffer& valueBuffer = m_valueBuffers[slot];
+	m_lastUpdatedPeriods[slot] = period;
+	m_hasSampleExactData[slot] = true;
+
 	float val = m_value; // make sure our m_value doesn't change midway
 
 	if (m_controllerConnection && m_useControllerValue && m_controllerConnection->getController()->isSampleExact())
@@ -606,29 +839,28 @@ ValueBuffer * AutomatableModel::valueBuffer()
 		if( vb )
 		{
 			float * values = vb->values();
-			float * nvalues = m_valueBuffer.values();
+			float * nvalues = valueBuffer.values();
 			switch( m_scaleType )
 			{
 			case ScaleType::Linear:
-				for( int i = 0; i < m_valueBuffer.length(); i++ )
+				for( int i = 0; i < valueBuffer.length(); i++ )
 				{
 					nvalues[i] = minValue<float>() + ( range() * values[i] );
 				}
 				break;
 			case ScaleType::Logarithmic:
-				for( int i = 0; i < m_valueBuffer.length(); i++ )
+				for( int i = 0; i < valueBuffer.length(); i++ )
 				{
 					nvalues[i] = logToLinearScale( values[i] );
 				}
 				break;
 			default:
-				qFatal("AutomatableModel::valueBuffer() "
+				qFatal("AutomatableModel::updateValueBuffer() "
 					"lacks implementation for a scale type");
 				break;
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
-			m_hasSampleExactData = true;
-			return &m_valueBuffer;
+			m_periodValues[slot] = currentValue( 0 );
+			return;
 		}
 	}
 
@@ -642,33 +874,114 @@ ValueBuffer * AutomatableModel::valueBuffer()
 		if (lm && lm->controllerConnection() && lm->useControllerValue() &&
 				lm->controllerConnection()->getController()->isSampleExact())
 		{
-			auto vb = lm->valueBuffer();
-			float * values = vb->values();
-			float * nvalues = m_valueBuffer.values();
-			for (int i = 0; i < vb->length(); i++)
+			// models with a controller connection have been computed before this one
+			if (auto vb = lm->valueBuffer())
 			{
-				nvalues[i] = fittedValue(values[i]);
+				float * values = vb->values();
+				float * nvalues = valueBuffer.values();
+				for (int i = 0; i < vb->length(); i++)
+				{
+					nvalues[i] = fittedValue(values[i]);
+				}
+				m_periodValues[slot] = currentValue( 0 );
+				return;
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
-			m_hasSampleExactData = true;
-			return &m_valueBuffer;
 		}
 	}
 
+	m_periodValues[slot] = currentValue( 0 );
+
 	if( m_oldValue != val )
 	{
-		m_valueBuffer.interpolate( m_oldValue, val );
+		valueBuffer.interpolate( m_oldValue, val );
 		m_oldValue = val;
-		m_lastUpdatedPeriod = s_periodCounter;
-		m_hasSampleExactData = true;
-		return &m_valueBuffer;
+		return;
 	}
 
-	// if we have no sample-exact source for a ValueBuffer, return NULL to signify that no data is available at the moment
-	// in which case the recipient knows to use the static value() instead
-	m_lastUpdatedPeriod = s_periodCounter;
-	m_hasSampleExactData = false;
-	return nullptr;
+	// if we have no sample-exact source for a ValueBuffer, valueBuffer() returns NULL to signify that no data
+	// is available at the moment in which case the recipient knows to use the static value() instead
+	m_hasSampleExactData[slot] = false;
+}
+
+
+
+
+void AutomatableModel::queueValueBufferUpdate()
+{
+	if( m_valueBufferQueued.exchange( true ) ) { return; }
+
+	AutomatableModel* head = s_queuedModels.load();
+	do
+	{
+		m_nextQueued = head;
+	}
+	while( !s_queuedModels.compare_exchange_weak( head, this ) );
+}
+
+
+
+
+void AutomatableModel::updateControlRegistration()
+{
+	const bool controlled = m_controllerConnection || hasLinkedModels();
+	if( controlled == m_isControlled ) { return; }
+
+	AudioEngine* engine = Engine::audioEngine();
+	if( engine ) { engine->requestChangeInModel(); }
+	if( controlled )
+	{
+		s_controlledModels.push_back( this );
+		reserveModelsToUpdate( s_controlledModels.size() + s_modelCount );
+	}
+	else
+	{
+		s_controlledModels.erase( std::find( s_controlledModels.begin(), s_controlledModels.end(), this ) );
+	}
+	m_isControlled = controlled;
+	if( engine ) { engine->doneChangeInModel(); }
+}
+
+
+
+
+void AutomatableModel::updateValueBuffers()
+{
+	s_modelsToUpdate.assign( s_controlledModels.begin(), s_controlledModels.end() );
+	for( AutomatableModel* model = s_queuedModels.exchange( nullptr ); model; )
+	{
+		AutomatableModel* next = model->m_nextQueued;
+		model->m_valueBufferQueued = false;
+		// controlled models are in the list already
+		if( !model->m_isControlled ) { s_modelsToUpdate.push_back( model ); }
+		model = next;
+	}
+
+	// linked models copy the buffer of a partner with a controller connection,
+	// so these partners are computed in a pass of their own first
+	const auto linked = std::partition( s_modelsToUpdate.begin(), s_modelsToUpdate.end(),
+		[]( const AutomatableModel* model ) { return model->m_controllerConnection != nullptr; } );
+
+	const auto update = []( AutomatableModel* model ) { model->updateValueBuffer(); };
+	const auto updateModels = [&update]( AutomatableModel* const* models, std::size_t count )
+	{
+		const std::size_t jobs = std::min( count / MinModelsPerJob, MaxValueBufferJobs );
+		if( jobs < 2 )
+		{
+			std::for_each( models, models + count, update );
+			return;
+		}
+
+		for( std::size_t i = 0; i < jobs; ++i )
+		{
+			s_valueBufferJobs[i].setModels( models + count * i / jobs, models + count * ( i + 1 ) / jobs, update );
+			AudioEngineWorkerThread::addJob( &s_valueBufferJobs[i] );
+		}
+		AudioEngineWorkerThread::startAndWaitForJobs();
+	};
+
+	const auto connected = static_cast<std::size_t>( linked - s_modelsToUpdate.begin() );
+	updateModels( s_modelsToUpdate.data(), connected );
+	updateModels( s_modelsToUpdate.data() + connected, s_modelsToUpdate.size() - connected );
 }
 
 
@@ -680,6 +993,7 @@ void AutomatableModel::unlinkControllerConnection()
 	}
 
 	m_controllerConnection = nullptr;
+	updateControlRegistration();
 }
 
 
@@ -28,14 +28,20 @@
 
 #include "AutomationNode.h"
 #include "AutomationClipView.h"
+#include "AutomationTimeline.h"
 #include "AutomationTrack.h"
+#include "Engine.h"
 #include "LocaleHelper.h"
 #include "Note.h"
 #include "PatternStore.h"
 #include "ProjectJournal.h"
 #include "Song.h"
 
+#include <QTimer>
+
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace lmms
 {
@@ -44,6 +50,63 @@ int AutomationClip::s_quantization = 1;
 const float AutomationClip::DEFAULT_MIN_VALUE = 0;
 const float AutomationClip::DEFAULT_MAX_VALUE = 1;
 
+namespace
+{
+
+//! Replaced snapshots of all clips and the period they were replaced in. They
+//! outlive their clips, since the audio thread may still read them.
+struct RetiredSnapshots
+{
+	~RetiredSnapshots()
+	{
+		for (const auto& [period, snapshot] : snapshots)
+		{
+			delete snapshot;
+		}
+	}
+
+	QMutex mutex;
+	std::vector<std::pair<long, const AutomationClip::Snapshot*>> snapshots;
+	bool cleanupScheduled = false;
+};
+
+RetiredSnapshots s_retiredSnapshots;
+
+//! Call with s_retiredSnapshots.mutex held
+void freeRetiredSnapshots()
+{
+	// valueAt() and fillBlock() load the snapshot on every call, but each call
+	// returns within the period it started in. So after the period counter
+	// moved on twice, nobody is using a snapshot replaced before.
+	const auto period = AutomatableModel::periodCounter();
+	auto& snapshots = s_retiredSnapshots.snapshots;
+	snapshots.erase(std::remove_if(snapshots.begin(), snapshots.end(),
+		[period](const auto& retired) {
+			if (retired.first + 2 > period) { return false; }
+			delete retired.second;
+			return true;
+		}), snapshots.end());
+}
+
+//! Call with s_retiredSnapshots.mutex held
+void scheduleSnapshotCleanup()
+{
+	if (s_retiredSnapshots.cleanupScheduled || s_retiredSnapshots.snapshots.empty()) { return; }
+	s_retiredSnapshots.cleanupScheduled = true;
+
+	// free the replaced snapshots once the audio thread is done with them, instead of
+	// waiting for the next edit; retry while the audio engine is not advancing
+	constexpr auto CleanupIntervalMs = 500;
+	QTimer::singleShot(CleanupIntervalMs, [] {
+		QMutexLocker m(&s_retiredSnapshots.mutex);
+		s_retiredSnapshots.cleanupScheduled = false;
+		freeRetiredSnapshots();
+		scheduleSnapshotCleanup();
+	});
+}
+
+} // namespace
+
 
 AutomationClip::AutomationClip( AutomationTrack * _auto_track ) :
 	Clip( _auto_track ),
@@ -58,6 +121,7 @@ AutomationClip::AutomationClip( AutomationTrack * _auto_track ) :
 	m_isRecording( false ),
 	m_lastRecordedValue( 0 )
 {
+	updateSnapshot();
 	changeLength( TimePos( 1, 0 ) );
 	if( getTrack() )
 	{
@@ -87,7 +151,10 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 	m_autoTrack( _clip_to_copy.m_autoTrack ),
 	m_objects( _clip_to_copy.m_objects ),
 	m_tension( _clip_to_copy.m_tension ),
-	m_progressionType( _clip_to_copy.m_progressionType )
+	m_progressionType( _clip_to_copy.m_progressionType ),
+	m_dragging( false ),
+	m_isRecording( false ),
+	m_lastRecordedValue( 0 )
 {
 	// Locks the mutex of the copied AutomationClip to make sure it
 	// doesn't change while it's being copied
@@ -101,6 +168,7 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 		// Sets the node's clip to this one
 		m_timeMap[POS(it)].setClip(this);
 	}
+	updateSnapshot();
 	if (!getTrack()){ return; }
 	switch( getTrack()->trackContainer()->type() )
 	{
@@ -116,6 +184,14 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 	}
 }
 
+
+
+
+AutomationClip::~AutomationClip()
+{
+	retireSnapshot(m_snapshot.load());
+}
+
 bool AutomationClip::addObject( AutomatableModel * _obj, bool _search_dup )
 {
 	QMutexLocker m(&m_clipMutex);
@@ -133,6 +209,7 @@ bool AutomationClip::addObject( AutomatableModel * _obj, bool _search_dup )
 	}
 
 	m_objects.push_back(_obj);
+	AutomationTimeline::clipChanged(this);
 
 	connect( _obj, SIGNAL(destroyed(lmms::jo_id_t)),
 			this, SLOT(objectDestroyed(lmms::jo_id_t)),
@@ -156,6 +233,7 @@ void AutomationClip::setProgressionType(
 		_new_progression_type == ProgressionType::CubicHermite )
 	{
 		m_progressionType = _new_progression_type;
+		updateSnapshot();
 		emit dataChanged();
 	}
 }
@@ -173,6 +251,7 @@ void AutomationClip::setTension( QString _new_tension )
 	if( ok && nt > -0.01 && nt < 1.01 )
 	{
 		m_tension = nt;
+		updateSnapshot();
 	}
 }
 
@@ -457,7 +536,7 @@ void AutomationClip::recordValue(TimePos time, float value)
 		putValue( time, value, true );
 		m_lastRecordedValue = value;
 	}
-	else if( valueAt( time ) != value )
+	else if( timeMapValueAt( time ) != value )
 	{
 		removeNode(time);
 	}
@@ -551,6 +630,7 @@ TimePos AutomationClip::setDragValue(
 			it.value().setInTangent(m_dragInTan);
 			it.value().setOutTangent(m_dragOutTan);
 			it.value().setLockedTangents(true);
+			updateSnapshot();
 		}
 	}
 
@@ -574,6 +654,23 @@ void AutomationClip::applyDragValue()
 
 
 float AutomationClip::valueAt( const TimePos & _time ) const
+{
+	return m_snapshot.load(std::memory_order_acquire)->valueAt(_time);
+}
+
+
+
+
+void AutomationClip::fillBlock(float time, fpp_t frames, float* out) const
+{
+	const auto end = getAutoResize() ? std::numeric_limits<float>::max() : static_cast<float>(length());
+	m_snapshot.load(std::memory_order_acquire)->fill(time, 1.f / Engine::framesPerTick(), end, frames, out);
+}
+
+
+
+
+float AutomationClip::timeMapValueAt( const TimePos & _time ) const
 {
 	QMutexLocker m(&m_clipMutex);
 
@@ -616,21 +713,30 @@ float AutomationClip::valueAt( timeMap::const_iterator v, int offset ) const
 {
 	QMutexLocker m(&m_clipMutex);
 
+	const auto node = Snapshot::Node{POS(v), INVAL(v), OUTVAL(v), INTAN(v), OUTTAN(v)};
+	const auto next = Snapshot::Node{POS(v + 1), INVAL(v + 1), OUTVAL(v + 1), INTAN(v + 1), OUTTAN(v + 1)};
+	return Snapshot::segmentValue(node, next, offset, m_progressionType, m_tension);
+}
+
+
+
+
+float AutomationClip::Snapshot::segmentValue(const Node& node, const Node& next, float offset,
+	ProgressionType progressionType, float tension)
+{
 	// We never use it with offset 0, but doesn't hurt to return a correct
 	// value if we do
-	if (offset == 0) { return INVAL(v); }
+	if (offset == 0) { return node.inValue; }
 
-	if (m_progressionType == ProgressionType::Discrete)
+	if (progressionType == ProgressionType::Discrete)
 	{
-		return OUTVAL(v);
+		return node.outValue;
 	}
-	else if( m_progressionType == ProgressionType::Linear )
+	else if (progressionType == ProgressionType::Linear)
 	{
-		float slope =
-			(INVAL(v + 1) - OUTVAL(v))
-			/ (POS(v + 1) - POS(v));
+		float slope = (next.inValue - node.outValue) / (next.pos - node.pos);
 
-		return OUTVAL(v) + offset * slope;
+		return node.outValue + offset * slope;
 	}
 	else /* ProgressionType::CubicHermite */
 	{
@@ -642,16 +748,16 @@ float AutomationClip::valueAt( timeMap::const_iterator v, int offset ) const
 		// value: y.  To make this work we map the values of x that this
 		// segment spans to values of t for t = 0.0 -> 1.0 and scale the
 		// tangents _m1 and _m2
-		int numValues = (POS(v + 1) - POS(v));
-		float t = (float) offset / (float) numValues;
-		float m1 = OUTTAN(v) * numValues * m_tension;
-		float m2 = INTAN(v + 1) * numValues * m_tension;
+		int numValues = (next.pos - node.pos);
+		float t = offset / (float) numValues;
+		float m1 = node.outTangent * numValues * tension;
+		float m2 = next.inTangent * numValues * tension;
 
 		auto t2 = pow(t, 2);
 		auto t3 = pow(t, 3);
-		return (2 * t3 - 3 * t2 + 1) * OUTVAL(v)
+		return (2 * t3 - 3 * t2 + 1) * node.outValue
 			+ (t3 - 2 * t2 + t) * m1
-			+ (-2 * t3 + 3 * t2) * INVAL(v + 1)
+			+ (-2 * t3 + 3 * t2) * next.inValue
 			+ (t3 - t2) * m2;
 	}
 }
@@ -659,6 +765,95 @@ float AutomationClip::valueAt( timeMap::const_iterator v, int offset ) const
 
 
 
+float AutomationClip::Snapshot::valueAt(float time) const
+{
+	const auto next = std::lower_bound(nodes.begin(), nodes.end(), time,
+		[](const Node& node, float t) { return node.pos < t; });
+
+	// When the time is exactly the node's time, we want the inValue
+	if (next != nodes.end() && next->pos == time) { return next->inValue; }
+	if (next == nodes.begin()) { return 0; }
+	// When the time is after the last node, we want the outValue of it
+	if (next == nodes.end()) { return nodes.back().outValue; }
+
+	return segmentValue(*(next - 1), *next, time - (next - 1)->pos, progressionType, tension);
+}
+
+
+
+
+void AutomationClip::Snapshot::fill(float time, float step, float end, int frames, float* out) const
+{
+	if (nodes.empty())
+	{
+		std::fill(out, out + frames, 0.f);
+		return;
+	}
+
+	// same as valueAt(), but the lower bound only moves forward
+	auto next = std::lower_bound(nodes.begin(), nodes.end(), std::min(time, end),
+		[](const Node& node, float t) { return node.pos < t; });
+
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		const auto t = std::min(time + frame * step, end);
+		while (next != nodes.end() && next->pos < t) { ++next; }
+
+		if (next != nodes.end() && next->pos == t) { out[frame] = next->inValue; }
+		else if (next == nodes.begin()) { out[frame] = 0; }
+		else if (next == nodes.end()) { out[frame] = nodes.back().outValue; }
+		else { out[frame] = segmentValue(*(next - 1), *next, t - (next - 1)->pos, progressionType, tension); }
+	}
+}
+
+
+
+
+void AutomationClip::updateSnapshot()
+{
+	QMutexLocker m(&m_clipMutex);
+
+	// recording adds a node each tick; the recorded models ignore the clip
+	// anyway, so publish once recording stops
+	if (m_isRecording) { return; }
+
+	auto snapshot = new Snapshot{{}, m_progressionType, m_tension};
+	snapshot->nodes.reserve(m_timeMap.size());
+	for (auto it = m_timeMap.begin(); it != m_timeMap.end(); ++it)
+	{
+		snapshot->nodes.push_back({POS(it), INVAL(it), OUTVAL(it), INTAN(it), OUTTAN(it)});
+	}
+
+	retireSnapshot(m_snapshot.exchange(snapshot, std::memory_order_acq_rel));
+}
+
+
+
+
+void AutomationClip::retireSnapshot(const Snapshot* snapshot)
+{
+	if (!snapshot) { return; }
+
+	QMutexLocker m(&s_retiredSnapshots.mutex);
+	freeRetiredSnapshots();
+	s_retiredSnapshots.snapshots.emplace_back(AutomatableModel::periodCounter(), snapshot);
+	scheduleSnapshotCleanup();
+}
+
+
+
+
+void AutomationClip::setRecording(const bool b)
+{
+	QMutexLocker m(&m_clipMutex);
+
+	m_isRecording = b;
+	if (!b) { updateSnapshot(); }
+}
+
+
+
+
 float *AutomationClip::valuesAfter( const TimePos & _time ) const
 {
 	QMutexLocker m(&m_clipMutex);
@@ -749,7 +944,7 @@ void AutomationClip::flipX(int length)
 		{
 			// We are flipping an area that goes beyond the last node. So we add a node to the
 			// beginning of the flipped timeMap representing the value of the end of the area
-			tempValue = valueAt(length);
+			tempValue = timeMapValueAt(length);
 			tempMap[0] = AutomationNode(this, tempValue, 0);
 
 			// Now flip the nodes we have in relation to the length
@@ -936,6 +1131,7 @@ void AutomationClip::loadSettings( const QDomElement & _this )
 	}
 
 	if (shouldGenerateTangents) { generateTangents(); }
+	updateSnapshot();
 }
 
 
@@ -1120,6 +1316,7 @@ void AutomationClip::clear()
 	QMutexLocker m(&m_clipMutex);
 
 	m_timeMap.clear();
+	updateSnapshot();
 
 	emit dataChanged();
 }
@@ -1240,6 +1437,8 @@ void AutomationClip::generateTangents(timeMap::iterator it, int numToGenerate)
 			}
 		}
 	}
+
+	updateSnapshot();
 }
 
 std::vector<Track*> AutomationClip::combineAllTracks()
@@ -0,0 +1,321 @@
+/*
+ * AutomationTimeline.cpp - incrementally evaluated index of the song's automation
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AutomationTimeline.h"
+
+#include <algorithm>
+
+#include "AutomationClip.h"
+#include "AutomationTrack.h"
+#include "Engine.h"
+#include "PatternClip.h"
+#include "PatternStore.h"
+#include "PatternTrack.h"
+#include "Song.h"
+
+namespace lmms {
+
+std::atomic<unsigned> AutomationTimeline::s_generation = 0;
+std::mutex AutomationTimeline::s_clipChangesMutex;
+std::vector<Clip*> AutomationTimeline::s_changedClips;
+std::vector<Clip*> AutomationTimeline::s_removedClips;
+
+AutomationTimeline::AutomationTimeline(Song* song)
+	: m_song(song)
+	, m_generation(s_generation.load() - 1)
+{
+}
+
+void AutomationTimeline::invalidate()
+{
+	s_generation.fetch_add(1, std::memory_order_release);
+}
+
+void AutomationTimeline::clipChanged(Clip* clip)
+{
+	if (!isIndexed(clip)) { return; }
+
+	const auto lock = std::lock_guard{s_clipChangesMutex};
+	if (std::find(s_changedClips.begin(), s_changedClips.end(), clip) == s_changedClips.end())
+	{
+		s_changedClips.push_back(clip);
+	}
+}
+
+void AutomationTimeline::clipRemoved(Clip* clip)
+{
+	const auto lock = std::lock_guard{s_clipChangesMutex};
+	// the clip must not be touched anymore once it is gone
+	s_changedClips.erase(std::remove(s_changedClips.begin(), s_changedClips.end(), clip), s_changedClips.end());
+	if (isIndexed(clip)) { s_removedClips.push_back(clip); }
+}
+
+auto AutomationTimeline::isIndexed(const Clip* clip) -> bool
+{
+	const auto track = clip->getTrack();
+	if (!track || track->trackContainer() != Engine::getSong()) { return false; }
+
+	const auto type = track->type();
+	return type == Track::Type::Automation || type == Track::Type::HiddenAutomation
+		|| type == Track::Type::Pattern;
+}
+
+auto AutomationTimeline::entryFor(Clip* clip, int trackIndex) -> Entry
+{
+	const auto track = clip->getTrack();
+
+	auto entry = Entry{};
+	entry.clip = clip;
+	entry.start = clip->startPosition().getTicks();
+	entry.end = clip->endPosition().getTicks();
+	entry.trackIndex = trackIndex;
+	entry.automation = dynamic_cast<AutomationClip*>(clip);
+	entry.pattern = dynamic_cast<PatternClip*>(clip) ? track : nullptr;
+	entry.muted = track->isMuted() || clip->isMuted();
+	entry.recordable = entry.automation && track->type() == Track::Type::Automation;
+	return entry;
+}
+
+auto AutomationTimeline::valuesAt(TimePos time) -> AutomatedValueMap
+{
+	if (m_generation != s_generation.load(std::memory_order_acquire)) { rebuild(); }
+	applyClipChanges();
+	if (time.getTicks() < m_time) { rewind(); }
+	advance(time.getTicks());
+
+	auto values = AutomatedValueMap{};
+	if (!evaluate(time.getTicks(), values))
+	{
+		// a clip gained or lost its automation since it was indexed, which
+		// decides whether it overrides earlier clips
+		rewind();
+		advance(time.getTicks());
+		values.clear();
+		evaluate(time.getTicks(), values);
+	}
+	return values;
+}
+
+void AutomationTimeline::rebuild()
+{
+	m_generation = s_generation.load(std::memory_order_acquire);
+	m_entries.clear();
+
+	auto tracks = TrackContainer::TrackList{m_song->globalAutomationTrack()};
+	tracks.insert(tracks.end(), m_song->tracks().begin(), m_song->tracks().end());
+
+	for (auto trackIndex = std::size_t{0}; trackIndex < tracks.size(); ++trackIndex)
+	{
+		const auto type = tracks[trackIndex]->type();
+		if (type != Track::Type::Automation && type != Track::Type::HiddenAutomation
+			&& type != Track::Type::Pattern)
+		{
+			continue;
+		}
+
+		for (Clip* clip : tracks[trackIndex]->getClips())
+		{
+			m_entries.push_back(entryFor(clip, static_cast<int>(trackIndex)));
+		}
+	}
+
+	// later clips take precedence, clips starting at the same time keep the
+	// order of their tracks
+	std::stable_sort(m_entries.begin(), m_entries.end(),
+		[](const Entry& a, const Entry& b) { return a.start < b.start; });
+
+	rewind();
+}
+
+void AutomationTimeline::applyClipChanges()
+{
+	// don't wait for a GUI thread reporting a change, it will be picked up in the next period
+	const auto lock = std::unique_lock{s_clipChangesMutex, std::try_to_lock};
+	if (!lock.owns_lock() || (s_changedClips.empty() && s_removedClips.empty())) { return; }
+
+	const auto erase = [this](const Clip* clip) {
+		m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+			[clip](const Entry& entry) { return entry.clip == clip; }), m_entries.end());
+	};
+
+	// a removed clip may have been destroyed and its address reused by a changed one, so the
+	// removals come first
+	for (const Clip* clip : s_removedClips) { erase(clip); }
+
+	const auto& tracks = m_song->tracks();
+	for (Clip* clip : s_changedClips)
+	{
+		erase(clip);
+
+		const auto track = clip->getTrack();
+		auto trackIndex = 0;
+		if (track != m_song->globalAutomationTrack())
+		{
+			const auto it = std::find(tracks.begin(), tracks.end(), track);
+			// the track was removed too, which rebuilds the index
+			if (it == tracks.end()) { continue; }
+			trackIndex = 1 + static_cast<int>(it - tracks.begin());
+		}
+
+		// keep the order rebuild() sorts the entries in
+		const auto entry = entryFor(clip, trackIndex);
+		const auto pos = std::upper_bound(m_entries.begin(), m_entries.end(), entry,
+			[](const Entry& a, const Entry& b) {
+				return a.start < b.start || (a.start == b.start && a.trackIndex < b.trackIndex);
+			});
+		m_entries.insert(pos, entry);
+	}
+
+	s_changedClips.clear();
+	s_removedClips.clear();
+	rewind();
+}
+
+void AutomationTimeline::rewind()
+{
+	for (auto& entry : m_entries)
+	{
+		entry.automated = false;
+		entry.owned = 0;
+	}
+	m_cursor = 0;
+	m_time = -1;
+	m_live.clear();
+	m_modelOwners.clear();
+	m_patternOwners.clear();
+	m_playingClips.clear();
+}
+
+void AutomationTimeline::advance(int time)
+{
+	m_time = time;
+
+	m_playingClips.erase(std::remove_if(m_playingClips.begin(), m_playingClips.end(),
+		[time](const AutomationClip* clip) { return clip->endPosition().getTicks() <= time; }),
+		m_playingClips.end());
+
+	for (; m_cursor < m_entries.size() && m_entries[m_cursor].start <= time; ++m_cursor)
+	{
+		auto& entry = m_entries[m_cursor];
+		if (entry.recordable && entry.end > time) { m_playingClips.push_back(entry.automation); }
+		if (entry.muted) { continue; }
+
+		if (entry.automation)
+		{
+			entry.automated = entry.automation->hasAutomation();
+			if (entry.automated)
+			{
+				for (const AutomatableModel* model : entry.automation->objects())
+				{
+					if (!model) { continue; }
+
+					const auto owner = m_modelOwners.find(model);
+					if (owner == m_modelOwners.end()) { m_modelOwners.insert(model, m_cursor); }
+					else if (*owner != m_cursor)
+					{
+						--m_entries[*owner].owned;
+						*owner = m_cursor;
+					}
+					else { continue; }
+					++entry.owned;
+				}
+			}
+			m_live.push_back(m_cursor);
+		}
+		else if (entry.pattern)
+		{
+			// all clips of a pattern track automate the same models
+			const auto owner = m_patternOwners.find(entry.pattern);
+			if (owner == m_patternOwners.end()) { m_patternOwners.insert(entry.pattern, m_cursor); }
+			else
+			{
+				m_entries[*owner].owned = 0;
+				*owner = m_cursor;
+			}
+			entry.owned = 1;
+			m_live.push_back(m_cursor);
+		}
+	}
+}
+
+auto AutomationTimeline::evaluate(int time, AutomatedValueMap& values) -> bool
+{
+	// drop clips whose models are all overridden by later ones; clips without
+	// automation are kept so we notice when they get some
+	m_live.erase(std::remove_if(m_live.begin(), m_live.end(), [this](std::size_t index) {
+		const auto& entry = m_entries[index];
+		return (entry.pattern || entry.automated) && entry.owned == 0;
+	}), m_live.end());
+
+	m_sourceMap.clear();
+
+	for (const auto index : m_live)
+	{
+		const auto& entry = m_entries[index];
+		if (auto* clip = entry.automation)
+		{
+			if (clip->hasAutomation() != entry.automated) { return false; }
+			if (!entry.automated) { continue; }
+
+			auto relTime = TimePos{time - entry.start};
+			if (!clip->getAutoResize()) { relTime = std::min(relTime, clip->length()); }
+			const float value = clip->valueAt(relTime);
+
+			for (AutomatableModel* model : clip->objects())
+			{
+				if (model)
+				{
+					values[model] = value;
+					m_sourceMap[model] = clip;
+				}
+			}
+		}
+		else
+		{
+			const auto patIndex = static_cast<PatternTrack*>(entry.pattern)->patternIndex();
+			const auto patStore = Engine::patternStore();
+
+			auto patTime = TimePos{time - entry.start};
+			patTime = std::min(patTime, entry.clip->length());
+			patTime = patTime % (patStore->lengthOfPattern(patIndex) * TimePos::ticksPerBar());
+
+			const auto patValues = patStore->automatedValuesAt(patTime, patIndex);
+			for (auto it = patValues.begin(); it != patValues.end(); ++it)
+			{
+				// pattern track with the highest index takes precedence
+				values[it.key()] = it.value();
+				m_sourceMap.remove(it.key());
+			}
+		}
+	}
+
+	m_sources.clear();
+	for (auto it = m_sourceMap.begin(); it != m_sourceMap.end(); ++it)
+	{
+		m_sources.emplace_back(it.key(), it.value());
+	}
+	return true;
+}
+
+} // namespace lmms
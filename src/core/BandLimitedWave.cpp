@@ -26,6 +26,7 @@
 #include "BandLimitedWave.h"
 
 #include <QDataStream>
+#include <QFile>
 
 namespace lmms
 {
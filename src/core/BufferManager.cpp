@@ -28,30 +28,100 @@
 
 #include "SampleFrame.h"
 
-#include <cstring>
+#include <memory>
 
 
 namespace lmms
 {
 
+namespace
+{
+
+constexpr std::size_t InitialPoolSize = 512;
+// the pool starts growing in the background when less buffers are left
+constexpr std::size_t PoolLowWaterMark = 128;
+constexpr int MagazineSize = 32;
+
+std::unique_ptr<LocklessPool> s_pool;
+
+//! Per-thread cache of buffers. Refilled from resp. flushed to the shared
+//! pool half at a time.
+struct Magazine
+{
+	SampleFrame* buffers[MagazineSize];
+	int count = 0;
+
+	~Magazine()
+	{
+		if (s_pool)
+		{
+			while (count > 0) { s_pool->free(buffers[--count]); }
+		}
+	}
+};
+
+thread_local Magazine s_magazine;
+
+} // namespace
+
+
 fpp_t BufferManager::s_framesPerPeriod;
 
 void BufferManager::init( fpp_t fpp )
 {
 	s_framesPerPeriod = fpp;
+	s_pool = std::make_unique<LocklessPool>(fpp * sizeof(SampleFrame), InitialPoolSize, PoolLowWaterMark);
 }
 
 
 SampleFrame* BufferManager::acquire()
 {
-	return new SampleFrame[s_framesPerPeriod];
+	auto& magazine = s_magazine;
+	if (magazine.count == 0)
+	{
+		while (magazine.count < MagazineSize / 2)
+		{
+			auto buf = s_pool->alloc();
+			if (buf == nullptr) { break; }
+			magazine.buffers[magazine.count++] = static_cast<SampleFrame*>(buf);
+		}
+		if (magazine.count == 0) { return nullptr; }
+	}
+
+	SampleFrame* buf = magazine.buffers[--magazine.count];
+	zeroSampleFrames(buf, s_framesPerPeriod);
+	return buf;
 }
 
 
 
 void BufferManager::release( SampleFrame* buf )
 {
-	delete[] buf;
+	if (buf == nullptr) { return; }
+
+	auto& magazine = s_magazine;
+	if (magazine.count == MagazineSize)
+	{
+		while (magazine.count > MagazineSize / 2)
+		{
+			s_pool->free(magazine.buffers[--magazine.count]);
+		}
+	}
+	magazine.buffers[magazine.count++] = buf;
+}
+
+
+
+void BufferManager::reserve(std::size_t count)
+{
+	s_pool->reserve(count);
+}
+
+
+
+BufferManager::Statistics BufferManager::statistics()
+{
+	return s_pool->statistics();
 }
 
 } // namespace lmms
@@ -28,6 +28,7 @@
 
 #include "AutomationEditor.h"
 #include "AutomationClip.h"
+#include "AutomationTimeline.h"
 #include "Engine.h"
 #include "GuiApplication.h"
 #include "Song.h"
@@ -54,6 +55,8 @@ Clip::Clip( Track * track ) :
 	{
 		getTrack()->addClip( this );
 	}
+	connect(&m_mutedModel, &BoolModel::dataChanged, this,
+		[this] { AutomationTimeline::clipChanged(this); }, Qt::DirectConnection);
 	setJournalling( false );
 	movePosition( 0 );
 	changeLength( 0 );
@@ -96,6 +99,8 @@ void Clip::movePosition( const TimePos & pos )
 		Engine::audioEngine()->requestChangeInModel();
 		m_startPosition = newPos;
 		Engine::audioEngine()->doneChangeInModel();
+		if( m_track ) { m_track->invalidateClipIndex(); }
+		AutomationTimeline::clipChanged(this);
 		Engine::getSong()->updateLength();
 		emit positionChanged();
 	}
@@ -114,6 +119,8 @@ void Clip::movePosition( const TimePos & pos )
 void Clip::changeLength( const TimePos & length )
 {
 	m_length = length;
+	if( m_track ) { m_track->invalidateClipIndex(); }
+	AutomationTimeline::clipChanged(this);
 	Engine::getSong()->updateLength();
 	emit lengthChanged();
 }
@@ -0,0 +1,148 @@
+/*
+ * CompensationDelay.cpp - delay line lining up paths with different latencies
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "CompensationDelay.h"
+
+#include <algorithm>
+
+namespace lmms
+{
+
+
+CompensationDelay::CompensationDelay() :
+	// the frame written last is read at a delay of 0
+	m_buffer( MaxDelay + 1 )
+{
+}
+
+
+
+
+void CompensationDelay::setDelay( f_cnt_t frames )
+{
+	frames = std::min( frames, MaxDelay );
+	if( frames == m_delay )
+	{
+		return;
+	}
+
+	if( m_delay > 0 && hasPendingOutput() )
+	{
+		// the line holds the recent signal, so keep it and crossfade to the new delay
+		m_fadeDelay = m_delay;
+		m_fadeRemaining = FadeFrames;
+	}
+	else
+	{
+		// without a delay or after draining, the line wasn't necessarily fed and what the
+		// new delay would reach is stale
+		for( f_cnt_t f = 1; f <= frames; ++f )
+		{
+			m_buffer[readPosition( f )] = SampleFrame();
+		}
+		m_fadeRemaining = 0;
+	}
+	m_delay = frames;
+}
+
+
+
+
+void CompensationDelay::process( const SampleFrame* src, SampleFrame* dst, fpp_t frames )
+{
+	if( m_delay == 0 && m_fadeRemaining == 0 )
+	{
+		// nothing to delay, setDelay() clears what a new delay would reach
+		if( dst != src ) { std::copy_n( src, frames, dst ); }
+		m_pending = 0;
+		return;
+	}
+
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		dst[f] = tick( src[f] );
+	}
+	m_pending = std::max( m_delay, m_fadeRemaining > 0 ? m_fadeDelay : 0 );
+}
+
+
+
+
+void CompensationDelay::drain( SampleFrame* dst, fpp_t frames )
+{
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		if( m_pending > 0 )
+		{
+			dst[f] = tick( SampleFrame() );
+			--m_pending;
+		}
+		else
+		{
+			dst[f] = SampleFrame();
+		}
+	}
+}
+
+
+
+
+void CompensationDelay::clear()
+{
+	std::fill( m_buffer.begin(), m_buffer.end(), SampleFrame() );
+	m_pending = 0;
+	m_fadeRemaining = 0;
+}
+
+
+
+
+SampleFrame CompensationDelay::tick( const SampleFrame& in )
+{
+	m_buffer[m_writePosition] = in;
+	SampleFrame out = m_buffer[readPosition( m_delay )];
+	if( m_fadeRemaining > 0 )
+	{
+		const float oldGain = static_cast<float>( m_fadeRemaining ) / FadeFrames;
+		out = out * ( 1.0f - oldGain ) + m_buffer[readPosition( m_fadeDelay )] * oldGain;
+		--m_fadeRemaining;
+	}
+
+	if( ++m_writePosition == m_buffer.size() )
+	{
+		m_writePosition = 0;
+	}
+	return out;
+}
+
+
+
+
+f_cnt_t CompensationDelay::readPosition( f_cnt_t delay ) const
+{
+	return m_writePosition >= delay ? m_writePosition - delay : m_writePosition + m_buffer.size() - delay;
+}
+
+
+} // namespace lmms
@@ -0,0 +1,94 @@
+/*
+ * CpuTimeCounter.cpp - processing time accounting for tracks, plugins and mixer channels
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "CpuTimeCounter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+namespace lmms
+{
+
+namespace
+{
+
+// counters are added and removed from the GUI thread while the audio thread
+// only ever tries to lock, so it never waits for them
+std::mutex s_countersMutex;
+std::vector<CpuTimeCounter*> s_counters;
+int s_pendingPeriods = 0;
+
+} // namespace
+
+
+
+
+CpuTimeCounter::CpuTimeCounter()
+{
+	const auto lock = std::lock_guard{ s_countersMutex };
+	s_counters.push_back( this );
+}
+
+
+
+
+CpuTimeCounter::~CpuTimeCounter()
+{
+	const auto lock = std::lock_guard{ s_countersMutex };
+	s_counters.erase( std::find( s_counters.begin(), s_counters.end(), this ) );
+}
+
+
+
+
+void CpuTimeCounter::finishPeriod( std::int64_t periodBudgetNs )
+{
+	++s_pendingPeriods;
+
+	auto lock = std::unique_lock{ s_countersMutex, std::try_to_lock };
+	if( !lock.owns_lock() || periodBudgetNs <= 0 )
+	{
+		// the time is kept in the counters and spread over the periods
+		// that were missed once we get the lock again
+		return;
+	}
+
+	const auto budget = static_cast<float>( periodBudgetNs ) * s_pendingPeriods;
+	// the peaks halve each second
+	const auto peakDecay = std::exp2( -budget / 1e9f );
+	for( CpuTimeCounter* counter : s_counters )
+	{
+		const auto time = counter->m_periodTime.exchange( 0, std::memory_order_relaxed );
+		const auto newLoad = 100.f * time / budget;
+		const auto oldLoad = counter->m_load.load( std::memory_order_relaxed );
+		counter->m_load.store( newLoad * 0.05f + oldLoad * 0.95f, std::memory_order_relaxed );
+		const auto peakLoad = counter->m_peakLoad.load( std::memory_order_relaxed ) * peakDecay;
+		counter->m_peakLoad.store( std::max( newLoad, peakLoad ), std::memory_order_relaxed );
+	}
+	s_pendingPeriods = 0;
+}
+
+} // namespace lmms
@@ -25,9 +25,11 @@
 
 
 #include <QDomElement>
+#include <algorithm>
 #include <cassert>
 
 #include "EffectChain.h"
+#include "AudioEngineTracer.h"
 #include "Effect.h"
 #include "DummyEffect.h"
 #include "MixHelpers.h"
@@ -191,6 +193,12 @@ bool EffectChain::processAudioBuffer( SampleFrame* _buf, const fpp_t _frames, bo
 		return false;
 	}
 
+	// a silent buffer that no effect is going to process needs no sanitizing either
+	if( !hasInputNoise && !isRunning() )
+	{
+		return false;
+	}
+
 	MixHelpers::sanitize( _buf, _frames );
 
 	bool moreEffects = false;
@@ -198,8 +206,18 @@ bool EffectChain::processAudioBuffer( SampleFrame* _buf, const fpp_t _frames, bo
 	{
 		if (hasInputNoise || effect->isRunning())
 		{
+			// one measurement for both the load display and the tracer
+			const auto begin = AudioEngineTracer::Clock::now();
 			moreEffects |= effect->processAudioBuffer(_buf, _frames);
 			MixHelpers::sanitize(_buf, _frames);
+			const auto end = AudioEngineTracer::Clock::now();
+
+			effect->cpuTime().add(end - begin);
+			if (AudioEngineTracer::isEnabled())
+			{
+				AudioEngineTracer::record({AudioEngineTracer::Category::Effect, effect->descriptor()->displayName},
+					begin, end);
+			}
 		}
 	}
 
@@ -209,6 +227,42 @@ bool EffectChain::processAudioBuffer( SampleFrame* _buf, const fpp_t _frames, bo
 
 
 
+f_cnt_t EffectChain::latency() const
+{
+	if( m_enabledModel.value() == false )
+	{
+		return 0;
+	}
+
+	// sleeping effects still count, they only sleep while their input is silent
+	f_cnt_t frames = 0;
+	for (const auto& effect : m_effects)
+	{
+		if (effect->isOkay() && !effect->dontRun() && effect->isEnabled())
+		{
+			frames += effect->latency();
+		}
+	}
+	return frames;
+}
+
+
+
+
+bool EffectChain::isRunning() const
+{
+	if( m_enabledModel.value() == false )
+	{
+		return false;
+	}
+
+	return std::any_of( m_effects.begin(), m_effects.end(),
+		[]( const Effect * effect ) { return effect->isRunning(); } );
+}
+
+
+
+
 void EffectChain::startRunning()
 {
 	if( m_enabledModel.value() == false )
@@ -33,6 +33,7 @@
 #include "EnvelopeAndLfoParameters.h"
 #include "Instrument.h"
 #include "InstrumentTrack.h"
+#include "NotePlayHandle.h"
 
 namespace lmms
 {
@@ -158,7 +159,7 @@ void InstrumentSoundShaping::processAudioBuffer( SampleFrame* buffer,
 
 		if( n->m_filter == nullptr )
 		{
-			n->m_filter = std::make_unique<BasicFilters<>>( Engine::audioEngine()->outputSampleRate() );
+			n->m_filter.reset(NotePlayHandleManager::create<BasicFilters<>>(Engine::audioEngine()->outputSampleRate()));
 		}
 		n->m_filter->setFilterType( static_cast<BasicFilters<>::FilterType>(m_filterModel.value()) );
 
@@ -0,0 +1,362 @@
+/*
+ * LocklessPool.cpp - growable lock-free pool of fixed-size memory blocks
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LocklessPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+
+namespace lmms
+{
+
+namespace
+{
+
+std::atomic_size_t s_totalExhaustions = 0;
+
+} // namespace
+
+// every block is preceded by a header of one cache line, so the block
+// itself stays aligned
+struct LocklessPool::BlockHeader
+{
+	std::atomic<std::uint32_t> next;
+	std::uint32_t index;
+};
+
+//! Background thread growing pools which are below their low-water mark
+class LocklessPool::Grower
+{
+public:
+	static Grower& instance()
+	{
+		// intentionally leaked, so pools with static storage duration can
+		// still unregister when they are destroyed at exit
+		static auto s_grower = new Grower;
+		return *s_grower;
+	}
+
+	void add(LocklessPool* pool)
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		m_pools.push_back(pool);
+	}
+
+	void remove(LocklessPool* pool)
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		m_pools.erase(std::remove(m_pools.begin(), m_pools.end(), pool), m_pools.end());
+	}
+
+	//! Wake up the thread - lock-free, so this can be called from the audio threads
+	void request()
+	{
+		++m_requests;
+		m_requests.notify_one();
+	}
+
+private:
+	Grower() :
+		m_requests(0),
+		m_thread([this] { run(); })
+	{
+		m_thread.detach();
+	}
+
+	void run()
+	{
+		auto requests = m_requests.load();
+		while (true)
+		{
+			m_requests.wait(requests);
+			requests = m_requests.load();
+
+			const auto lock = std::lock_guard{m_mutex};
+			for (LocklessPool* pool : m_pools)
+			{
+				if (pool->m_growRequested)
+				{
+					// leave some headroom so we're not woken up again right away
+					pool->reserve(pool->m_inUse + 2 * pool->m_lowWaterMark);
+					pool->m_growRequested = false;
+				}
+			}
+		}
+	}
+
+	std::mutex m_mutex;
+	std::vector<LocklessPool*> m_pools;
+	std::atomic<std::uint32_t> m_requests;
+	std::thread m_thread;
+} ;
+
+
+
+
+static std::size_t alignUp(std::size_t size, std::size_t alignment)
+{
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+
+
+
+LocklessPool::LocklessPool(std::size_t blockSize, std::size_t initialCapacity, std::size_t lowWaterMark) :
+	m_blockStride(CacheLineSize + alignUp(blockSize, CacheLineSize)),
+	m_lowWaterMark(lowWaterMark),
+	m_slabs(),
+	m_numSlabs(0),
+	m_freeList(0),
+	m_capacity(0),
+	m_inUse(0),
+	m_highWaterMark(0),
+	m_exhaustions(0),
+	m_unpooled(0),
+	m_growRequested(false)
+{
+	std::fill(m_slabs, m_slabs + MaxSlabs, nullptr);
+	reserve(std::max(initialCapacity, lowWaterMark));
+
+	if (m_lowWaterMark > 0)
+	{
+		Grower::instance().add(this);
+	}
+}
+
+
+
+
+LocklessPool::~LocklessPool()
+{
+	if (m_lowWaterMark > 0)
+	{
+		Grower::instance().remove(this);
+	}
+
+	if (m_inUse != 0)
+	{
+		fprintf(stderr, "LocklessPool: Destroying with blocks still allocated\n");
+	}
+
+	for (std::size_t slab = 0; slab < m_numSlabs; ++slab)
+	{
+		::operator delete(m_slabs[slab].load(), std::align_val_t{CacheLineSize});
+	}
+}
+
+
+
+
+void* LocklessPool::alloc()
+{
+	auto index = pop();
+	if (index == NoBlock)
+	{
+		// the background thread couldn't keep up (or there is none), so
+		// we have to allocate right here
+		++m_exhaustions;
+		s_totalExhaustions.fetch_add(1, std::memory_order_relaxed);
+		while ((index = pop()) == NoBlock)
+		{
+			if (!grow()) { return allocOutsideSlabs(); }
+		}
+	}
+
+	const auto inUse = ++m_inUse;
+	auto highWaterMark = m_highWaterMark.load(std::memory_order_relaxed);
+	while (inUse > highWaterMark
+		&& !m_highWaterMark.compare_exchange_weak(highWaterMark, inUse, std::memory_order_relaxed))
+	{
+		// Empty loop (compare_exchange_weak updates highWaterMark)
+	}
+
+	if (m_lowWaterMark > 0 && m_capacity.load(std::memory_order_relaxed) - inUse < m_lowWaterMark
+		&& !m_growRequested.exchange(true))
+	{
+		Grower::instance().request();
+	}
+
+	return reinterpret_cast<char*>(header(index)) + CacheLineSize;
+}
+
+
+
+
+void LocklessPool::free(void* ptr)
+{
+	if (ptr == nullptr) { return; }
+
+	const auto h = reinterpret_cast<BlockHeader*>(static_cast<char*>(ptr) - CacheLineSize);
+	if (h->index == NoBlock)
+	{
+		h->~BlockHeader();
+		::operator delete(h, std::align_val_t{CacheLineSize});
+	}
+	else
+	{
+		push(h->index);
+	}
+	--m_inUse;
+}
+
+
+
+
+void* LocklessPool::allocOutsideSlabs()
+{
+	// all slabs are in use, so rather than failing, hand out a block of its
+	// own with the same layout; free() recognizes it by its index. This is
+	// already counted as an exhaustion, statistics() tells how often it happens.
+	m_unpooled.fetch_add(1, std::memory_order_relaxed);
+	auto block = static_cast<char*>(::operator new(m_blockStride, std::align_val_t{CacheLineSize}, std::nothrow));
+	if (block == nullptr) { return nullptr; }
+
+	auto h = new (block) BlockHeader;
+	h->next.store(0, std::memory_order_relaxed);
+	h->index = NoBlock;
+	++m_inUse;
+	return block + CacheLineSize;
+}
+
+
+
+
+void LocklessPool::reserve(std::size_t capacity)
+{
+	while (m_capacity < capacity)
+	{
+		if (!grow()) { return; }
+	}
+}
+
+
+
+
+LocklessPool::Statistics LocklessPool::statistics() const
+{
+	return Statistics{m_capacity.load(), m_inUse.load(), m_highWaterMark.load(), m_exhaustions.load(),
+		m_unpooled.load()};
+}
+
+
+
+
+std::size_t LocklessPool::totalExhaustions()
+{
+	return s_totalExhaustions.load(std::memory_order_relaxed);
+}
+
+
+
+
+void LocklessPool::countUnpooledAllocation()
+{
+	s_totalExhaustions.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+
+
+LocklessPool::BlockHeader* LocklessPool::header(std::uint32_t index) const
+{
+	char* slab = m_slabs[index / SlabSize].load(std::memory_order_acquire);
+	return reinterpret_cast<BlockHeader*>(slab + (index % SlabSize) * m_blockStride);
+}
+
+
+
+
+void LocklessPool::push(std::uint32_t index)
+{
+	BlockHeader* h = header(index);
+	auto head = m_freeList.load(std::memory_order_relaxed);
+	std::uint64_t newHead;
+	do
+	{
+		h->next.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+		newHead = ((head >> 32) + 1) << 32 | (index + 1);
+	}
+	while (!m_freeList.compare_exchange_weak(head, newHead,
+			std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+
+
+std::uint32_t LocklessPool::pop()
+{
+	auto head = m_freeList.load(std::memory_order_acquire);
+	while (static_cast<std::uint32_t>(head) != 0)
+	{
+		const auto index = static_cast<std::uint32_t>(head) - 1;
+		// the block might be popped and reused concurrently, in which case
+		// the tag makes the exchange below fail
+		const auto next = header(index)->next.load(std::memory_order_relaxed);
+		const std::uint64_t newHead = ((head >> 32) + 1) << 32 | next;
+		if (m_freeList.compare_exchange_weak(head, newHead,
+				std::memory_order_acquire, std::memory_order_acquire))
+		{
+			return index;
+		}
+	}
+	return NoBlock;
+}
+
+
+
+
+bool LocklessPool::grow()
+{
+	const auto lock = std::lock_guard{m_growMutex};
+	if (m_numSlabs == MaxSlabs) { return false; }
+
+	const auto slabIndex = m_numSlabs;
+	auto slab = static_cast<char*>(::operator new(SlabSize * m_blockStride, std::align_val_t{CacheLineSize}));
+	// touch all pages now, so the audio threads don't have to take the page faults
+	std::memset(slab, 0, SlabSize * m_blockStride);
+	for (std::size_t i = 0; i < SlabSize; ++i)
+	{
+		auto h = new (slab + i * m_blockStride) BlockHeader;
+		h->next.store(0, std::memory_order_relaxed);
+		h->index = static_cast<std::uint32_t>(slabIndex * SlabSize + i);
+	}
+	m_slabs[slabIndex].store(slab, std::memory_order_release);
+	++m_numSlabs;
+	m_capacity += SlabSize;
+
+	// push in reverse order so that blocks are handed out in memory order
+	for (auto i = SlabSize; i > 0; --i)
+	{
+		push(static_cast<std::uint32_t>(slabIndex * SlabSize + i - 1));
+	}
+	return true;
+}
+
+
+} // namespace lmms
@@ -28,9 +28,24 @@
 #include <cstdio>
 #endif
 
+#include <atomic>
 #include <cmath>
 #include <QtGlobal>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define LMMS_MIX_HELPERS_X86
+#	define LMMS_MIX_HELPERS_TARGET(isa) __attribute__((target(isa)))
+#	include <immintrin.h>
+#elif defined(_M_X64)
+#	define LMMS_MIX_HELPERS_SSE2_ONLY
+#	define LMMS_MIX_HELPERS_TARGET(isa)
+#	include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#	define LMMS_MIX_HELPERS_NEON
+#	include <arm_neon.h>
+#endif
+
+
 #include "ValueBuffer.h"
 #include "SampleFrame.h"
 
@@ -42,6 +57,748 @@ static bool s_NaNHandler;
 namespace lmms::MixHelpers
 {
 
+// the kernels below treat a buffer of frames as an array of interleaved floats
+static_assert(sizeof(SampleFrame) == DEFAULT_CHANNELS * sizeof(sample_t));
+static_assert(DEFAULT_CHANNELS == 2);
+
+namespace
+{
+
+/*! \brief Vectorizable inner loops, all taking interleaved stereo data and a frame count */
+struct Kernels
+{
+	InstructionSet set;
+	void (*add)(float* dst, const float* src, int frames);
+	void (*multiply)(float* dst, float coeff, int frames);
+	void (*addMultiplied)(float* dst, const float* src, float coeff, int frames);
+	void (*addSanitizedMultiplied)(float* dst, const float* src, float coeff, int frames);
+	void (*addMultipliedByBuffers)(float* dst, const float* src, const float* coeffs1, const float* coeffs2, int frames);
+	void (*addSanitizedMultipliedByBuffers)(float* dst, const float* src, const float* coeffs1, const float* coeffs2,
+		int frames);
+	//! Clamps the buffer to +-1000 and returns true as soon as an inf/nan is found
+	bool (*sanitize)(float* buf, int frames);
+	//! Indexed by whether per-frame volumes and pannings are given; both are in percent
+	void (*multiplyByVolumeAndPanning[2][2])(float* dst, const float* volumes, float volume,
+		const float* pannings, float panning, int frames);
+};
+
+constexpr auto SanitizeLimit = 1000.0f;
+constexpr auto Percent = 0.01f;
+
+inline bool isBad(float sample)
+{
+	return std::isinf(sample) || std::isnan(sample);
+}
+
+
+// Scalar versions, also used for the tails the vector loops leave over
+
+namespace scalar
+{
+
+void add(float* dst, const float* src, int frames)
+{
+	for (int i = 0; i < frames * 2; ++i) { dst[i] += src[i]; }
+}
+
+void multiply(float* dst, float coeff, int frames)
+{
+	for (int i = 0; i < frames * 2; ++i) { dst[i] *= coeff; }
+}
+
+template<bool Sanitized>
+void addMultiplied(float* dst, const float* src, float coeff, int frames)
+{
+	for (int i = 0; i < frames * 2; ++i)
+	{
+		if (!Sanitized || !isBad(src[i])) { dst[i] += src[i] * coeff; }
+	}
+}
+
+template<bool Sanitized>
+void addMultipliedByBuffers(float* dst, const float* src, const float* coeffs1, const float* coeffs2, int frames)
+{
+	for (int f = 0; f < frames; ++f)
+	{
+		for (int ch = 0; ch < 2; ++ch)
+		{
+			const float sample = src[f * 2 + ch];
+			if (!Sanitized || !isBad(sample)) { dst[f * 2 + ch] += sample * coeffs1[f] * coeffs2[f]; }
+		}
+	}
+}
+
+bool sanitize(float* buf, int frames)
+{
+	for (int i = 0; i < frames * 2; ++i)
+	{
+		if (isBad(buf[i])) { return true; }
+		buf[i] = std::clamp(buf[i], -SanitizeLimit, SanitizeLimit);
+	}
+	return false;
+}
+
+template<bool Volumes, bool Pannings>
+void multiplyByVolumeAndPanning(float* dst, const float* volumes, float volume,
+	const float* pannings, float panning, int frames)
+{
+	for (int f = 0; f < frames; ++f)
+	{
+		// (p <= 0 ? 1 : 1 - p) and (p >= 0 ? 1 : 1 + p) without the branches
+		const float v = (Volumes ? volumes[f] : volume) * Percent;
+		const float p = (Pannings ? pannings[f] : panning) * Percent;
+		dst[f * 2] *= std::min(1.0f, 1.0f - p) * v;
+		dst[f * 2 + 1] *= std::min(1.0f, 1.0f + p) * v;
+	}
+}
+
+constexpr auto kernels = Kernels{
+	InstructionSet::Scalar,
+	&add,
+	&multiply,
+	&addMultiplied<false>,
+	&addMultiplied<true>,
+	&addMultipliedByBuffers<false>,
+	&addMultipliedByBuffers<true>,
+	&sanitize,
+	{
+		{ &multiplyByVolumeAndPanning<false, false>, &multiplyByVolumeAndPanning<false, true> },
+		{ &multiplyByVolumeAndPanning<true, false>, &multiplyByVolumeAndPanning<true, true> }
+	}
+};
+
+} // namespace scalar
+
+
+#if defined(LMMS_MIX_HELPERS_X86) || defined(LMMS_MIX_HELPERS_SSE2_ONLY)
+
+// SSE2: 2 frames per vector
+
+namespace sse2
+{
+
+LMMS_MIX_HELPERS_TARGET("sse2") inline __m128 finiteMask(__m128 x)
+{
+	// x - x is 0 for finite values and NaN for infs and NaNs
+	return _mm_cmpeq_ps(_mm_sub_ps(x, x), _mm_setzero_ps());
+}
+
+LMMS_MIX_HELPERS_TARGET("sse2") void add(float* dst, const float* src, int frames)
+{
+	int f = 0;
+	for (; f + 2 <= frames; f += 2)
+	{
+		_mm_storeu_ps(dst + f * 2, _mm_add_ps(_mm_loadu_ps(dst + f * 2), _mm_loadu_ps(src + f * 2)));
+	}
+	scalar::add(dst + f * 2, src + f * 2, frames - f);
+}
+
+LMMS_MIX_HELPERS_TARGET("sse2") void multiply(float* dst, float coeff, int frames)
+{
+	const auto c = _mm_set1_ps(coeff);
+	int f = 0;
+	for (; f + 2 <= frames; f += 2)
+	{
+		_mm_storeu_ps(dst + f * 2, _mm_mul_ps(_mm_loadu_ps(dst + f * 2), c));
+	}
+	scalar::multiply(dst + f * 2, coeff, frames - f);
+}
+
+template<bool Sanitized>
+LMMS_MIX_HELPERS_TARGET("sse2") void addMultiplied(float* dst, const float* src, float coeff, int frames)
+{
+	const auto c = _mm_set1_ps(coeff);
+	int f = 0;
+	for (; f + 2 <= frames; f += 2)
+	{
+		const auto s = _mm_loadu_ps(src + f * 2);
+		auto product = _mm_mul_ps(s, c);
+		if constexpr (Sanitized) { product = _mm_and_ps(product, finiteMask(s)); }
+		_mm_storeu_ps(dst + f * 2, _mm_add_ps(_mm_loadu_ps(dst + f * 2), product));
+	}
+	scalar::addMultiplied<Sanitized>(dst + f * 2, src + f * 2, coeff, frames - f);
+}
+
+template<bool Sanitized>
+LMMS_MIX_HELPERS_TARGET("sse2") void addMultipliedByBuffers(float* dst, const float* src,
+	const float* coeffs1, const float* coeffs2, int frames)
+{
+	int f = 0;
+	for (; f + 4 <= frames; f += 4)
+	{
+		// spread 4 per-frame coefficients over the interleaved channels
+		const auto c1 = _mm_loadu_ps(coeffs1 + f);
+		const auto c2 = _mm_loadu_ps(coeffs2 + f);
+		const __m128 c1s[] = { _mm_unpacklo_ps(c1, c1), _mm_unpackhi_ps(c1, c1) };
+		const __m128 c2s[] = { _mm_unpacklo_ps(c2, c2), _mm_unpackhi_ps(c2, c2) };
+		for (int half = 0; half < 2; ++half)
+		{
+			float* d = dst + f * 2 + half * 4;
+			const auto s = _mm_loadu_ps(src + f * 2 + half * 4);
+			auto product = _mm_mul_ps(_mm_mul_ps(s, c1s[half]), c2s[half]);
+			if constexpr (Sanitized) { product = _mm_and_ps(product, finiteMask(s)); }
+			_mm_storeu_ps(d, _mm_add_ps(_mm_loadu_ps(d), product));
+		}
+	}
+	scalar::addMultipliedByBuffers<Sanitized>(dst + f * 2, src + f * 2, coeffs1 + f, coeffs2 + f, frames - f);
+}
+
+LMMS_MIX_HELPERS_TARGET("sse2") bool sanitize(float* buf, int frames)
+{
+	const auto low = _mm_set1_ps(-SanitizeLimit);
+	const auto high = _mm_set1_ps(SanitizeLimit);
+	int f = 0;
+	for (; f + 2 <= frames; f += 2)
+	{
+		const auto x = _mm_loadu_ps(buf + f * 2);
+		if (_mm_movemask_ps(finiteMask(x)) != 0xf) { return true; }
+		_mm_storeu_ps(buf + f * 2, _mm_min_ps(_mm_max_ps(x, low), high));
+	}
+	return scalar::sanitize(buf + f * 2, frames - f);
+}
+
+template<bool Volumes, bool Pannings>
+LMMS_MIX_HELPERS_TARGET("sse2") void multiplyByVolumeAndPanning(float* dst, const float* volumes, float volume,
+	const float* pannings, float panning, int frames)
+{
+	const auto one = _mm_set1_ps(1.0f);
+	const auto percent = _mm_set1_ps(Percent);
+	int f = 0;
+	for (; f + 4 <= frames; f += 4)
+	{
+		const auto v = _mm_mul_ps(Volumes ? _mm_loadu_ps(volumes + f) : _mm_set1_ps(volume), percent);
+		const auto p = _mm_mul_ps(Pannings ? _mm_loadu_ps(pannings + f) : _mm_set1_ps(panning), percent);
+		const auto left = _mm_mul_ps(_mm_min_ps(one, _mm_sub_ps(one, p)), v);
+		const auto right = _mm_mul_ps(_mm_min_ps(one, _mm_add_ps(one, p)), v);
+		_mm_storeu_ps(dst + f * 2, _mm_mul_ps(_mm_loadu_ps(dst + f * 2), _mm_unpacklo_ps(left, right)));
+		_mm_storeu_ps(dst + f * 2 + 4, _mm_mul_ps(_mm_loadu_ps(dst + f * 2 + 4), _mm_unpackhi_ps(left, right)));
+	}
+	scalar::multiplyByVolumeAndPanning<Volumes, Pannings>(dst + f * 2, Volumes ? volumes + f : nullptr, volume,
+		Pannings ? pannings + f : nullptr, panning, frames - f);
+}
+
+constexpr auto kernels = Kernels{
+	InstructionSet::SSE2,
+	&add,
+	&multiply,
+	&addMultiplied<false>,
+	&addMultiplied<true>,
+	&addMultipliedByBuffers<false>,
+	&addMultipliedByBuffers<true>,
+	&sanitize,
+	{
+		{ &multiplyByVolumeAndPanning<false, false>, &multiplyByVolumeAndPanning<false, true> },
+		{ &multiplyByVolumeAndPanning<true, false>, &multiplyByVolumeAndPanning<true, true> }
+	}
+};
+
+} // namespace sse2
+
+#endif // LMMS_MIX_HELPERS_X86 || LMMS_MIX_HELPERS_SSE2_ONLY
+
+
+#ifdef LMMS_MIX_HELPERS_X86
+
+// AVX2: 4 frames per vector
+//
+// The scalar tails are not always inlined, so the upper register halves are cleared before calling them
+// to avoid the AVX-SSE transition penalty.
+
+namespace avx2
+{
+
+LMMS_MIX_HELPERS_TARGET("avx2") inline __m256 finiteMask(__m256 x)
+{
+	return _mm256_cmp_ps(_mm256_sub_ps(x, x), _mm256_setzero_ps(), _CMP_EQ_OQ);
+}
+
+//! Loads 4 per-frame coefficients and spreads them over 8 interleaved samples
+LMMS_MIX_HELPERS_TARGET("avx2") inline __m256 loadFrameCoeffs(const float* coeffs)
+{
+	const auto spread = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	return _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_loadu_ps(coeffs)), spread);
+}
+
+LMMS_MIX_HELPERS_TARGET("avx2") void add(float* dst, const float* src, int frames)
+{
+	int f = 0;
+	for (; f + 4 <= frames; f += 4)
+	{
+		_mm256_storeu_ps(dst + f * 2, _mm256_add_ps(_mm256_loadu_ps(dst + f * 2), _mm256_loadu_ps(src + f * 2)));
+	}
+	_mm256_zeroupper();
+	scalar::add(dst + f * 2, src + f * 2, frames - f);
+}
+
+LMMS_MIX_HELPERS_TARGET("avx2") void multiply(float* dst, float coeff, int frames)
+{
+	const auto c = _mm256_set1_ps(coeff);
+	int f = 0;
+	for (; f + 4 <= frames; f += 4)
+	{
+		_mm256_storeu_ps(dst + f * 2, _mm256_mul_ps(_mm256_loadu_ps(dst + f * 2), c));
+	}
+	_mm256_zeroupper();
+	scalar::multiply(dst + f * 2, coeff, frames - f);
+}
+
+template<bool Sanitized>
+LMMS_MIX_HELPERS_TARGET("avx2") void addMultiplied(float* dst, const float* src, float coeff, int frames)
+{
+	const auto c = _mm256_set1_ps(coeff);
+	int f = 0;
+	for (; f + 4 <= frames; f += 4)
+	{
+		const auto s = _mm256_loadu_ps(src + f * 2);
+		auto product = _mm256_mul_ps(s, c);
+		if constexpr (Sanitized) { product = _mm256_and_ps(product, finiteMask(s)); }
+		_mm256_storeu_ps(dst + f * 2, _mm256_add_ps(_mm256_loadu_ps(dst + f * 2), product));
+	}
+	_mm256_zeroupper();
+	scalar::addMultiplied<Sanitized>(dst + f * 2, src + f * 2, coeff, frames - f);
+}
+
+template<bool Sanitized>
+LMMS_MIX_HELPERS_TARGET("avx2") void addMultipliedByBuffers(float* dst, const float* src,
+	const float* coeffs1, const float* coeffs2, int frames)
+{
+	int f = 0;
+	for (; f + 4 <= frames; f += 4)
+	{
+		const auto s = _mm256_loadu_ps(src + f * 2);
+		auto product = _mm256_mul_ps(_mm256_mul_ps(s, loadFrameCoeffs(coeffs1 + f)), loadFrameCoeffs(coeffs2 + f));
+		if constexpr (Sanitized) { product = _mm256_and_ps(product, finiteMask(s)); }
+		_mm256_storeu_ps(dst + f * 2, _mm256_add_ps(_mm256_loadu_ps(dst + f * 2), product));
+	}
+	_mm256_zeroupper();
+	scalar::addMultipliedByBuffers<Sanitized>(dst + f * 2, src + f * 2, coeffs1 + f, coeffs2 + f, frames - f);
+}
+
+LMMS_MIX_HELPERS_TARGET("avx2") bool sanitize(float* buf, int frames)
+{
+	const auto low = _mm256_set1_ps(-SanitizeLimit);
+	const auto high = _mm256_set1_ps(SanitizeLimit);
+	int f = 0;
+	for (; f + 4 <= frames; f += 4)
+	{
+		const auto x = _mm256_loadu_ps(buf + f * 2);
+		if (_mm256_movemask_ps(finiteMask(x)) != 0xff) { return true; }
+		_mm256_storeu_ps(buf + f * 2, _mm256_min_ps(_mm256_max_ps(x, low), high));
+	}
+	_mm256_zeroupper();
+	return scalar::sanitize(buf + f * 2, frames - f);
+}
+
+template<bool Volumes, bool Pannings>
+LMMS_MIX_HELPERS_TARGET("avx2") void multiplyByVolumeAndPanning(float* dst, const float* volumes, float volume,
+	const float* pannings, float panning, int frames)
+{
+	const auto one = _mm256_set1_ps(1.0f);
+	const auto percent = _mm256_set1_ps(Percent);
+	int f = 0;
+	for (; f + 8 <= frames; f += 8)
+	{
+		const auto v = _mm256_mul_ps(Volumes ? _mm256_loadu_ps(volumes + f) : _mm256_set1_ps(volume), percent);
+		const auto p = _mm256_mul_ps(Pannings ? _mm256_loadu_ps(pannings + f) : _mm256_set1_ps(panning), percent);
+		const auto left = _mm256_mul_ps(_mm256_min_ps(one, _mm256_sub_ps(one, p)), v);
+		const auto right = _mm256_mul_ps(_mm256_min_ps(one, _mm256_add_ps(one, p)), v);
+		// unpacking works within 128 bit lanes, so the halves still need to be put in frame order
+		const auto low = _mm256_unpacklo_ps(left, right);
+		const auto high = _mm256_unpackhi_ps(left, right);
+		float* d = dst + f * 2;
+		_mm256_storeu_ps(d, _mm256_mul_ps(_mm256_loadu_ps(d), _mm256_permute2f128_ps(low, high, 0x20)));
+		_mm256_storeu_ps(d + 8, _mm256_mul_ps(_mm256_loadu_ps(d + 8), _mm256_permute2f128_ps(low, high, 0x31)));
+	}
+	_mm256_zeroupper();
+	scalar::multiplyByVolumeAndPanning<Volumes, Pannings>(dst + f * 2, Volumes ? volumes + f : nullptr, volume,
+		Pannings ? pannings + f : nullptr, panning, frames - f);
+}
+
+constexpr auto kernels = Kernels{
+	InstructionSet::AVX2,
+	&add,
+	&multiply,
+	&addMultiplied<false>,
+	&addMultiplied<true>,
+	&addMultipliedByBuffers<false>,
+	&addMultipliedByBuffers<true>,
+	&sanitize,
+	{
+		{ &multiplyByVolumeAndPanning<false, false>, &multiplyByVolumeAndPanning<false, true> },
+		{ &multiplyByVolumeAndPanning<true, false>, &multiplyByVolumeAndPanning<true, true> }
+	}
+};
+
+} // namespace avx2
+
+
+// AVX-512: 8 frames per vector
+
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC 12 reports the undefined passthrough operands inside its own AVX-512 intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace avx512
+{
+
+LMMS_MIX_HELPERS_TARGET("avx512f") inline __mmask16 finiteMask(__m512 x)
+{
+	return _mm512_cmp_ps_mask(_mm512_sub_ps(x, x), _mm512_setzero_ps(), _CMP_EQ_OQ);
+}
+
+//! Loads 8 per-frame coefficients and spreads them over 16 interleaved samples
+LMMS_MIX_HELPERS_TARGET("avx512f") inline __m512 loadFrameCoeffs(const float* coeffs)
+{
+	const auto spread = _mm512_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+	return _mm512_permutexvar_ps(spread, _mm512_maskz_loadu_ps(0x00ff, coeffs));
+}
+
+LMMS_MIX_HELPERS_TARGET("avx512f") void add(float* dst, const float* src, int frames)
+{
+	int f = 0;
+	for (; f + 8 <= frames; f += 8)
+	{
+		_mm512_storeu_ps(dst + f * 2, _mm512_add_ps(_mm512_loadu_ps(dst + f * 2), _mm512_loadu_ps(src + f * 2)));
+	}
+	_mm256_zeroupper();
+	scalar::add(dst + f * 2, src + f * 2, frames - f);
+}
+
+LMMS_MIX_HELPERS_TARGET("avx512f") void multiply(float* dst, float coeff, int frames)
+{
+	const auto c = _mm512_set1_ps(coeff);
+	int f = 0;
+	for (; f + 8 <= frames; f += 8)
+	{
+		_mm512_storeu_ps(dst + f * 2, _mm512_mul_ps(_mm512_loadu_ps(dst + f * 2), c));
+	}
+	_mm256_zeroupper();
+	scalar::multiply(dst + f * 2, coeff, frames - f);
+}
+
+template<bool Sanitized>
+LMMS_MIX_HELPERS_TARGET("avx512f") void addMultiplied(float* dst, const float* src, float coeff, int frames)
+{
+	const auto c = _mm512_set1_ps(coeff);
+	int f = 0;
+	for (; f + 8 <= frames; f += 8)
+	{
+		const auto s = _mm512_loadu_ps(src + f * 2);
+		const auto product = Sanitized ? _mm512_maskz_mul_ps(finiteMask(s), s, c) : _mm512_mul_ps(s, c);
+		_mm512_storeu_ps(dst + f * 2, _mm512_add_ps(_mm512_loadu_ps(dst + f * 2), product));
+	}
+	_mm256_zeroupper();
+	scalar::addMultiplied<Sanitized>(dst + f * 2, src + f * 2, coeff, frames - f);
+}
+
+template<bool Sanitized>
+LMMS_MIX_HELPERS_TARGET("avx512f") void addMultipliedByBuffers(float* dst, const float* src,
+	const float* coeffs1, const float* coeffs2, int frames)
+{
+	int f = 0;
+	for (; f + 8 <= frames; f += 8)
+	{
+		const auto s = _mm512_loadu_ps(src + f * 2);
+		const auto c1 = loadFrameCoeffs(coeffs1 + f);
+		const auto c2 = loadFrameCoeffs(coeffs2 + f);
+		const auto product = Sanitized
+			? _mm512_maskz_mul_ps(finiteMask(s), _mm512_mul_ps(s, c1), c2)
+			: _mm512_mul_ps(_mm512_mul_ps(s, c1), c2);
+		_mm512_storeu_ps(dst + f * 2, _mm512_add_ps(_mm512_loadu_ps(dst + f * 2), product));
+	}
+	_mm256_zeroupper();
+	scalar::addMultipliedByBuffers<Sanitized>(dst + f * 2, src + f * 2, coeffs1 + f, coeffs2 + f, frames - f);
+}
+
+LMMS_MIX_HELPERS_TARGET("avx512f") bool sanitize(float* buf, int frames)
+{
+	const auto low = _mm512_set1_ps(-SanitizeLimit);
+	const auto high = _mm512_set1_ps(SanitizeLimit);
+	int f = 0;
+	for (; f + 8 <= frames; f += 8)
+	{
+		const auto x = _mm512_loadu_ps(buf + f * 2);
+		if (finiteMask(x) != 0xffff) { return true; }
+		_mm512_storeu_ps(buf + f * 2, _mm512_min_ps(_mm512_max_ps(x, low), high));
+	}
+	_mm256_zeroupper();
+	return scalar::sanitize(buf + f * 2, frames - f);
+}
+
+template<bool Volumes, bool Pannings>
+LMMS_MIX_HELPERS_TARGET("avx512f") void multiplyByVolumeAndPanning(float* dst, const float* volumes, float volume,
+	const float* pannings, float panning, int frames)
+{
+	const auto one = _mm512_set1_ps(1.0f);
+	const auto percent = _mm512_set1_ps(Percent);
+	const auto firstHalf = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+	const auto secondHalf = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+	int f = 0;
+	for (; f + 16 <= frames; f += 16)
+	{
+		const auto v = _mm512_mul_ps(Volumes ? _mm512_loadu_ps(volumes + f) : _mm512_set1_ps(volume), percent);
+		const auto p = _mm512_mul_ps(Pannings ? _mm512_loadu_ps(pannings + f) : _mm512_set1_ps(panning), percent);
+		const auto left = _mm512_mul_ps(_mm512_min_ps(one, _mm512_sub_ps(one, p)), v);
+		const auto right = _mm512_mul_ps(_mm512_min_ps(one, _mm512_add_ps(one, p)), v);
+		float* d = dst + f * 2;
+		_mm512_storeu_ps(d, _mm512_mul_ps(_mm512_loadu_ps(d), _mm512_permutex2var_ps(left, firstHalf, right)));
+		_mm512_storeu_ps(d + 16,
+			_mm512_mul_ps(_mm512_loadu_ps(d + 16), _mm512_permutex2var_ps(left, secondHalf, right)));
+	}
+	_mm256_zeroupper();
+	scalar::multiplyByVolumeAndPanning<Volumes, Pannings>(dst + f * 2, Volumes ? volumes + f : nullptr, volume,
+		Pannings ? pannings + f : nullptr, panning, frames - f);
+}
+
+constexpr auto kernels = Kernels{
+	InstructionSet::AVX512,
+	&add,
+	&multiply,
+	&addMultiplied<false>,
+	&addMultiplied<true>,
+	&addMultipliedByBuffers<false>,
+	&addMultipliedByBuffers<true>,
+	&sanitize,
+	{
+		{ &multiplyByVolumeAndPanning<false, false>, &multiplyByVolumeAndPanning<false, true> },
+		{ &multiplyByVolumeAndPanning<true, false>, &multiplyByVolumeAndPanning<true, true> }
+	}
+};
+
+} // namespace avx512
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // LMMS_MIX_HELPERS_X86
+
+
+#ifdef LMMS_MIX_HELPERS_NEON
+
+// NEON: 2 frames per vector
+
+namespace neon
+{
+
+inline uint32x4_t finiteMask(float32x4_t x)
+{
+	return vceqq_f32(vsubq_f32(x, x), vdupq_n_f32(0.0f));
+}
+
+inline float32x4_t maskProduct(float32x4_t product, uint32x4_t mask)
+{
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(product), mask));
+}
+
+void add(float* dst, const float* src, int frames)
+{
+	int f = 0;
+	for (; f + 2 <= frames; f += 2)
+	{
+		vst1q_f32(dst + f * 2, vaddq_f32(vld1q_f32(dst + f * 2), vld1q_f32(src + f * 2)));
+	}
+	scalar::add(dst + f * 2, src + f * 2, frames - f);
+}
+
+void multiply(float* dst, float coeff, int frames)
+{
+	int f = 0;
+	for (; f + 2 <= frames; f += 2)
+	{
+		vst1q_f32(dst + f * 2, vmulq_n_f32(vld1q_f32(dst + f * 2), coeff));
+	}
+	scalar::multiply(dst + f * 2, coeff, frames - f);
+}
+
+template<bool Sanitized>
+void addMultiplied(float* dst, const float* src, float coeff, int frames)
+{
+	int f = 0;
+	for (; f + 2 <= frames; f += 2)
+	{
+		const auto s = vld1q_f32(src + f * 2);
+		auto product = vmulq_n_f32(s, coeff);
+		if constexpr (Sanitized) { product = maskProduct(product, finiteMask(s)); }
+		vst1q_f32(dst + f * 2, vaddq_f32(vld1q_f32(dst + f * 2), product));
+	}
+	scalar::addMultiplied<Sanitized>(dst + f * 2, src + f * 2, coeff, frames - f);
+}
+
+template<bool Sanitized>
+void addMultipliedByBuffers(float* dst, const float* src, const float* coeffs1, const float* coeffs2, int frames)
+{
+	int f = 0;
+	for (; f + 4 <= frames; f += 4)
+	{
+		const auto c1 = vld1q_f32(coeffs1 + f);
+		const auto c2 = vld1q_f32(coeffs2 + f);
+		const auto c1s = vzipq_f32(c1, c1);
+		const auto c2s = vzipq_f32(c2, c2);
+		for (int half = 0; half < 2; ++half)
+		{
+			float* d = dst + f * 2 + half * 4;
+			const auto s = vld1q_f32(src + f * 2 + half * 4);
+			auto product = vmulq_f32(vmulq_f32(s, c1s.val[half]), c2s.val[half]);
+			if constexpr (Sanitized) { product = maskProduct(product, finiteMask(s)); }
+			vst1q_f32(d, vaddq_f32(vld1q_f32(d), product));
+		}
+	}
+	scalar::addMultipliedByBuffers<Sanitized>(dst + f * 2, src + f * 2, coeffs1 + f, coeffs2 + f, frames - f);
+}
+
+bool sanitize(float* buf, int frames)
+{
+	const auto low = vdupq_n_f32(-SanitizeLimit);
+	const auto high = vdupq_n_f32(SanitizeLimit);
+	int f = 0;
+	for (; f + 2 <= frames; f += 2)
+	{
+		const auto x = vld1q_f32(buf + f * 2);
+		const auto finite = finiteMask(x);
+		const auto pairs = vand_u32(vget_low_u32(finite), vget_high_u32(finite));
+		if ((vget_lane_u32(pairs, 0) & vget_lane_u32(pairs, 1)) == 0) { return true; }
+		vst1q_f32(buf + f * 2, vminq_f32(vmaxq_f32(x, low), high));
+	}
+	return scalar::sanitize(buf + f * 2, frames - f);
+}
+
+template<bool Volumes, bool Pannings>
+void multiplyByVolumeAndPanning(float* dst, const float* volumes, float volume,
+	const float* pannings, float panning, int frames)
+{
+	const auto one = vdupq_n_f32(1.0f);
+	int f = 0;
+	for (; f + 4 <= frames; f += 4)
+	{
+		const auto v = vmulq_n_f32(Volumes ? vld1q_f32(volumes + f) : vdupq_n_f32(volume), Percent);
+		const auto p = vmulq_n_f32(Pannings ? vld1q_f32(pannings + f) : vdupq_n_f32(panning), Percent);
+		const auto left = vmulq_f32(vminq_f32(one, vsubq_f32(one, p)), v);
+		const auto right = vmulq_f32(vminq_f32(one, vaddq_f32(one, p)), v);
+		const auto gains = vzipq_f32(left, right);
+		vst1q_f32(dst + f * 2, vmulq_f32(vld1q_f32(dst + f * 2), gains.val[0]));
+		vst1q_f32(dst + f * 2 + 4, vmulq_f32(vld1q_f32(dst + f * 2 + 4), gains.val[1]));
+	}
+	scalar::multiplyByVolumeAndPanning<Volumes, Pannings>(dst + f * 2, Volumes ? volumes + f : nullptr, volume,
+		Pannings ? pannings + f : nullptr, panning, frames - f);
+}
+
+constexpr auto kernels = Kernels{
+	InstructionSet::NEON,
+	&add,
+	&multiply,
+	&addMultiplied<false>,
+	&addMultiplied<true>,
+	&addMultipliedByBuffers<false>,
+	&addMultipliedByBuffers<true>,
+	&sanitize,
+	{
+		{ &multiplyByVolumeAndPanning<false, false>, &multiplyByVolumeAndPanning<false, true> },
+		{ &multiplyByVolumeAndPanning<true, false>, &multiplyByVolumeAndPanning<true, true> }
+	}
+};
+
+} // namespace neon
+
+#endif // LMMS_MIX_HELPERS_NEON
+
+
+const Kernels* kernelsFor(InstructionSet set)
+{
+	switch (set)
+	{
+	case InstructionSet::Scalar:
+		return &scalar::kernels;
+#ifdef LMMS_MIX_HELPERS_X86
+	case InstructionSet::SSE2:
+		return __builtin_cpu_supports("sse2") ? &sse2::kernels : nullptr;
+	case InstructionSet::AVX2:
+		return __builtin_cpu_supports("avx2") ? &avx2::kernels : nullptr;
+	case InstructionSet::AVX512:
+		return __builtin_cpu_supports("avx512f") ? &avx512::kernels : nullptr;
+#elif defined(LMMS_MIX_HELPERS_SSE2_ONLY)
+	case InstructionSet::SSE2:
+		return &sse2::kernels;
+#elif defined(LMMS_MIX_HELPERS_NEON)
+	case InstructionSet::NEON:
+		return &neon::kernels;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+const Kernels* detectKernels()
+{
+#ifdef LMMS_MIX_HELPERS_X86
+	__builtin_cpu_init();
+#endif
+	for (auto set : { InstructionSet::AVX512, InstructionSet::AVX2, InstructionSet::SSE2, InstructionSet::NEON })
+	{
+		if (const auto k = kernelsFor(set)) { return k; }
+	}
+	return &scalar::kernels;
+}
+
+std::atomic<const Kernels*> s_kernels = nullptr;
+
+inline const Kernels& kernels()
+{
+	auto k = s_kernels.load(std::memory_order_acquire);
+	if (k == nullptr)
+	{
+		// racing first calls pick the same table, so there is nothing to synchronize
+		k = detectKernels();
+		s_kernels.store(k, std::memory_order_release);
+	}
+	return *k;
+}
+
+inline float* samples(SampleFrame* frames)
+{
+	return reinterpret_cast<float*>(frames);
+}
+
+inline const float* samples(const SampleFrame* frames)
+{
+	return reinterpret_cast<const float*>(frames);
+}
+
+} // namespace
+
+
+InstructionSet instructionSet()
+{
+	return kernels().set;
+}
+
+bool setInstructionSet( InstructionSet set )
+{
+	const auto k = kernelsFor(set);
+	if (k == nullptr)
+	{
+		return false;
+	}
+	s_kernels.store(k, std::memory_order_release);
+	return true;
+}
+
+const char* instructionSetName( InstructionSet set )
+{
+	switch (set)
+	{
+	case InstructionSet::Scalar: return "scalar";
+	case InstructionSet::SSE2: return "SSE2";
+	case InstructionSet::AVX2: return "AVX2";
+	case InstructionSet::AVX512: return "AVX-512";
+	case InstructionSet::NEON: return "NEON";
+	}
+	return "unknown";
+}
+
+
 /*! \brief Function for applying MIXOP on all sample frames */
 template<typename MIXOP>
 static inline void run( SampleFrame* dst, const SampleFrame* src, int frames, const MIXOP& OP )
@@ -98,64 +855,40 @@ bool sanitize( SampleFrame* src, int frames )
 		return false;
 	}
 
-	for (int f = 0; f < frames; ++f)
+	if (kernels().sanitize(samples(src), frames))
 	{
-		auto& currentFrame = src[f];
-
-		if (currentFrame.containsInf() || currentFrame.containsNaN())
-		{
-			#ifdef LMMS_DEBUG
-					// TODO don't use printf here
-					printf("Bad data, clearing buffer. frame: ");
-					printf("%d: value %f, %f\n", f, currentFrame.left(), currentFrame.right());
-			#endif
-
-			// Clear the whole buffer if a problem is found
-			zeroSampleFrames(src, frames);
-
-			return true;
-		}
-		else
-		{
-			currentFrame.clamp(sample_t(-1000.0), sample_t(1000.0));
-		}
-	};
+		#ifdef LMMS_DEBUG
+				// TODO don't use printf here
+				for (int f = 0; f < frames; ++f)
+				{
+					if (src[f].containsInf() || src[f].containsNaN())
+					{
+						printf("Bad data, clearing buffer. frame: ");
+						printf("%d: value %f, %f\n", f, src[f].left(), src[f].right());
+						break;
+					}
+				}
+		#endif
+
+		// Clear the whole buffer if a problem is found
+		zeroSampleFrames(src, frames);
+
+		return true;
+	}
 
 	return false;
 }
 
 
-struct AddOp
-{
-	void operator()( SampleFrame& dst, const SampleFrame& src ) const
-	{
-		dst += src;
-	}
-} ;
-
 void add( SampleFrame* dst, const SampleFrame* src, int frames )
 {
-	run<>( dst, src, frames, AddOp() );
+	kernels().add(samples(dst), samples(src), frames);
 }
 
 
-
-struct AddMultipliedOp
-{
-	AddMultipliedOp( float coeff ) : m_coeff( coeff ) { }
-
-	void operator()( SampleFrame& dst, const SampleFrame& src ) const
-	{
-		dst += src * m_coeff;
-	}
-
-	const float m_coeff;
-} ;
-
-
 void addMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
 {
-	run<>( dst, src, frames, AddMultipliedOp(coeffSrc) );
+	kernels().addMultiplied(samples(dst), samples(src), coeffSrc, frames);
 }
 
 
@@ -174,10 +907,14 @@ struct AddSwappedMultipliedOp
 
 void multiply(SampleFrame* dst, float coeff, int frames)
 {
-	for (int i = 0; i < frames; ++i)
-	{
-		dst[i] *= coeff;
-	}
+	kernels().multiply(samples(dst), coeff, frames);
+}
+
+void multiplyByVolumeAndPanning(SampleFrame* dst, float volume, const ValueBuffer* volumeBuf,
+	float panning, const ValueBuffer* panningBuf, int frames)
+{
+	kernels().multiplyByVolumeAndPanning[volumeBuf != nullptr][panningBuf != nullptr](samples(dst),
+		volumeBuf ? volumeBuf->values() : nullptr, volume, panningBuf ? panningBuf->values() : nullptr, panning, frames);
 }
 
 void addSwappedMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
@@ -197,12 +934,8 @@ void addMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coef
 
 void addMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
 {
-	for( int f = 0; f < frames; ++f )
-	{
-		dst[f][0] += src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-	}
-
+	kernels().addMultipliedByBuffers(samples(dst), samples(src), coeffSrcBuf1->values(), coeffSrcBuf2->values(),
+		frames);
 }
 
 void addSanitizedMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
@@ -230,32 +963,11 @@ void addSanitizedMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src,
 		return;
 	}
 
-	for( int f = 0; f < frames; ++f )
-	{
-		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) )
-			? 0.0f
-			: src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) )
-			? 0.0f
-			: src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-	}
-
+	kernels().addSanitizedMultipliedByBuffers(samples(dst), samples(src), coeffSrcBuf1->values(),
+		coeffSrcBuf2->values(), frames);
 }
 
 
-struct AddSanitizedMultipliedOp
-{
-	AddSanitizedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
-
-	void operator()( SampleFrame& dst, const SampleFrame& src ) const
-	{
-		dst[0] += ( std::isinf( src[0] ) || std::isnan( src[0] ) ) ? 0.0f : src[0] * m_coeff;
-		dst[1] += ( std::isinf( src[1] ) || std::isnan( src[1] ) ) ? 0.0f : src[1] * m_coeff;
-	}
-
-	const float m_coeff;
-};
-
 void addSanitizedMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
 {
 	if ( !useNaNHandler() )
@@ -264,7 +976,7 @@ void addSanitizedMultiplied( SampleFrame* dst, const SampleFrame* src, float coe
 		return;
 	}
 
-	run<>( dst, src, frames, AddSanitizedMultipliedOp(coeffSrc) );
+	kernels().addSanitizedMultiplied(samples(dst), samples(src), coeffSrc, frames);
 }
 
 
@@ -22,13 +22,16 @@
  *
  */
 
+#include <algorithm>
 #include <QDomElement>
 
 #include "AudioEngine.h"
 #include "AudioEngineWorkerThread.h"
+#include "AudioPort.h"
 #include "BufferManager.h"
 #include "Mixer.h"
 #include "MixHelpers.h"
+#include "PeriodRing.h"
 #include "Song.h"
 
 #include "InstrumentTrack.h"
@@ -62,6 +65,7 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 	m_fxChain( nullptr ),
 	m_hasInput( false ),
 	m_stillRunning( false ),
+	m_silent( true ),
 	m_peakLeft( 0.0f ),
 	m_peakRight( 0.0f ),
 	m_buffer( new SampleFrame[Engine::audioEngine()->framesPerPeriod()] ),
@@ -69,9 +73,14 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 	m_soloModel( false, _parent ),
 	m_volumeModel(1.f, 0.f, 2.f, 0.001f, _parent),
 	m_name(),
-	m_lock(),
+	m_inputCount( 0 ),
 	m_channelIndex( idx ),
 	m_queued( false ),
+	m_stemTap( nullptr ),
+	m_inputLatency( 0 ),
+	m_latency( 0 ),
+	m_latencyPass( 0 ),
+	m_delayBuffer( new SampleFrame[Engine::audioEngine()->framesPerPeriod()] ),
 	m_dependenciesMet(0)
 {
 	zeroSampleFrames(m_buffer, Engine::audioEngine()->framesPerPeriod());
@@ -83,6 +92,7 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 MixerChannel::~MixerChannel()
 {
 	delete[] m_buffer;
+	delete[] m_delayBuffer;
 }
 
 
@@ -103,8 +113,39 @@ void MixerChannel::incrementDeps()
 	if( i >= m_receives.size() && ! m_queued )
 	{
 		m_queued = true;
-		AudioEngineWorkerThread::addJob( this );
+		if( canSleep() )
+		{
+			sleep();
+		}
+		else
+		{
+			AudioEngineWorkerThread::addJob( this );
+		}
+	}
+}
+
+
+
+bool MixerChannel::canSleep() const
+{
+	if( m_inputCount.load( std::memory_order_relaxed ) > 0 || m_fxChain.isRunning() )
+	{
+		return false;
 	}
+	return std::all_of( m_receives.begin(), m_receives.end(),
+		[]( const MixerRoute * route ) { return route->isSilent(); } );
+}
+
+
+
+void MixerChannel::sleep()
+{
+	// the buffer is still clear, so there is nothing to mix or process; the meters
+	// fall like for any other silent period
+	m_stillRunning = false;
+	m_peakLeft = m_peakRight = 0.0f;
+	processed();
+	done();
 }
 
 void MixerChannel::unmuteForSolo()
@@ -117,17 +158,34 @@ void MixerChannel::unmuteForSolo()
 
 void MixerChannel::doProcessing()
 {
+	// in pipelined mode this is the period before the one of the instruments
+	const AutomatableModel::PreviousPeriodScope previousPeriod;
 	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
 
 	if( m_muted == false )
 	{
+		m_silent = false;
+
+		// every port that fed us this period has finished by now
+		const std::size_t inputs = std::min( m_inputCount.load( std::memory_order_relaxed ), m_inputs.size() );
+		for( std::size_t i = 0; i < inputs; ++i )
+		{
+			MixHelpers::add( m_buffer, m_inputs[i], fpp );
+		}
+		if( inputs > 0 )
+		{
+			m_hasInput = true;
+		}
+
 		for( MixerRoute * senderRoute : m_receives )
 		{
 			MixerChannel * sender = senderRoute->sender();
 			FloatModel * sendModel = senderRoute->amount();
 			if( ! sendModel ) qFatal( "Error: no send model found from %d to %d", senderRoute->senderIndex(), m_channelIndex );
 
-			if( sender->m_hasInput || sender->m_stillRunning )
+			CompensationDelay & compensation = senderRoute->compensation();
+			const bool senderActive = !sender->m_silent;
+			if( !senderRoute->isSilent() )
 			{
 				// figure out if we're getting sample-exact input
 				ValueBuffer * sendBuf = sendModel->valueBuffer();
@@ -136,6 +194,21 @@ void MixerChannel::doProcessing()
 				// mix it's output with this one's output
 				SampleFrame* ch_buf = sender->m_buffer;
 
+				// delay it if the other inputs have more latency, or had until the
+				// crossfade to the new delay is done
+				if( compensation.delay() > 0 || compensation.hasPendingOutput() )
+				{
+					if( senderActive )
+					{
+						compensation.process( ch_buf, m_delayBuffer, fpp );
+					}
+					else
+					{
+						compensation.drain( m_delayBuffer, fpp );
+					}
+					ch_buf = m_delayBuffer;
+				}
+
 				// use sample-exact mixing if sample-exact values are available
 				if( ! volBuf && ! sendBuf ) // neither volume nor send has sample-exact data...
 				{
@@ -186,11 +259,49 @@ void MixerChannel::doProcessing()
 
 
 
+
+void MixerChannel::writeStemTap()
+{
+	if( m_stemTap == nullptr )
+	{
+		return;
+	}
+
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+	SampleFrame* period = m_stemTap->beginWrite();
+	if( m_muted )
+	{
+		zeroSampleFrames( period, fpp );
+	}
+	else if( ValueBuffer * volBuf = m_volumeModel.valueBuffer() )
+	{
+		for( fpp_t f = 0; f < fpp; ++f )
+		{
+			period[f] = m_buffer[f] * volBuf->values()[f];
+		}
+	}
+	else
+	{
+		const float v = m_volumeModel.value();
+		for( fpp_t f = 0; f < fpp; ++f )
+		{
+			period[f] = m_buffer[f] * v;
+		}
+	}
+	m_stemTap->endWrite();
+}
+
+
+
 Mixer::Mixer() :
 	Model( nullptr ),
 	JournallingObject(),
 	m_mixerChannels(),
-	m_lastSoloed(-1)
+	m_lastSoloed(-1),
+	m_inputSlots(0),
+	m_latencyPass(0),
+	m_latency(0),
+	m_delaysClamped(false)
 {
 	// create master channel
 	createChannel();
@@ -218,7 +329,11 @@ int Mixer::createChannel()
 {
 	const int index = m_mixerChannels.size();
 	// create new channel
-	m_mixerChannels.push_back( new MixerChannel( index, this ) );
+	auto channel = new MixerChannel( index, this );
+	Engine::audioEngine()->requestChangeInModel();
+	channel->m_inputs.resize( m_inputSlots );
+	m_mixerChannels.push_back( channel );
+	Engine::audioEngine()->doneChangeInModel();
 
 	// reset channel state
 	clearChannel( index );
@@ -598,37 +713,133 @@ FloatModel * Mixer::channelSendModel( mix_ch_t fromChannel, mix_ch_t toChannel )
 
 void Mixer::mixToChannel( const SampleFrame* _buf, mix_ch_t _ch )
 {
-	if( m_mixerChannels[_ch]->m_muteModel.value() == false )
+	MixerChannel * ch = m_mixerChannels[_ch];
+	if( ch->m_muteModel.value() == false )
+	{
+		// the buffer is only summed up when the channel gets processed,
+		// so concurrent ports don't serialize on the channel here. Each
+		// port feeds one channel per period, so reserveInputs() has
+		// made enough slots, but don't trust a port which didn't register.
+		const std::size_t slot = ch->m_inputCount.fetch_add( 1, std::memory_order_relaxed );
+		if( slot < ch->m_inputs.size() )
+		{
+			ch->m_inputs[slot] = _buf;
+		}
+	}
+}
+
+
+
+
+void Mixer::reserveInputs( std::size_t audioPorts )
+{
+	if( audioPorts <= m_inputSlots ) { return; }
+
+	m_inputSlots = audioPorts;
+	for( MixerChannel * ch : m_mixerChannels )
+	{
+		ch->m_inputs.resize( m_inputSlots );
+	}
+}
+
+
+
+void Mixer::updateLatencies( const std::vector<AudioPort*> & ports )
+{
+	++m_latencyPass;
+
+	// latency of the tracks feeding each channel
+	for( MixerChannel * ch : m_mixerChannels )
+	{
+		ch->m_inputLatency = 0;
+	}
+	for( AudioPort * port : ports )
 	{
-		m_mixerChannels[_ch]->m_lock.lock();
-		MixHelpers::add( m_mixerChannels[_ch]->m_buffer, _buf, Engine::audioEngine()->framesPerPeriod() );
-		m_mixerChannels[_ch]->m_hasInput = true;
-		m_mixerChannels[_ch]->m_lock.unlock();
+		const mix_ch_t ch = port->nextMixerChannel();
+		if( ch >= 0 && ch < numChannels() )
+		{
+			m_mixerChannels[ch]->m_inputLatency = std::max( m_mixerChannels[ch]->m_inputLatency, port->latency() );
+		}
 	}
+
+	// add the latency of the channels sending to each channel
+	for( MixerChannel * ch : m_mixerChannels )
+	{
+		channelLatency( ch );
+	}
+
+	// delay every input of a channel so it arrives together with the latest one
+	f_cnt_t longestDelay = 0;
+	for( AudioPort * port : ports )
+	{
+		const mix_ch_t ch = port->nextMixerChannel();
+		if( ch >= 0 && ch < numChannels() )
+		{
+			const f_cnt_t delay = m_mixerChannels[ch]->m_inputLatency - port->latency();
+			port->setCompensationDelay( delay );
+			longestDelay = std::max( longestDelay, delay );
+		}
+	}
+	for( MixerRoute * route : m_mixerRoutes )
+	{
+		const f_cnt_t delay = route->receiver()->m_inputLatency - route->sender()->m_latency;
+		route->compensation().setDelay( delay );
+		longestDelay = std::max( longestDelay, delay );
+	}
+
+	// this runs every period, so only report when the delays start being clamped
+	const bool clamped = longestDelay > CompensationDelay::MaxDelay;
+	if( clamped && !m_delaysClamped )
+	{
+		qWarning( "Mixer: compensating a latency of %d frames, but delays are limited to %d frames",
+			static_cast<int>( longestDelay ), static_cast<int>( CompensationDelay::MaxDelay ) );
+	}
+	m_delaysClamped = clamped;
+
+	m_latency = m_mixerChannels[0]->m_latency;
 }
 
 
 
 
-void Mixer::prepareMasterMix()
+f_cnt_t Mixer::channelLatency( MixerChannel * ch )
 {
-	zeroSampleFrames(m_mixerChannels[0]->m_buffer, Engine::audioEngine()->framesPerPeriod());
+	// the routing is free of loops, so this visits each channel once per pass
+	if( ch->m_latencyPass != m_latencyPass )
+	{
+		ch->m_latencyPass = m_latencyPass;
+		for( const MixerRoute * route : ch->m_receives )
+		{
+			ch->m_inputLatency = std::max( ch->m_inputLatency, channelLatency( route->sender() ) );
+		}
+		ch->m_latency = ch->m_inputLatency + ch->m_fxChain.latency();
+	}
+	return ch->m_latency;
 }
 
 
 
+
 void Mixer::masterMix( SampleFrame* _buf )
 {
-	const int fpp = Engine::audioEngine()->framesPerPeriod();
+	startMasterMix();
+	// returns once the whole graph has been processed, including all
+	// channels queued while processing
+	AudioEngineWorkerThread::startAndWaitForJobs();
+	finishMasterMix( _buf );
+}
+
 
+
+void Mixer::startMasterMix()
+{
 	// add the channels that have no dependencies (no incoming senders, ie.
 	// no receives) to the jobqueue. The channels that have receives get
-	// added when their senders get processed, which is detected by
-	// dependency counting.
+	// queued by the worker that processed their last sender, which is
+	// detected by dependency counting.
 	// also instantly add all muted channels as they don't need to care
 	// about their senders, and can just increment the deps of their
 	// recipients right away.
-	AudioEngineWorkerThread::resetJobQueue( AudioEngineWorkerThread::JobQueue::OperationMode::Dynamic );
 	for( MixerChannel * ch : m_mixerChannels )
 	{
 		ch->m_muted = ch->m_muteModel.value();
@@ -640,56 +851,68 @@ void Mixer::masterMix( SampleFrame* _buf )
 		else if( ch->m_receives.size() == 0 )
 		{
 			ch->m_queued = true;
-			AudioEngineWorkerThread::addJob( ch );
-		}
-	}
-	while (m_mixerChannels[0]->state() != ThreadableJob::ProcessingState::Done)
-	{
-		bool found = false;
-		for( MixerChannel * ch : m_mixerChannels )
-		{
-			const auto s = ch->state();
-			if (s == ThreadableJob::ProcessingState::Queued
-				|| s == ThreadableJob::ProcessingState::InProgress)
+			if( ch->canSleep() )
 			{
-				found = true;
-				break;
+				ch->sleep();
+			}
+			else
+			{
+				AudioEngineWorkerThread::addJob( ch );
 			}
 		}
-		if( !found )
-		{
-			break;
-		}
-		AudioEngineWorkerThread::startAndWaitForJobs();
 	}
+}
+
+
 
-	// handle sample-exact data in master volume fader
-	ValueBuffer * volBuf = m_mixerChannels[0]->m_volumeModel.valueBuffer();
+void Mixer::finishMasterMix( SampleFrame* _buf )
+{
+	const int fpp = Engine::audioEngine()->framesPerPeriod();
+	MixerChannel * master = m_mixerChannels[0];
 
-	if( volBuf )
+	// a silent master would only add its clear buffer to the output
+	if( !master->m_silent )
 	{
-		for( int f = 0; f < fpp; f++ )
+		// handle sample-exact data in master volume fader
+		ValueBuffer * volBuf = master->m_volumeModel.valueBuffer();
+
+		if( volBuf )
 		{
-			m_mixerChannels[0]->m_buffer[f][0] *= volBuf->values()[f];
-			m_mixerChannels[0]->m_buffer[f][1] *= volBuf->values()[f];
+			for( int f = 0; f < fpp; f++ )
+			{
+				master->m_buffer[f][0] *= volBuf->values()[f];
+				master->m_buffer[f][1] *= volBuf->values()[f];
+			}
 		}
+
+		const float v = volBuf
+			? 1.0f
+			: master->m_volumeModel.value();
+		MixHelpers::addSanitizedMultiplied( _buf, master->m_buffer, v, fpp );
 	}
 
-	const float v = volBuf
-		? 1.0f
-		: m_mixerChannels[0]->m_volumeModel.value();
-	MixHelpers::addSanitizedMultiplied( _buf, m_mixerChannels[0]->m_buffer, v, fpp );
+	// the master output is exported as a whole, only the other channels
+	// can be tapped as stems
+	for( int i = 1; i < numChannels(); ++i )
+	{
+		m_mixerChannels[i]->writeStemTap();
+	}
 
-	// clear all channel buffers and
+	// clear the channel buffers that were written to and
 	// reset channel process state
-	for( int i = 0; i < numChannels(); ++i)
+	for( MixerChannel * ch : m_mixerChannels )
 	{
-		zeroSampleFrames(m_mixerChannels[i]->m_buffer, Engine::audioEngine()->framesPerPeriod());
-		m_mixerChannels[i]->reset();
-		m_mixerChannels[i]->m_queued = false;
+		if( !ch->m_silent )
+		{
+			zeroSampleFrames(ch->m_buffer, fpp);
+			ch->m_silent = true;
+		}
+		ch->reset();
+		ch->m_queued = false;
 		// also reset hasInput
-		m_mixerChannels[i]->m_hasInput = false;
-		m_mixerChannels[i]->m_dependenciesMet = 0;
+		ch->m_hasInput = false;
+		ch->m_inputCount = 0;
+		ch->m_dependenciesMet = 0;
 	}
 }
 
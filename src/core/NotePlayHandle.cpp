@@ -33,6 +33,8 @@
 #include "Instrument.h"
 #include "Song.h"
 
+#include <array>
+
 namespace lmms
 {
 
@@ -366,6 +368,18 @@ bool NotePlayHandle::isFromTrack( const Track * _track ) const
 
 
 
+AudioEngineTracer::Tag NotePlayHandle::traceTag() const
+{
+	const Instrument* instrument = m_instrumentTrack->instrument();
+	return { AudioEngineTracer::Category::NotePlayHandle,
+		instrument ? instrument->descriptor()->displayName : nullptr,
+		m_instrumentTrack->audioPort(),
+		m_instrumentTrack->audioPort()->nextMixerChannel() };
+}
+
+
+
+
 void NotePlayHandle::noteOff( const f_cnt_t _s )
 {
 	if( m_released )
@@ -602,25 +616,37 @@ void NotePlayHandle::resize( const bpm_t _new_tempo )
 }
 
 
-NotePlayHandle ** NotePlayHandleManager::s_available;
-QReadWriteLock NotePlayHandleManager::s_mutex;
-std::atomic_int NotePlayHandleManager::s_availableIndex;
-int NotePlayHandleManager::s_size;
+namespace
+{
 
+// payloads are served from pools of power-of-two block sizes, larger ones
+// from the heap
+constexpr std::size_t MinPayloadSize = 64;
+constexpr std::size_t NumPayloadPools = 8;
+constexpr std::size_t MaxPayloadSize = MinPayloadSize << (NumPayloadPools - 1);
+constexpr std::size_t PayloadLowWaterMark = 16;
 
-void NotePlayHandleManager::init()
+std::unique_ptr<LocklessPoolT<NotePlayHandle>> s_nphPool;
+std::array<std::unique_ptr<LocklessPool>, NumPayloadPools> s_payloadPools;
+
+
+std::size_t payloadPoolIndex(std::size_t size)
 {
-	s_available = new NotePlayHandle*[INITIAL_NPH_CACHE];
+	std::size_t index = 0;
+	while ((MinPayloadSize << index) < size) { ++index; }
+	return index;
+}
+
+} // namespace
 
-	auto n = static_cast<NotePlayHandle *>(std::malloc(sizeof(NotePlayHandle) * INITIAL_NPH_CACHE));
 
-	for( int i=0; i < INITIAL_NPH_CACHE; ++i )
+void NotePlayHandleManager::init()
+{
+	s_nphPool = std::make_unique<LocklessPoolT<NotePlayHandle>>(INITIAL_NPH_CACHE, INITIAL_NPH_CACHE / 4);
+	for (std::size_t i = 0; i < NumPayloadPools; ++i)
 	{
-		s_available[ i ] = n;
-		++n;
+		s_payloadPools[i] = std::make_unique<LocklessPool>(MinPayloadSize << i, 0, PayloadLowWaterMark);
 	}
-	s_availableIndex = INITIAL_NPH_CACHE - 1;
-	s_size = INITIAL_NPH_CACHE;
 }
 
 
@@ -632,12 +658,7 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 				int midiEventChannel,
 				NotePlayHandle::Origin origin )
 {
-	// TODO: use some lockless data structures
-	s_mutex.lockForWrite();
-	if (s_availableIndex < 0) { extend(NPH_CACHE_INCREMENT); }
-	NotePlayHandle * nph = s_available[s_availableIndex--];
-	s_mutex.unlock();
-
+	NotePlayHandle * nph = s_nphPool->alloc();
 	new( (void*)nph ) NotePlayHandle( instrumentTrack, offset, frames, noteToPlay, parent, midiEventChannel, origin );
 	return nph;
 }
@@ -646,31 +667,51 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 void NotePlayHandleManager::release( NotePlayHandle * nph )
 {
 	nph->NotePlayHandle::~NotePlayHandle();
-	s_mutex.lockForRead();
-	s_available[++s_availableIndex] = nph;
-	s_mutex.unlock();
+	s_nphPool->free(nph);
+}
+
+
+void NotePlayHandleManager::reserve( std::size_t voices )
+{
+	s_nphPool->reserve(voices);
 }
 
 
-void NotePlayHandleManager::extend( int c )
+void NotePlayHandleManager::free()
 {
-	s_size += c;
-	auto tmp = new NotePlayHandle*[s_size];
-	delete[] s_available;
-	s_available = tmp;
+	s_nphPool.reset();
+	for (auto& pool : s_payloadPools)
+	{
+		pool.reset();
+	}
+}
 
-	auto n = static_cast<NotePlayHandle *>(std::malloc(sizeof(NotePlayHandle) * c));
 
-	for( int i=0; i < c; ++i )
+LocklessPool::Statistics NotePlayHandleManager::statistics()
+{
+	return s_nphPool->statistics();
+}
+
+
+void* NotePlayHandleManager::allocPayload(std::size_t size)
+{
+	if (size > MaxPayloadSize)
 	{
-		s_available[++s_availableIndex] = n;
-		++n;
+		LocklessPool::countUnpooledAllocation();
+		return ::operator new(size);
 	}
+	return s_payloadPools[payloadPoolIndex(size)]->alloc();
 }
 
-void NotePlayHandleManager::free()
+
+void NotePlayHandleManager::freePayload(void* ptr, std::size_t size)
 {
-	delete[] s_available;
+	if (size > MaxPayloadSize)
+	{
+		::operator delete(ptr);
+		return;
+	}
+	s_payloadPools[payloadPoolIndex(size)]->free(ptr);
 }
 
 
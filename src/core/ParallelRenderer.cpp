@@ -0,0 +1,426 @@
+/*
+ * ParallelRenderer.cpp - render a project in independently rendered segments
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+#include "ParallelRenderer.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QProcess>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <sndfile.h>
+
+#include "Clip.h"
+#include "ConfigManager.h"
+#include "PerfLog.h"
+#include "SampleFrame.h"
+#include "Song.h"
+#include "Track.h"
+
+
+namespace lmms
+{
+
+
+namespace
+{
+
+// largest difference to the sequential render accepted by the verification
+constexpr float VerificationTolerance = 1e-4f;
+
+const char* interpolationName( AudioEngine::qualitySettings::Interpolation interpolation )
+{
+	switch( interpolation )
+	{
+		case AudioEngine::qualitySettings::Interpolation::Linear:
+			return "linear";
+		case AudioEngine::qualitySettings::Interpolation::SincFastest:
+			return "sincfastest";
+		case AudioEngine::qualitySettings::Interpolation::SincMedium:
+			return "sincmedium";
+		case AudioEngine::qualitySettings::Interpolation::SincBest:
+			return "sincbest";
+	}
+	return "sincfastest";
+}
+
+} // namespace
+
+
+
+
+ParallelRenderer::ParallelRenderer( const AudioEngine::qualitySettings & qualitySettings,
+					const OutputSettings & outputSettings,
+					ProjectRenderer::ExportFileFormat fileFormat,
+					const QString & outputFilename,
+					int jobs, bool verify ) :
+	QThread( Engine::audioEngine() ),
+	m_fileDev( nullptr ),
+	m_qualitySettings( qualitySettings ),
+	m_sampleRate( outputSettings.getSampleRate() ),
+	m_projectFile( Engine::getSong()->projectFileName() ),
+	m_verify( verify ),
+	m_verified( false ),
+	m_progress( 0 ),
+	m_abort( false )
+{
+	// the segments are rendered from the saved project
+	if( m_projectFile.isEmpty() || !m_tempDir.isValid() )
+	{
+		return;
+	}
+
+	m_fileDev = ProjectRenderer::createFileDevice( outputSettings, fileFormat, outputFilename );
+	findSegments( jobs );
+}
+
+
+
+
+ParallelRenderer::~ParallelRenderer()
+{
+	wait();
+	delete m_fileDev;
+}
+
+
+
+
+void ParallelRenderer::startProcessing()
+{
+	if( isReady() )
+	{
+		start();
+	}
+}
+
+
+
+
+void ParallelRenderer::abortProcessing()
+{
+	m_abort = true;
+	wait();
+}
+
+
+
+
+void ParallelRenderer::updateConsoleProgress()
+{
+	fprintf( stderr, "\r%3d%% (%d segments)  ", m_progress, static_cast<int>( m_segments.size() ) );
+	fflush( stderr );
+}
+
+
+
+
+void ParallelRenderer::findSegments( int jobs )
+{
+	Song * song = Engine::getSong();
+	song->updateLength();
+
+	// a regular export renders an extra bar for the tails
+	const tick_t songEnd = TimePos( song->length() + 1, 0 ).getTicks();
+
+	std::vector<tick_t> splits;
+
+	// with a changing tempo the frame of a tick can't be computed upfront
+	if( jobs > 1 && !song->tempoModel().isAutomatedOrControlled() )
+	{
+		// collect the ranges in which anything is played
+		std::vector<std::pair<tick_t, tick_t>> busy;
+		for( const Track * track : song->tracks() )
+		{
+			if( track->type() == Track::Type::Automation || track->isMuted() )
+			{
+				continue;
+			}
+			for( const Clip * clip : track->getClips() )
+			{
+				if( !clip->isMuted() )
+				{
+					busy.emplace_back( clip->startPosition().getTicks(), clip->endPosition().getTicks() );
+				}
+			}
+		}
+		std::sort( busy.begin(), busy.end() );
+
+		// candidates are the latest whole-frame tick of every gap that
+		// leaves at least MinimumGapBars for the tails to decay
+		const tick_t minimumGap = MinimumGapBars * TimePos::ticksPerBar();
+		std::vector<tick_t> candidates;
+		tick_t busyUntil = -1;
+		for( const auto & range : busy )
+		{
+			if( busyUntil >= 0 )
+			{
+				for( tick_t tick = range.first; tick >= busyUntil + minimumGap; --tick )
+				{
+					if( startsOnFrame( tick ) )
+					{
+						candidates.push_back( tick );
+						break;
+					}
+				}
+			}
+			busyUntil = std::max( busyUntil, range.second );
+		}
+
+		// pick the candidate closest to each evenly spaced target
+		for( int i = 1; i < jobs && !candidates.empty(); ++i )
+		{
+			const tick_t target = songEnd * i / jobs;
+			const auto closest = std::min_element( candidates.begin(), candidates.end(),
+				[target]( tick_t a, tick_t b ) { return std::abs( a - target ) < std::abs( b - target ); } );
+			if( splits.empty() || *closest > splits.back() )
+			{
+				splits.push_back( *closest );
+			}
+		}
+	}
+
+	tick_t begin = 0;
+	splits.push_back( songEnd );
+	for( std::size_t i = 0; i < splits.size(); ++i )
+	{
+		const bool last = i + 1 == splits.size();
+		const f_cnt_t frames = last ? 0 : tickToFrame( splits[i] ) - tickToFrame( begin );
+		m_segments.push_back( { begin, splits[i], frames,
+			m_tempDir.filePath( QString( "segment%1.wav" ).arg( i ) ) } );
+		begin = splits[i];
+	}
+}
+
+
+
+
+bool ParallelRenderer::startsOnFrame( tick_t tick ) const
+{
+	// same as Engine::framesPerTick(), but in integers
+	const auto numerator = static_cast<std::int64_t>( tick ) * m_sampleRate * 60 * 4;
+	const auto denominator = static_cast<std::int64_t>( DefaultTicksPerBar ) * Engine::getSong()->getTempo();
+	return numerator % denominator == 0;
+}
+
+
+
+
+f_cnt_t ParallelRenderer::tickToFrame( tick_t tick ) const
+{
+	// exact as long as the tick starts on a whole frame
+	const auto numerator = static_cast<std::int64_t>( tick ) * m_sampleRate * 60 * 4;
+	const auto denominator = static_cast<std::int64_t>( DefaultTicksPerBar ) * Engine::getSong()->getTempo();
+	return static_cast<f_cnt_t>( numerator / denominator );
+}
+
+
+
+
+QStringList ParallelRenderer::renderArguments( const QString & outputFile, const Segment * segment ) const
+{
+	QStringList args{ "--allowroot", "render", m_projectFile,
+		"--format", "wav", "--float",
+		"--samplerate", QString::number( m_sampleRate ),
+		"--interpolation", interpolationName( m_qualitySettings.interpolation ),
+		// use the same settings as this process, not whatever is the default
+		"--config", ConfigManager::inst()->configFile(),
+		"--output", outputFile };
+	if( segment )
+	{
+		args << "--range" << QString( "%1:%2" ).arg( segment->begin ).arg( segment->end );
+	}
+	return args;
+}
+
+
+
+
+void ParallelRenderer::run()
+{
+	PerfLogTimer perfLog( "Parallel Render" );
+
+	std::vector<std::unique_ptr<QProcess>> processes;
+	auto launch = [&processes]( const QStringList & args )
+	{
+		auto process = std::make_unique<QProcess>();
+		process->setStandardOutputFile( QProcess::nullDevice() );
+		process->setStandardErrorFile( QProcess::nullDevice() );
+		process->start( QCoreApplication::applicationFilePath(), args );
+		processes.push_back( std::move( process ) );
+	};
+
+	for( const Segment & segment : m_segments )
+	{
+		launch( renderArguments( segment.file, &segment ) );
+	}
+	const QString referenceFile = m_tempDir.filePath( "reference.wav" );
+	if( m_verify )
+	{
+		launch( renderArguments( referenceFile, nullptr ) );
+	}
+
+	bool failed = false;
+	int done = 0;
+	for( auto & process : processes )
+	{
+		while( !m_abort && process->state() != QProcess::NotRunning )
+		{
+			process->waitForFinished( 100 );
+		}
+		if( m_abort )
+		{
+			break;
+		}
+		if( process->exitStatus() != QProcess::NormalExit || process->exitCode() != 0 )
+		{
+			fprintf( stderr, "\nRendering %s failed\n",
+				process->arguments().join( ' ' ).toUtf8().constData() );
+			failed = true;
+		}
+		m_progress = ++done * 90 / static_cast<int>( processes.size() );
+		emit progressChanged( m_progress );
+	}
+
+	if( m_abort || failed )
+	{
+		for( auto & process : processes )
+		{
+			process->kill();
+			process->waitForFinished();
+		}
+		QFile( m_fileDev->outputFile() ).remove();
+		return;
+	}
+
+	if( !stitch() )
+	{
+		QFile( m_fileDev->outputFile() ).remove();
+		return;
+	}
+
+	m_progress = 100;
+	emit progressChanged( m_progress );
+}
+
+
+
+
+bool ParallelRenderer::stitch()
+{
+	constexpr fpp_t chunkFrames = DEFAULT_BUFFER_SIZE;
+	std::vector<float> interleaved( chunkFrames * DEFAULT_CHANNELS );
+	std::vector<float> reference( chunkFrames * DEFAULT_CHANNELS );
+	std::vector<SampleFrame> chunk( chunkFrames );
+
+	SNDFILE * referenceFile = nullptr;
+	SF_INFO referenceInfo{};
+	if( m_verify )
+	{
+		referenceFile = sf_open( m_tempDir.filePath( "reference.wav" ).toUtf8().constData(),
+			SFM_READ, &referenceInfo );
+		if( referenceFile == nullptr || referenceInfo.channels != DEFAULT_CHANNELS )
+		{
+			fprintf( stderr, "\nCould not read the reference render\n" );
+			if( referenceFile ) { sf_close( referenceFile ); }
+			return false;
+		}
+	}
+
+	f_cnt_t written = 0;
+	f_cnt_t compared = 0;
+	float maxDifference = 0.0f;
+	f_cnt_t maxDifferenceFrame = 0;
+
+	for( const Segment & segment : m_segments )
+	{
+		SF_INFO info{};
+		SNDFILE * file = sf_open( segment.file.toUtf8().constData(), SFM_READ, &info );
+		if( file == nullptr || info.channels != DEFAULT_CHANNELS )
+		{
+			fprintf( stderr, "\nCould not read %s\n", segment.file.toUtf8().constData() );
+			if( file ) { sf_close( file ); }
+			if( referenceFile ) { sf_close( referenceFile ); }
+			return false;
+		}
+
+		f_cnt_t remaining = segment.frames ? segment.frames : static_cast<f_cnt_t>( info.frames );
+		while( remaining > 0 )
+		{
+			const auto frames = static_cast<fpp_t>( std::min<f_cnt_t>( remaining, chunkFrames ) );
+
+			// keep the following segments in place if this one came out short
+			const auto read = std::max<sf_count_t>( sf_readf_float( file, interleaved.data(), frames ), 0 );
+			std::fill( interleaved.begin() + read * DEFAULT_CHANNELS, interleaved.end(), 0.0f );
+
+			for( fpp_t f = 0; f < frames; ++f )
+			{
+				chunk[f] = SampleFrame( interleaved[f * 2], interleaved[f * 2 + 1] );
+			}
+			m_fileDev->writeFrames( chunk.data(), frames );
+
+			if( referenceFile )
+			{
+				const sf_count_t referenceRead = sf_readf_float( referenceFile, reference.data(), frames );
+				for( sf_count_t f = 0; f < referenceRead; ++f )
+				{
+					for( int ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+					{
+						const float difference = std::abs( interleaved[f * 2 + ch] - reference[f * 2 + ch] );
+						if( difference > maxDifference )
+						{
+							maxDifference = difference;
+							maxDifferenceFrame = written + f;
+						}
+					}
+				}
+				compared += std::max<sf_count_t>( referenceRead, 0 );
+			}
+
+			written += frames;
+			remaining -= frames;
+		}
+		sf_close( file );
+	}
+
+	if( referenceFile )
+	{
+		const auto referenceFrames = static_cast<f_cnt_t>( referenceInfo.frames );
+		sf_close( referenceFile );
+
+		m_verified = maxDifference <= VerificationTolerance && referenceFrames == written;
+		fprintf( stderr, "\nVerification %s: %zu of %zu frames compared, "
+				"largest difference %g at frame %zu, sequential render has %zu frames\n",
+			m_verified ? "passed" : "FAILED",
+			static_cast<std::size_t>( compared ), static_cast<std::size_t>( written ),
+			maxDifference, static_cast<std::size_t>( maxDifferenceFrame ),
+			static_cast<std::size_t>( referenceFrames ) );
+	}
+
+	return true;
+}
+
+
+} // namespace lmms
@@ -0,0 +1,188 @@
+/*
+ * PeriodRing.cpp - single-producer/single-consumer ring of audio periods
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+#include "PeriodRing.h"
+
+#include <algorithm>
+
+#include "SampleFrame.h"
+
+
+namespace lmms
+{
+
+
+PeriodRing::PeriodRing(std::size_t capacity, fpp_t framesPerPeriod) :
+	m_capacity(std::max<std::size_t>(capacity, 1)),
+	m_framesPerPeriod(framesPerPeriod),
+	m_periods(std::make_unique<SampleFrame[]>(m_capacity * framesPerPeriod)),
+	m_endOfStream(std::make_unique<bool[]>(m_capacity)),
+	m_writeIndex(0),
+	m_readIndex(0),
+	m_minFillLevel(m_capacity),
+	m_underruns(0)
+{
+}
+
+
+
+
+PeriodRing::~PeriodRing() = default;
+
+
+
+
+SampleFrame* PeriodRing::beginWrite()
+{
+	const auto index = waitForFreeSlot();
+	m_endOfStream[index % m_capacity] = false;
+	return period(index);
+}
+
+
+
+
+void PeriodRing::endWrite()
+{
+	m_writeIndex.fetch_add(1, std::memory_order_release);
+	m_writeIndex.notify_one();
+}
+
+
+
+
+void PeriodRing::close()
+{
+	const auto index = waitForFreeSlot();
+	m_endOfStream[index % m_capacity] = true;
+	endWrite();
+}
+
+
+
+
+void PeriodRing::waitUntilRead()
+{
+	const auto write = m_writeIndex.load(std::memory_order_relaxed);
+	auto read = m_readIndex.load(std::memory_order_acquire);
+	while (read != write)
+	{
+		m_readIndex.wait(read, std::memory_order_acquire);
+		read = m_readIndex.load(std::memory_order_acquire);
+	}
+}
+
+
+
+
+const SampleFrame* PeriodRing::beginRead()
+{
+	const auto read = m_readIndex.load(std::memory_order_relaxed);
+	auto write = m_writeIndex.load(std::memory_order_acquire);
+
+	const std::size_t fill = write - read;
+	if (fill < m_minFillLevel.load(std::memory_order_relaxed))
+	{
+		m_minFillLevel.store(fill, std::memory_order_relaxed);
+	}
+
+	if (write == read)
+	{
+		m_underruns.fetch_add(1, std::memory_order_relaxed);
+		do
+		{
+			m_writeIndex.wait(write, std::memory_order_acquire);
+			write = m_writeIndex.load(std::memory_order_acquire);
+		}
+		while (write == read);
+	}
+
+	return m_endOfStream[read % m_capacity] ? nullptr : period(read);
+}
+
+
+
+
+void PeriodRing::endRead()
+{
+	m_readIndex.fetch_add(1, std::memory_order_release);
+	m_readIndex.notify_one();
+}
+
+
+
+
+void PeriodRing::reset()
+{
+	m_writeIndex.store(0, std::memory_order_relaxed);
+	m_readIndex.store(0, std::memory_order_relaxed);
+	resetStatistics();
+}
+
+
+
+
+PeriodRing::Statistics PeriodRing::statistics() const
+{
+	return {
+		m_capacity,
+		fillLevel(),
+		m_minFillLevel.load(std::memory_order_relaxed),
+		m_underruns.load(std::memory_order_relaxed)
+	};
+}
+
+
+
+
+void PeriodRing::resetStatistics()
+{
+	m_minFillLevel.store(m_capacity, std::memory_order_relaxed);
+	m_underruns.store(0, std::memory_order_relaxed);
+}
+
+
+
+
+SampleFrame* PeriodRing::period(std::uint32_t index) const
+{
+	return m_periods.get() + (index % m_capacity) * m_framesPerPeriod;
+}
+
+
+
+
+std::uint32_t PeriodRing::waitForFreeSlot()
+{
+	const auto write = m_writeIndex.load(std::memory_order_relaxed);
+	auto read = m_readIndex.load(std::memory_order_acquire);
+	while (write - read >= m_capacity)
+	{
+		m_readIndex.wait(read, std::memory_order_acquire);
+		read = m_readIndex.load(std::memory_order_acquire);
+	}
+	return write;
+}
+
+
+} // namespace lmms
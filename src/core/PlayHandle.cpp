@@ -24,6 +24,7 @@
  
 #include "PlayHandle.h"
 #include "AudioEngine.h"
+#include "AudioPort.h"
 #include "BufferManager.h"
 #include "Engine.h"
 
@@ -37,8 +38,8 @@ PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
 		m_type(type),
 		m_offset(offset),
 		m_affinity(QThread::currentThread()),
-		m_playHandleBuffer(BufferManager::acquire()),
-		m_bufferReleased(true),
+		m_playHandleBuffer{BufferManager::acquire(), nullptr},
+		m_bufferReleased{true, true},
 		m_usesBuffer(true)
 {
 }
@@ -46,7 +47,10 @@ PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
 
 PlayHandle::~PlayHandle()
 {
-	BufferManager::release(m_playHandleBuffer);
+	for (auto buffer : m_playHandleBuffer)
+	{
+		if (buffer) { BufferManager::release(buffer); }
+	}
 }
 
 
@@ -54,9 +58,15 @@ void PlayHandle::doProcessing()
 {
 	if( m_usesBuffer )
 	{
-		m_bufferReleased = false;
-		zeroSampleFrames(m_playHandleBuffer, Engine::audioEngine()->framesPerPeriod());
-		play( buffer() );
+		const int index = Engine::audioEngine()->playHandleWriteBuffer();
+		// the second buffer is only needed in pipelined mode
+		if (m_playHandleBuffer[index] == nullptr)
+		{
+			m_playHandleBuffer[index] = BufferManager::acquire();
+		}
+		m_bufferReleased[index] = false;
+		zeroSampleFrames(m_playHandleBuffer[index], Engine::audioEngine()->framesPerPeriod());
+		play(m_playHandleBuffer[index]);
 	}
 	else
 	{
@@ -65,14 +75,28 @@ void PlayHandle::doProcessing()
 }
 
 
+AudioEngineTracer::Tag PlayHandle::traceTag() const
+{
+	return { AudioEngineTracer::Category::PlayHandle, nullptr, m_audioPort,
+		m_audioPort ? m_audioPort->nextMixerChannel() : -1 };
+}
+
+
 void PlayHandle::releaseBuffer()
 {
-	m_bufferReleased = true;
+	m_bufferReleased[Engine::audioEngine()->playHandleReadBuffer()] = true;
+}
+
+
+void PlayHandle::releaseBuffers()
+{
+	m_bufferReleased[0] = m_bufferReleased[1] = true;
 }
 
 SampleFrame* PlayHandle::buffer()
 {
-	return m_bufferReleased ? nullptr : m_playHandleBuffer;
+	const int index = Engine::audioEngine()->playHandleReadBuffer();
+	return m_bufferReleased[index] ? nullptr : m_playHandleBuffer[index];
 };
 
 } // namespace lmms
\ No newline at end of file
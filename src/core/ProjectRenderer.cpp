@@ -26,6 +26,9 @@
 #include <QFile>
 
 #include "ProjectRenderer.h"
+#include "AudioPort.h"
+#include "Mixer.h"
+#include "PeriodRing.h"
 #include "Song.h"
 #include "PerfLog.h"
 
@@ -39,6 +42,77 @@ namespace lmms
 {
 
 
+namespace
+{
+
+// periods buffered per stem before rendering has to wait for its encoder
+constexpr std::size_t StemRingDepth = 16;
+
+//! Device the audio engine renders to during a stem export. The periods are
+//! pulled by ProjectRenderer::run(), the master output itself is dropped.
+class NullAudioDevice : public AudioDevice
+{
+public:
+	NullAudioDevice( sample_rate_t sampleRate, AudioEngine* audioEngine ) :
+		AudioDevice( DEFAULT_CHANNELS, audioEngine )
+	{
+		setSampleRate( sampleRate );
+	}
+} ;
+
+} // namespace
+
+
+
+
+//! Encodes the periods of one stem on its own thread
+class ProjectRenderer::StemWriter : public QThread
+{
+public:
+	StemWriter( AudioFileDevice* device, fpp_t framesPerPeriod ) :
+		m_device( device ),
+		m_ring( StemRingDepth, framesPerPeriod ),
+		m_framesPerPeriod( framesPerPeriod )
+	{
+		setObjectName( "ProjectRenderer::StemWriter" );
+	}
+
+	~StemWriter() override
+	{
+		wait();
+		delete m_device;
+	}
+
+	AudioFileDevice* device() const
+	{
+		return m_device;
+	}
+
+	PeriodRing* ring()
+	{
+		return &m_ring;
+	}
+
+private:
+	void run() override
+	{
+		while( const SampleFrame* buffer = m_ring.beginRead() )
+		{
+			m_device->writeFrames( buffer, m_framesPerPeriod );
+			m_ring.endRead();
+		}
+		// release the end-of-stream marker
+		m_ring.endRead();
+	}
+
+	AudioFileDevice* m_device;
+	PeriodRing m_ring;
+	const fpp_t m_framesPerPeriod;
+} ;
+
+
+
+
 const std::array<ProjectRenderer::FileEncodeDevice, 5> ProjectRenderer::fileEncodeDevices
 {
 
@@ -83,10 +157,61 @@ ProjectRenderer::ProjectRenderer( const AudioEngine::qualitySettings & qualitySe
 					ExportFileFormat exportFileFormat,
 					const QString & outputFilename ) :
 	QThread( Engine::audioEngine() ),
+	m_device( nullptr ),
+	m_fileDev( nullptr ),
+	m_qualitySettings( qualitySettings ),
+	m_progress( 0 ),
+	m_abort( false ),
+	m_pipelined( Engine::audioEngine()->isPipelined() ),
+	m_wasPipelined( false )
+{
+	m_fileDev = createFileDevice( outputSettings, exportFileFormat, outputFilename );
+	m_device = m_fileDev;
+}
+
+
+
+
+ProjectRenderer::ProjectRenderer( const AudioEngine::qualitySettings & qualitySettings,
+					const OutputSettings & outputSettings,
+					ExportFileFormat exportFileFormat,
+					const std::vector<Stem> & stems ) :
+	QThread( Engine::audioEngine() ),
+	m_device( nullptr ),
 	m_fileDev( nullptr ),
 	m_qualitySettings( qualitySettings ),
+	m_stems( stems ),
 	m_progress( 0 ),
-	m_abort( false )
+	m_abort( false ),
+	m_pipelined( Engine::audioEngine()->isPipelined() ),
+	m_wasPipelined( false )
+{
+	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
+	for( const Stem & stem : m_stems )
+	{
+		AudioFileDevice * dev = createFileDevice( outputSettings, exportFileFormat, stem.outputFile );
+		if( dev == nullptr )
+		{
+			m_stemWriters.clear();
+			return;
+		}
+		m_stemWriters.push_back( std::make_unique<StemWriter>( dev, frames ) );
+	}
+
+	m_device = new NullAudioDevice( outputSettings.getSampleRate(), Engine::audioEngine() );
+}
+
+
+
+
+ProjectRenderer::~ProjectRenderer() = default;
+
+
+
+
+AudioFileDevice * ProjectRenderer::createFileDevice( const OutputSettings & outputSettings,
+					ExportFileFormat exportFileFormat,
+					const QString & outputFilename )
 {
 	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[static_cast<std::size_t>(exportFileFormat)].m_getDevInst;
 
@@ -94,15 +219,16 @@ ProjectRenderer::ProjectRenderer( const AudioEngine::qualitySettings & qualitySe
 	{
 		bool successful = false;
 
-		m_fileDev = audioEncoderFactory(
+		AudioFileDevice * dev = audioEncoderFactory(
 					outputFilename, outputSettings, DEFAULT_CHANNELS,
 					Engine::audioEngine(), successful );
-		if( !successful )
+		if( successful )
 		{
-			delete m_fileDev;
-			m_fileDev = nullptr;
+			return dev;
 		}
+		delete dev;
 	}
+	return nullptr;
 }
 
 
@@ -145,7 +271,15 @@ void ProjectRenderer::startProcessing()
 	{
 		// Have to do audio engine stuff with GUI-thread affinity in order to
 		// make slots connected to sampleRateChanged()-signals being called immediately.
-		Engine::audioEngine()->setAudioDevice( m_fileDev, m_qualitySettings, false, false );
+		Engine::audioEngine()->setAudioDevice( m_device, m_qualitySettings, false, false );
+
+		m_wasPipelined = Engine::audioEngine()->isPipelined();
+		Engine::audioEngine()->setPipelined( m_pipelined );
+
+		for( auto & writer : m_stemWriters )
+		{
+			writer->start();
+		}
 
 		start(
 #ifndef LMMS_BUILD_WIN32
@@ -162,6 +296,15 @@ void ProjectRenderer::run()
 	PerfLogTimer perfLog("Project Render");
 
 	Engine::getSong()->startExport();
+	// In pipelined mode, the instruments of the first period are only
+	// mixed in the next one.
+	if (Engine::audioEngine()->isPipelined())
+	{
+		Engine::audioEngine()->nextBuffer();
+	}
+	// Stems are tapped while the period is mixed, the master output only
+	// shows up one period later.
+	connectStems( true );
 	// Skip first empty buffer.
 	Engine::audioEngine()->nextBuffer();
 
@@ -173,7 +316,7 @@ void ProjectRenderer::run()
 	// Continually track and emit progress percentage to listeners.
 	while (!Engine::getSong()->isExportDone() && !m_abort)
 	{
-		m_fileDev->processNextBuffer();
+		m_device->processNextBuffer();
 		const int nprog = Engine::getSong()->getExportProgress();
 		if (m_progress != nprog)
 		{
@@ -182,18 +325,64 @@ void ProjectRenderer::run()
 		}
 	}
 
+	// The last period of the song is still in flight: in pipelined mode it
+	// has yet to be mixed, and the master output lags the stems by a period.
+	// Render until both have caught up, so they cover the same periods.
+	if (!m_abort)
+	{
+		if (Engine::audioEngine()->isPipelined())
+		{
+			m_device->processNextBuffer();
+		}
+		connectStems( false );
+		m_device->processNextBuffer();
+	}
+
 	// Notify the audio engine of the end of processing.
 	Engine::audioEngine()->stopProcessing();
 
+	connectStems( false );
+	Engine::audioEngine()->setPipelined( m_wasPipelined );
+	for( auto & writer : m_stemWriters )
+	{
+		writer->ring()->close();
+		writer->wait();
+	}
+
 	Engine::getSong()->stopExport();
 
 	perfLog.end();
 
-	// If the user aborted export-process, the file has to be deleted.
-	const QString f = m_fileDev->outputFile();
+	// If the user aborted export-process, the files have to be deleted.
 	if( m_abort )
 	{
-		QFile( f ).remove();
+		if( m_fileDev )
+		{
+			QFile( m_fileDev->outputFile() ).remove();
+		}
+		for( const auto & writer : m_stemWriters )
+		{
+			QFile( writer->device()->outputFile() ).remove();
+		}
+	}
+}
+
+
+
+
+void ProjectRenderer::connectStems( bool enable )
+{
+	for( std::size_t i = 0; i < m_stems.size(); ++i )
+	{
+		PeriodRing * tap = enable ? m_stemWriters[i]->ring() : nullptr;
+		if( m_stems[i].port )
+		{
+			m_stems[i].port->setStemTap( tap );
+		}
+		if( m_stems[i].channel )
+		{
+			m_stems[i].channel->m_stemTap = tap;
+		}
 	}
 }
 
@@ -27,7 +27,10 @@
 
 #include "RenderManager.h"
 
+#include "InstrumentTrack.h"
+#include "Mixer.h"
 #include "PatternStore.h"
+#include "SampleTrack.h"
 #include "Song.h"
 
 
@@ -57,6 +60,10 @@ RenderManager::~RenderManager()
 
 void RenderManager::abortProcessing()
 {
+	if( m_parallelRenderer )
+	{
+		m_parallelRenderer->abortProcessing();
+	}
 	if ( m_activeRenderer ) {
 		disconnect( m_activeRenderer.get(), SIGNAL(finished()),
 				this, SLOT(renderNextTrack()));
@@ -133,12 +140,96 @@ void RenderManager::renderTracks()
 	renderNextTrack();
 }
 
+// Render the song once, tapping the output of every track
+void RenderManager::renderStems( bool includeMixerChannels )
+{
+	std::vector<ProjectRenderer::Stem> stems;
+
+	auto addTracks = [&]( const TrackContainer::TrackList& tl )
+	{
+		for (const auto& tk : tl)
+		{
+			if( tk->isMuted() )
+			{
+				continue;
+			}
+			// Don't render automation tracks
+			AudioPort* port = nullptr;
+			if( tk->type() == Track::Type::Instrument )
+			{
+				port = static_cast<InstrumentTrack*>( tk )->audioPort();
+			}
+			else if( tk->type() == Track::Type::Sample )
+			{
+				port = static_cast<SampleTrack*>( tk )->audioPort();
+			}
+			if( port )
+			{
+				const int trackNum = stems.size() + 1;
+				stems.push_back( { port, nullptr, pathForTrack( tk, trackNum ) } );
+			}
+		}
+	};
+	addTracks( Engine::getSong()->tracks() );
+	addTracks( Engine::patternStore()->tracks() );
+
+	if( includeMixerChannels )
+	{
+		Mixer* mixer = Engine::mixer();
+		for( int i = 1; i < mixer->numChannels(); ++i )
+		{
+			stems.push_back( { nullptr, mixer->mixerChannel( i ), pathForMixerChannel( i ) } );
+		}
+	}
+
+	m_activeRenderer = std::make_unique<ProjectRenderer>(
+			m_qualitySettings,
+			m_outputSettings,
+			m_format,
+			stems);
+
+	startRenderer();
+}
+
 // Render the song into a single track
 void RenderManager::renderProject()
 {
 	render( m_outputPath );
 }
 
+// Render the song into a single track, in segments rendered in parallel
+void RenderManager::renderProjectParallel( int jobs, bool verify )
+{
+	m_parallelRenderer = std::make_unique<ParallelRenderer>(
+			m_qualitySettings,
+			m_outputSettings,
+			m_format,
+			m_outputPath,
+			jobs,
+			verify);
+
+	if( m_parallelRenderer->isReady() )
+	{
+		connect( m_parallelRenderer.get(), SIGNAL(progressChanged(int)),
+				this, SIGNAL(progressChanged(int)));
+		connect( m_parallelRenderer.get(), SIGNAL(finished()),
+				this, SLOT(parallelRenderFinished()));
+
+		m_parallelRenderer->startProcessing();
+	}
+	else
+	{
+		qDebug( "Parallel renderer needs a saved project and a file device!" );
+		parallelRenderFinished();
+	}
+}
+
+void RenderManager::parallelRenderFinished()
+{
+	m_parallelRenderer.reset();
+	emit finished();
+}
+
 void RenderManager::render(QString outputPath)
 {
 	m_activeRenderer = std::make_unique<ProjectRenderer>(
@@ -147,6 +238,11 @@ void RenderManager::render(QString outputPath)
 			m_format,
 			outputPath);
 
+	startRenderer();
+}
+
+void RenderManager::startRenderer()
+{
 	if( m_activeRenderer->isReady() )
 	{
 		// pass progress signals through
@@ -188,8 +284,23 @@ QString RenderManager::pathForTrack(const Track *track, int num)
 	return QDir(m_outputPath).filePath(name);
 }
 
+// Determine the output path for a mixer channel when rendering stems
+QString RenderManager::pathForMixerChannel( int channel )
+{
+	QString extension = ProjectRenderer::getFileExtensionFromFormat( m_format );
+	QString name = Engine::mixer()->mixerChannel( channel )->m_name;
+	name = name.remove(QRegularExpression(FILENAME_FILTER));
+	name = QString( "mixer%1_%2%3" ).arg( channel ).arg( name ).arg( extension );
+	return QDir(m_outputPath).filePath(name);
+}
+
 void RenderManager::updateConsoleProgress()
 {
+	if ( m_parallelRenderer )
+	{
+		m_parallelRenderer->updateConsoleProgress();
+	}
+
 	if ( m_activeRenderer )
 	{
 		m_activeRenderer->updateConsoleProgress();
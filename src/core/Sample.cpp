@@ -24,14 +24,25 @@
 
 #include "Sample.h"
 
+#include "SampleCache.h"
+
 #include "lmms_math.h"
 
 #include <cassert>
 
 namespace lmms {
 
+namespace {
+
+// the source frames are gathered here before resampling, enough for a full period at the original
+// pitch; higher pitches are resampled in several chunks. Only used within one call of play(), so
+// all voices played on a thread can share it.
+thread_local std::array<SampleFrame, DEFAULT_BUFFER_SIZE + 64> s_scratch;
+
+} // namespace
+
 Sample::Sample(const QString& audioFile)
-	: m_buffer(std::make_shared<SampleBuffer>(audioFile))
+	: m_buffer(SampleCache::get(audioFile))
 	, m_startFrame(0)
 	, m_endFrame(m_buffer->size())
 	, m_loopStartFrame(0)
@@ -133,17 +144,35 @@ bool Sample::play(SampleFrame* dst, PlaybackState* state, size_t numFrames, floa
 
 	state->m_frameIndex = std::max<int>(m_startFrame, state->m_frameIndex);
 
-	auto playBuffer = std::vector<SampleFrame>(numFrames / resampleRatio + marginSize);
-	playRaw(playBuffer.data(), playBuffer.size(), state, loopMode);
+	if (resampleRatio == 1.0 && !state->m_varyingPitch)
+	{
+		// nothing to resample, copy the frames straight to the output
+		playRaw(dst, numFrames, state, loopMode);
+		advance(state, numFrames, loopMode);
+	}
+	else
+	{
+		state->resampler().setRatio(resampleRatio);
 
-	state->resampler().setRatio(resampleRatio);
+		auto& scratch = s_scratch;
+		auto outputFrames = std::size_t{0};
+		while (outputFrames < numFrames)
+		{
+			const auto inputFrames = std::min(
+				static_cast<std::size_t>((numFrames - outputFrames) / resampleRatio) + marginSize,
+				scratch.size());
+			playRaw(scratch.data(), inputFrames, state, loopMode);
 
-	const auto resampleResult
-		= state->resampler().resample(&playBuffer[0][0], playBuffer.size(), &dst[0][0], numFrames, resampleRatio);
-	advance(state, resampleResult.inputFramesUsed, loopMode);
+			const auto resampleResult = state->resampler().resample(&scratch[0][0], inputFrames,
+				&dst[outputFrames][0], numFrames - outputFrames, resampleRatio);
+			advance(state, resampleResult.inputFramesUsed, loopMode);
 
-	const auto outputFrames = static_cast<f_cnt_t>(resampleResult.outputFramesGenerated);
-	if (outputFrames < numFrames) { std::fill_n(dst + outputFrames, numFrames - outputFrames, SampleFrame{}); }
+			if (resampleResult.outputFramesGenerated == 0 && resampleResult.inputFramesUsed == 0) { break; }
+			outputFrames += resampleResult.outputFramesGenerated;
+		}
+
+		if (outputFrames < numFrames) { std::fill_n(dst + outputFrames, numFrames - outputFrames, SampleFrame{}); }
+	}
 
 	if (!approximatelyEqual(m_amplification, 1.0f))
 	{
@@ -174,7 +203,11 @@ void Sample::setAllPointFrames(int startFrame, int endFrame, int loopStartFrame,
 
 void Sample::playRaw(SampleFrame* dst, size_t numFrames, const PlaybackState* state, Loop loopMode) const
 {
-	if (m_buffer->size() < 1) { return; }
+	if (m_buffer->size() < 1)
+	{
+		std::fill_n(dst, numFrames, SampleFrame{});
+		return;
+	}
 
 	auto index = state->m_frameIndex;
 	auto backwards = state->m_backwards;
@@ -184,7 +217,11 @@ void Sample::playRaw(SampleFrame* dst, size_t numFrames, const PlaybackState* st
 		switch (loopMode)
 		{
 		case Loop::Off:
-			if (index < 0 || index >= m_endFrame) { return; }
+			if (index < 0 || index >= m_endFrame)
+			{
+				std::fill_n(dst + i, numFrames - i, SampleFrame{});
+				return;
+			}
 			break;
 		case Loop::On:
 			if (index < m_loopStartFrame && backwards) { index = m_loopEndFrame - 1; }
@@ -0,0 +1,106 @@
+/*
+ * SampleCache.cpp - shares decoded audio files between samples
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleCache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <mutex>
+
+#include "PathUtil.h"
+#include "SampleBuffer.h"
+
+namespace lmms {
+
+namespace {
+
+struct Entry
+{
+	std::weak_ptr<const SampleBuffer> buffer;
+	QDateTime lastModified;
+	qint64 size = 0;
+};
+
+std::mutex s_mutex;
+QHash<QString, Entry> s_entries;
+
+void removeExpired()
+{
+	for (auto it = s_entries.begin(); it != s_entries.end();)
+	{
+		if (it->buffer.expired()) { it = s_entries.erase(it); }
+		else { ++it; }
+	}
+}
+
+} // namespace
+
+auto SampleCache::get(const QString& audioFile) -> std::shared_ptr<const SampleBuffer>
+{
+	const auto info = QFileInfo{PathUtil::toAbsolute(audioFile)};
+
+	// let SampleBuffer report empty paths and missing files
+	if (audioFile.isEmpty() || !info.isFile()) { return std::make_shared<const SampleBuffer>(audioFile); }
+
+	// symlinks are kept, so the path saved with a project is the one the user picked
+	const auto key = QDir::cleanPath(info.absoluteFilePath());
+
+	const auto lastModified = info.lastModified();
+	const auto size = info.size();
+
+	{
+		const auto lock = std::lock_guard{s_mutex};
+		const auto it = s_entries.constFind(key);
+		if (it != s_entries.constEnd() && it->lastModified == lastModified && it->size == size)
+		{
+			if (auto buffer = it->buffer.lock()) { return buffer; }
+		}
+	}
+
+	// decode without holding the lock, so loading one file doesn't block the others. The buffer is
+	// loaded from the key, so its audioFile() doesn't depend on how the first caller spelled the path.
+	auto buffer = std::make_shared<const SampleBuffer>(key);
+
+	const auto lock = std::lock_guard{s_mutex};
+	auto& entry = s_entries[key];
+	if (entry.lastModified == lastModified && entry.size == size)
+	{
+		// someone else decoded the same file in the meantime
+		if (auto existing = entry.buffer.lock()) { return existing; }
+	}
+	entry = Entry{buffer, lastModified, size};
+	removeExpired();
+	return buffer;
+}
+
+auto SampleCache::size() -> std::size_t
+{
+	const auto lock = std::lock_guard{s_mutex};
+	removeExpired();
+	return static_cast<std::size_t>(s_entries.size());
+}
+
+} // namespace lmms
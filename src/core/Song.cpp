@@ -33,6 +33,7 @@
 #include <cmath>
 
 #include "AutomationTrack.h"
+#include "BufferManager.h"
 #include "AutomationEditor.h"
 #include "ConfigManager.h"
 #include "ControllerRackView.h"
@@ -97,7 +98,9 @@ Song::Song() :
 	m_elapsedBars( 0 ),
 	m_loopRenderCount(1),
 	m_loopRenderRemaining(1),
-	m_oldAutomatedValues()
+	m_oldAutomatedValues(),
+	m_automationTimeline(this),
+	m_automationBlock(Engine::audioEngine()->framesPerPeriod())
 {
 	for (double& millisecondsElapsed : m_elapsedMilliSeconds) { millisecondsElapsed = 0; }
 	connect( &m_tempoModel, SIGNAL(dataChanged()),
@@ -340,6 +343,8 @@ void Song::processNextBuffer()
 			}
 		}
 
+		processAutomationBlock(frameOffsetInPeriod, framesToPlay);
+
 		// Update frame counters
 		frameOffsetInPeriod += framesToPlay;
 		frameOffsetInTick += framesToPlay;
@@ -360,6 +365,8 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 	TrackContainer* container = this;
 	int clipNum = -1;
 
+	m_sampleExactAutomation.clear();
+
 	switch (m_playMode)
 	{
 	case PlayMode::Song:
@@ -377,14 +384,21 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 		return;
 	}
 
-	values = container->automatedValuesAt(timeStart, clipNum);
-	const TrackList& tracks = container->tracks();
-
 	Track::clipVector clips;
-	for (Track* track : tracks)
+	if (m_playMode == PlayMode::Song)
+	{
+		values = m_automationTimeline.valuesAt(timeStart);
+		const auto& playing = m_automationTimeline.playingClips();
+		clips.assign(playing.begin(), playing.end());
+	}
+	else
 	{
-		if (track->type() == Track::Type::Automation) {
-			track->getClipsInRange(clips, 0, timeStart);
+		values = container->automatedValuesAt(timeStart, clipNum);
+		for (Track* track : container->tracks())
+		{
+			if (track->type() == Track::Type::Automation) {
+				track->getClipsInRange(clips, 0, timeStart);
+			}
 		}
 	}
 
@@ -426,6 +440,26 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 			it.key()->setUseControllerValue(true);
 		}
 	}
+
+	if (m_playMode == PlayMode::Song)
+	{
+		for (const auto& source : m_automationTimeline.sources())
+		{
+			if (!recordedModels.contains(source.first)) { m_sampleExactAutomation.push_back(source); }
+		}
+	}
+}
+
+void Song::processAutomationBlock(f_cnt_t offset, fpp_t frames)
+{
+	if (m_sampleExactAutomation.empty()) { return; }
+
+	const auto time = getPlayPos().getTicks() + getPlayPos().currentFrame() / Engine::framesPerTick();
+	for (const auto& [model, clip] : m_sampleExactAutomation)
+	{
+		clip->fillBlock(time - clip->startPosition().getTicks(), frames, m_automationBlock.data());
+		model->setAutomatedValueBlock(m_automationBlock.data(), offset, frames);
+	}
 }
 
 void Song::processMetronome(size_t bufferOffset)
@@ -700,6 +734,7 @@ void Song::stop()
 		am->setUseControllerValue(true);
 	}
 	m_oldAutomatedValues.clear();
+	m_sampleExactAutomation.clear();
 
 	m_playMode = PlayMode::None;
 
@@ -1184,6 +1219,9 @@ void Song::loadProject( const QString & fileName )
 	// resolve all IDs so that autoModels are automated
 	AutomationClip::resolveAllIDs();
 
+	// make sure note-on bursts don't have to grow the buffer pool
+	BufferManager::reserve((tracks().size() + Engine::patternStore()->tracks().size())
+		* BufferManager::BuffersPerTrack);
 
 	Engine::audioEngine()->doneChangeInModel();
 
@@ -29,10 +29,14 @@
 
 #include "Track.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <QDomElement>
 #include <QVariant>
 
 #include "AutomationClip.h"
+#include "AutomationTimeline.h"
 #include "AutomationTrack.h"
 #include "ConfigManager.h"
 #include "Engine.h"
@@ -63,10 +67,17 @@ Track::Track( Type type, TrackContainer * tc ) :
 	m_name(),                       /*!< The track's name */
 	m_mutedModel( false, this, tr( "Mute" ) ), /*!< For controlling track muting */
 	m_soloModel( false, this, tr( "Solo" ) ), /*!< For controlling track soloing */
-	m_clips()        /*!< The clips (segments) */
+	m_clips(),        /*!< The clips (segments) */
+	m_clipIndexCursor( 0 ),
+	m_clipIndexDirty( true )
 {	
 	m_trackContainer->addTrack( this );
 	m_height = -1;
+	// muting other tracks doesn't change the automation
+	if (type == Type::Automation || type == Type::HiddenAutomation || type == Type::Pattern)
+	{
+		connect(&m_mutedModel, &BoolModel::dataChanged, this, &AutomationTimeline::invalidate, Qt::DirectConnection);
+	}
 }
 
 
@@ -341,6 +352,8 @@ void Track::loadSettings(const QDomElement& element)
 Clip * Track::addClip( Clip * clip )
 {
 	m_clips.push_back( clip );
+	invalidateClipIndex();
+	AutomationTimeline::clipChanged(clip);
 
 	emit clipAdded( clip );
 
@@ -360,6 +373,8 @@ void Track::removeClip( Clip * clip )
 	if( it != m_clips.end() )
 	{
 		m_clips.erase( it );
+		invalidateClipIndex();
+		AutomationTimeline::clipRemoved(clip);
 		if( Engine::getSong() )
 		{
 			Engine::getSong()->updateLength();
@@ -456,18 +471,67 @@ int Track::getClipNum( const Clip * clip )
 void Track::getClipsInRange( clipVector & clipV, const TimePos & start,
 							const TimePos & end )
 {
-	for( Clip* clip : m_clips )
+	QMutexLocker m( &m_clipIndexMutex );
+	if( m_clipIndexDirty.exchange( false ) )
+	{
+		rebuildClipIndex();
+	}
+
+	const tick_t from = start.getTicks();
+	const tick_t to = end.getTicks();
+
+	// all clips before the first entry whose running maximum end reaches
+	// the start of the range are over already. During playback this entry
+	// only changes at clip boundaries, so try the one of the last query first
+	const auto isOver = []( const ClipIndexEntry& entry, tick_t pos ) { return entry.maxEnd < pos; };
+	auto first = m_clipIndex.begin() + std::min( m_clipIndexCursor, m_clipIndex.size() );
+	if( first != m_clipIndex.begin() && ( first - 1 )->maxEnd >= from )
+	{
+		first = std::lower_bound( m_clipIndex.begin(), first, from, isOver );
+	}
+	else if( first != m_clipIndex.end() && first->maxEnd < from )
 	{
-		int s = clip->startPosition();
-		int e = clip->endPosition();
-		if( ( s <= end ) && ( e >= start ) )
+		first = std::lower_bound( first, m_clipIndex.end(), from, isOver );
+	}
+	m_clipIndexCursor = first - m_clipIndex.begin();
+
+	// the clips found are sorted by position already, merge them with the
+	// ones the caller collected from other tracks
+	const auto collected = clipV.size();
+	for( auto it = first; it != m_clipIndex.end() && it->start <= to; ++it )
+	{
+		if( it->end >= from )
 		{
-			// Clip is within given range
-			// Insert sorted by Clip's position
-			clipV.insert(std::upper_bound(clipV.begin(), clipV.end(), clip, Clip::comparePosition),
-						clip);
+			clipV.push_back( it->clip );
 		}
 	}
+	if( collected > 0 )
+	{
+		std::inplace_merge( clipV.begin(), clipV.begin() + collected, clipV.end(), Clip::comparePosition );
+	}
+}
+
+
+
+
+void Track::rebuildClipIndex()
+{
+	m_clipIndex.clear();
+	m_clipIndex.reserve( m_clips.size() );
+	for( Clip* clip : m_clips )
+	{
+		m_clipIndex.push_back( { clip->startPosition().getTicks(), clip->endPosition().getTicks(), 0, clip } );
+	}
+	std::stable_sort( m_clipIndex.begin(), m_clipIndex.end(),
+		[]( const ClipIndexEntry& a, const ClipIndexEntry& b ) { return a.start < b.start; } );
+
+	tick_t maxEnd = std::numeric_limits<tick_t>::min();
+	for( ClipIndexEntry& entry : m_clipIndex )
+	{
+		maxEnd = std::max( maxEnd, entry.end );
+		entry.maxEnd = maxEnd;
+	}
+	m_clipIndexCursor = 0;
 }
 
 
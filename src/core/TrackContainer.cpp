@@ -30,6 +30,7 @@
 #include <QWriteLocker>
 
 #include "AutomationClip.h"
+#include "AutomationTimeline.h"
 #include "embed.h"
 #include "TrackContainer.h"
 #include "PatternClip.h"
@@ -182,6 +183,7 @@ void TrackContainer::addTrack( Track * _track )
 		m_tracksMutex.lockForWrite();
 		m_tracks.push_back( _track );
 		m_tracksMutex.unlock();
+		AutomationTimeline::invalidate();
 		_track->unlock();
 		emit trackAdded( _track );
 	}
@@ -205,6 +207,7 @@ void TrackContainer::removeTrack( Track * _track )
 		}
 		m_tracks.erase(it);
 		lockTracksAccess.unlock();
+		AutomationTimeline::invalidate();
 
 		if( Engine::getSong() )
 		{
@@ -0,0 +1,401 @@
+/*
+ * XrunForensics.cpp - keeps the timing of recent periods to explain xruns
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "XrunForensics.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+
+#include "LocklessPool.h"
+#include "ThreadableJob.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+constexpr std::size_t MaxThreads = 64;
+constexpr auto WriterInterval = std::chrono::milliseconds{100};
+// don't flood the log if every period misses its deadline
+constexpr auto MinCaptureDistance = std::chrono::seconds{1};
+
+//! The slowest jobs one thread processed in the current period, only written by that thread
+struct JobSlot
+{
+	std::uint64_t generation = 0;
+	std::array<XrunForensics::SlowJob, XrunForensics::SlowJobCount> jobs{};
+	//! whether a thread writes into this slot
+	std::atomic_bool claimed = false;
+};
+
+std::array<JobSlot, MaxThreads> s_jobSlots;
+std::atomic_size_t s_jobSlotsUsed = 0; // slots up to the highest one ever claimed
+// incremented at the end of every period, so slots from earlier periods are ignored
+std::atomic_uint64_t s_generation = 1;
+
+//! The slot of a worker thread, handed back when the thread exits
+struct JobSlotClaim
+{
+	~JobSlotClaim()
+	{
+		if( index < MaxThreads )
+		{
+			s_jobSlots[index].claimed.store( false, std::memory_order_release );
+		}
+	}
+
+	std::size_t index = MaxThreads + 1; // not claimed yet
+};
+
+thread_local JobSlotClaim t_jobSlot;
+
+//! Returns the slot of the calling thread, claiming a free one on first use
+JobSlot* threadJobSlot()
+{
+	if( t_jobSlot.index > MaxThreads )
+	{
+		t_jobSlot.index = MaxThreads;
+		for( std::size_t i = 0; i < MaxThreads; ++i )
+		{
+			bool claimed = false;
+			if( s_jobSlots[i].claimed.compare_exchange_strong( claimed, true, std::memory_order_acquire ) )
+			{
+				t_jobSlot.index = i;
+				auto used = s_jobSlotsUsed.load( std::memory_order_relaxed );
+				while( used <= i && !s_jobSlotsUsed.compare_exchange_weak( used, i + 1, std::memory_order_acq_rel ) )
+				{
+					// Empty loop (compare_exchange_weak updates used)
+				}
+				break;
+			}
+		}
+	}
+	return t_jobSlot.index < MaxThreads ? &s_jobSlots[t_jobSlot.index] : nullptr;
+}
+
+std::atomic_uint32_t s_lockWaits = 0;
+std::atomic<std::int64_t> s_lockWaitNs = 0;
+
+//! Inserts \p job into \p jobs, which is sorted slowest first, if it is slow enough
+void insertSlowJob( std::array<XrunForensics::SlowJob, XrunForensics::SlowJobCount>& jobs,
+	const XrunForensics::SlowJob& job )
+{
+	if( job.us <= jobs.back().us )
+	{
+		return;
+	}
+	auto pos = std::find_if( jobs.begin(), jobs.end(), [&job]( const auto& other ) { return other.us < job.us; } );
+	std::move_backward( pos, jobs.end() - 1, jobs.end() );
+	*pos = job;
+}
+
+QByteArray jsonString( const QString& text )
+{
+	QByteArray out = "\"";
+	for( const char c : text.toUtf8() )
+	{
+		if( c == '"' || c == '\\' )
+		{
+			out += '\\';
+			out += c;
+		}
+		else if( static_cast<unsigned char>( c ) < 0x20 )
+		{
+			out += ' ';
+		}
+		else
+		{
+			out += c;
+		}
+	}
+	return out + "\"";
+}
+
+} // namespace
+
+
+
+
+//! Hands captured records from the audio thread over to a thread writing them to the log
+class XrunForensics::Writer
+{
+public:
+	~Writer()
+	{
+		stop();
+	}
+
+	bool start( const QString& logFile )
+	{
+		stop();
+
+		m_file.setFileName( logFile );
+		if( !m_file.open( QFile::WriteOnly | QFile::Append ) )
+		{
+			return false;
+		}
+		m_quit = false;
+		m_thread = std::thread( [this] { run(); } );
+		m_enabled = true;
+		return true;
+	}
+
+	//! Copies the records, oldest first, unless the previous capture wasn't written yet
+	bool capture( const std::array<Period, HistorySize>& history, std::size_t oldest, int budgetUs )
+	{
+		if( !m_enabled.load( std::memory_order_relaxed ) || m_captureReady.load( std::memory_order_acquire ) )
+		{
+			return false;
+		}
+		for( std::size_t i = 0; i < HistorySize; ++i )
+		{
+			m_captured[i] = history[( oldest + i ) % HistorySize];
+		}
+		m_capturedBudgetUs = budgetUs;
+		m_captureReady.store( true, std::memory_order_release );
+		return true;
+	}
+
+private:
+	void stop()
+	{
+		m_enabled = false;
+		if( m_thread.joinable() )
+		{
+			{
+				const auto lock = std::lock_guard{ m_mutex };
+				m_quit = true;
+			}
+			m_wake.notify_one();
+			m_thread.join();
+		}
+		m_file.close();
+	}
+
+	void run()
+	{
+		auto lock = std::unique_lock{ m_mutex };
+		while( !m_quit )
+		{
+			m_wake.wait_for( lock, WriterInterval );
+			if( m_captureReady.load( std::memory_order_acquire ) )
+			{
+				write();
+				m_captureReady.store( false, std::memory_order_release );
+			}
+		}
+	}
+
+	void write()
+	{
+		// the last record is the period which missed its deadline
+		const Clock::time_point xrun = m_captured.back().begin;
+		const auto us = []( Clock::duration d ) {
+			return std::chrono::duration_cast<std::chrono::microseconds>( d ).count();
+		};
+
+		QByteArray line = "{\"time\":" + jsonString( QDateTime::currentDateTime().toString( Qt::ISODate ) )
+			+ ",\"budgetUs\":" + QByteArray::number( m_capturedBudgetUs ) + ",\"periods\":[";
+		bool first = true;
+		for( const Period& period : m_captured )
+		{
+			if( period.begin == Clock::time_point{} )
+			{
+				continue; // not rendered yet
+			}
+			line += first ? "{" : ",{";
+			first = false;
+			line += "\"beginUs\":" + QByteArray::number( static_cast<qlonglong>( us( period.begin - xrun ) ) )
+				+ ",\"elapsedUs\":" + QByteArray::number( period.elapsedUs )
+				+ ",\"stagesUs\":{\"noteSetup\":" + QByteArray::number( period.stageUs[0] )
+				+ ",\"instruments\":" + QByteArray::number( period.stageUs[1] )
+				+ ",\"effects\":" + QByteArray::number( period.stageUs[2] )
+				+ ",\"mixing\":" + QByteArray::number( period.stageUs[3] )
+				+ "},\"playHandles\":" + QByteArray::number( period.playHandles )
+				+ ",\"allocations\":" + QByteArray::number( period.allocations )
+				+ ",\"lockWaits\":" + QByteArray::number( period.lockWaits )
+				+ ",\"lockWaitUs\":" + QByteArray::number( period.lockWaitUs )
+				+ ",\"slowestJobs\":[";
+			for( std::size_t i = 0; i < SlowJobCount && period.slowestJobs[i].us > 0; ++i )
+			{
+				const SlowJob& job = period.slowestJobs[i];
+				line += i == 0 ? "{" : ",{";
+				line += "\"category\":\"" + QByteArray( AudioEngineTracer::categoryName( job.tag.category ) ) + "\"";
+				const QString label = AudioEngineTracer::label( job.tag.owner );
+				if( !label.isEmpty() )
+				{
+					line += ",\"name\":" + jsonString( label );
+				}
+				if( job.tag.name )
+				{
+					line += ",\"plugin\":" + jsonString( QString::fromUtf8( job.tag.name ) );
+				}
+				if( job.tag.channel >= 0 )
+				{
+					line += ",\"channel\":" + QByteArray::number( job.tag.channel );
+				}
+				line += ",\"us\":" + QByteArray::number( job.us ) + "}";
+			}
+			line += "]}";
+		}
+		line += "]}\n";
+
+		m_file.write( line );
+		m_file.flush();
+	}
+
+	QFile m_file;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_quit = false;
+
+	std::atomic_bool m_enabled = false;
+	std::atomic_bool m_captureReady = false;
+	std::array<Period, HistorySize> m_captured;
+	int m_capturedBudgetUs = 0;
+};
+
+
+
+
+std::atomic_bool XrunForensics::s_logging = false;
+
+
+
+
+XrunForensics::XrunForensics() :
+	m_allocations( LocklessPool::totalExhaustions() ),
+	m_writer( std::make_unique<Writer>() )
+{
+}
+
+
+
+
+XrunForensics::~XrunForensics()
+{
+	s_logging = false;
+}
+
+
+
+
+bool XrunForensics::setLogFile( const QString& logFile )
+{
+	const auto started = m_writer->start( logFile );
+	s_logging = started;
+	return started;
+}
+
+
+
+
+void XrunForensics::finishPeriod( Clock::time_point begin, int elapsedUs, int budgetUs,
+	const std::array<int, StageCount>& stageUs, std::size_t playHandles )
+{
+	Period& period = m_history[m_next];
+	m_next = ( m_next + 1 ) % HistorySize;
+
+	period.begin = begin;
+	period.elapsedUs = elapsedUs;
+	std::copy( stageUs.begin(), stageUs.end(), period.stageUs.begin() );
+	period.playHandles = static_cast<std::int32_t>( playHandles );
+
+	const auto allocations = LocklessPool::totalExhaustions();
+	period.allocations = static_cast<std::uint32_t>( allocations - m_allocations );
+	m_allocations = allocations;
+
+	period.lockWaits = s_lockWaits.exchange( 0, std::memory_order_relaxed );
+	period.lockWaitUs = static_cast<std::int32_t>( s_lockWaitNs.exchange( 0, std::memory_order_relaxed ) / 1000 );
+
+	// all jobs of the period are done, so their threads don't touch the slots now
+	const auto generation = s_generation.load( std::memory_order_relaxed );
+	period.slowestJobs = {};
+	const auto slots = s_jobSlotsUsed.load( std::memory_order_acquire );
+	for( std::size_t i = 0; i < slots; ++i )
+	{
+		if( s_jobSlots[i].generation != generation )
+		{
+			continue;
+		}
+		for( const SlowJob& job : s_jobSlots[i].jobs )
+		{
+			insertSlowJob( period.slowestJobs, job );
+		}
+	}
+	s_generation.fetch_add( 1, std::memory_order_release );
+
+	if( elapsedUs > budgetUs && begin - m_lastCapture >= MinCaptureDistance
+		&& m_writer->capture( m_history, m_next, budgetUs ) )
+	{
+		m_lastCapture = begin;
+	}
+}
+
+
+
+
+void XrunForensics::jobFinished( const ThreadableJob& job, Clock::duration time )
+{
+	JobSlot* const threadSlot = threadJobSlot();
+	if( threadSlot == nullptr )
+	{
+		return;
+	}
+
+	JobSlot& slot = *threadSlot;
+	const auto generation = s_generation.load( std::memory_order_acquire );
+	if( slot.generation != generation )
+	{
+		slot.jobs = {};
+		slot.generation = generation;
+	}
+
+	const auto us = static_cast<std::int32_t>( std::chrono::duration_cast<std::chrono::microseconds>( time ).count() );
+	if( us > slot.jobs.back().us )
+	{
+		insertSlowJob( slot.jobs, { job.traceTag(), us } );
+	}
+}
+
+
+
+
+void XrunForensics::lockWaited( Clock::duration time )
+{
+	s_lockWaits.fetch_add( 1, std::memory_order_relaxed );
+	s_lockWaitNs.fetch_add( std::chrono::duration_cast<std::chrono::nanoseconds>( time ).count(),
+		std::memory_order_relaxed );
+}
+
+} // namespace lmms
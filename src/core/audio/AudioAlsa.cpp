@@ -242,7 +242,7 @@ void AudioAlsa::stopProcessing()
 
 void AudioAlsa::run()
 {
-	auto temp = new SampleFrame[audioEngine()->framesPerPeriod()];
+	const SampleFrame* temp = nullptr;
 	auto outbuf = new int_sample_t[audioEngine()->framesPerPeriod() * channels()];
 	auto pcmbuf = new int_sample_t[m_periodSize * channels()];
 
@@ -260,7 +260,7 @@ void AudioAlsa::run()
 			if( outbuf_pos == 0 )
 			{
 				// frames depend on the sample rate
-				const fpp_t frames = getNextBuffer( temp );
+				const fpp_t frames = getNextBufferView( temp );
 				if( !frames )
 				{
 					quit = true;
@@ -307,7 +307,6 @@ void AudioAlsa::run()
 		}
 	}
 
-	delete[] temp;
 	delete[] outbuf;
 	delete[] pcmbuf;
 }
@@ -66,15 +66,19 @@ void AudioDevice::processNextBuffer()
 
 fpp_t AudioDevice::getNextBuffer(SampleFrame* _ab)
 {
-	fpp_t frames = audioEngine()->framesPerPeriod();
-	const SampleFrame* b = audioEngine()->nextBuffer();
+	const SampleFrame* b = nullptr;
+	const fpp_t frames = getNextBufferView(b);
+	if (frames) { memcpy(_ab, b, frames * sizeof(SampleFrame)); }
+	return frames;
+}
 
-	if (!b) { return 0; }
 
-	memcpy(_ab, b, frames * sizeof(SampleFrame));
 
-	if (audioEngine()->hasFifoWriter()) { delete[] b; }
-	return frames;
+
+fpp_t AudioDevice::getNextBufferView(const SampleFrame*& _ab)
+{
+	_ab = audioEngine()->nextBuffer();
+	return _ab ? audioEngine()->framesPerPeriod() : 0;
 }
 
 
@@ -56,15 +56,21 @@ AudioJack::AudioJack(bool& successful, AudioEngine* audioEngineParam)
 	, m_active(false)
 	, m_midiClient(nullptr)
 	, m_tempOutBufs(new jack_default_audio_sample_t*[channels()])
-	, m_outBuf(new SampleFrame[audioEngine()->framesPerPeriod()])
+	, m_outBuf(nullptr)
 	, m_framesDoneInCurBuf(0)
 	, m_framesToDoInCurBuf(0)
+	, m_reportedLatency(0)
 {
 	m_stopped = true;
 
 	successful = initJackClient();
 	if (successful) {
 		connect(this, SIGNAL(zombified()), this, SLOT(restartAfterZombified()), Qt::QueuedConnection);
+
+		// the latency changes on the audio thread, where JACK must not be asked to recompute it
+		constexpr auto LatencyCheckIntervalMs = 250;
+		connect(&m_latencyTimer, &QTimer::timeout, this, &AudioJack::updateLatency);
+		m_latencyTimer.start(LatencyCheckIntervalMs);
 	}
 }
 
@@ -89,7 +95,6 @@ AudioJack::~AudioJack()
 
 	delete[] m_tempOutBufs;
 
-	delete[] m_outBuf;
 }
 
 
@@ -160,6 +165,9 @@ bool AudioJack::initJackClient()
 	// set shutdown-callback
 	jack_on_shutdown(m_client, shutdownCallback, this);
 
+	// report the latency of our effects to JACK
+	jack_set_latency_callback(m_client, staticLatencyCallback, this);
+
 	if (jack_get_sample_rate(m_client) != sampleRate()) { setSampleRate(jack_get_sample_rate(m_client)); }
 
 	for (ch_cnt_t ch = 0; ch < channels(); ++ch)
@@ -337,7 +345,7 @@ int AudioJack::processCallback(jack_nframes_t nframes)
 		m_framesDoneInCurBuf += todo;
 		if (m_framesDoneInCurBuf == m_framesToDoInCurBuf)
 		{
-			m_framesToDoInCurBuf = getNextBuffer(m_outBuf);
+			m_framesToDoInCurBuf = getNextBufferView(m_outBuf);
 			m_framesDoneInCurBuf = 0;
 			if (!m_framesToDoInCurBuf)
 			{
@@ -370,6 +378,45 @@ int AudioJack::staticProcessCallback(jack_nframes_t nframes, void* udata)
 
 
 
+void AudioJack::latencyCallback(jack_latency_callback_mode_t mode)
+{
+	// we have no inputs, so the only latency we add is the one of our
+	// processing, seen by the clients capturing our output
+	if (mode != JackCaptureLatency) { return; }
+
+	const auto latency = static_cast<jack_nframes_t>(audioEngine()->processingLatency());
+	jack_latency_range_t range = {latency, latency};
+	for (jack_port_t* port : m_outputPorts)
+	{
+		jack_port_set_latency_range(port, JackCaptureLatency, &range);
+	}
+}
+
+
+
+
+void AudioJack::updateLatency()
+{
+	// JACK only asks for our latency when its graph changes, so tell it when our effects
+	// or the pipelined mode changed it
+	const auto latency = audioEngine()->processingLatency();
+	if (!m_active || m_client == nullptr || latency == m_reportedLatency) { return; }
+
+	m_reportedLatency = latency;
+	jack_recompute_total_latencies(m_client);
+}
+
+
+
+
+void AudioJack::staticLatencyCallback(jack_latency_callback_mode_t mode, void* udata)
+{
+	static_cast<AudioJack*>(udata)->latencyCallback(mode);
+}
+
+
+
+
 void AudioJack::shutdownCallback(void* udata)
 {
 	auto thisClass = static_cast<AudioJack*>(udata);
@@ -23,6 +23,9 @@
  */
 
 #include "AudioPort.h"
+
+#include <algorithm>
+
 #include "AudioDevice.h"
 #include "AudioEngine.h"
 #include "EffectChain.h"
@@ -30,6 +33,7 @@
 #include "Engine.h"
 #include "MixHelpers.h"
 #include "BufferManager.h"
+#include "PeriodRing.h"
 
 namespace lmms
 {
@@ -45,8 +49,10 @@ AudioPort::AudioPort( const QString & _name, bool _has_effect_chain,
 	m_effects( _has_effect_chain ? new EffectChain( nullptr ) : nullptr ),
 	m_volumeModel( volumeModel ),
 	m_panningModel( panningModel ),
-	m_mutedModel( mutedModel )
+	m_mutedModel( mutedModel ),
+	m_stemTap( nullptr )
 {
+	AudioEngineTracer::setLabel( this, _name );
 	Engine::audioEngine()->addAudioPort( this );
 	setExtOutputEnabled( true );
 }
@@ -59,6 +65,7 @@ AudioPort::~AudioPort()
 	setExtOutputEnabled( false );
 	Engine::audioEngine()->removeAudioPort( this );
 	BufferManager::release( m_portBuffer );
+	AudioEngineTracer::removeLabel( this );
 }
 
 
@@ -86,6 +93,7 @@ void AudioPort::setExtOutputEnabled( bool _enabled )
 void AudioPort::setName( const QString & _name )
 {
 	m_name = _name;
+	AudioEngineTracer::setLabel( this, _name );
 	Engine::audioEngine()->audioDev()->renamePort( this );
 }
 
@@ -103,18 +111,42 @@ bool AudioPort::processEffects()
 }
 
 
+
+
+f_cnt_t AudioPort::latency() const
+{
+	return m_effects ? m_effects->latency() : 0;
+}
+
+
 void AudioPort::doProcessing()
 {
+	// in pipelined mode this is the period before the one of the instruments
+	const AutomatableModel::PreviousPeriodScope previousPeriod;
+
 	if( m_mutedModel && m_mutedModel->value() )
 	{
+		// drop the output of our play handles so they can be removed once done
+		XrunForensics::lock( m_playHandleLock );
+		for (PlayHandle* ph : m_playHandles)
+		{
+			ph->releaseBuffer();
+		}
+		m_playHandleLock.unlock();
+		if( m_compensation.hasPendingOutput() )
+		{
+			m_compensation.clear();
+		}
+		writeStemTap( true );
+		Engine::audioEngine()->audioPortProcessed();
 		return;
 	}
 
 	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
 
-	// clear the buffer
-	zeroSampleFrames(m_portBuffer, fpp);
-
+	// in pipelined mode, play handles (e.g. sub-notes of arpeggios) can be
+	// added by instruments while we're mixing
+	XrunForensics::lock( m_playHandleLock );
 	//qDebug( "Playhandles: %d", m_playHandles.size() );
 	for( PlayHandle * ph : m_playHandles ) // now we mix all playhandle buffers into the audioport buffer
 	{
@@ -124,116 +156,96 @@ void AudioPort::doProcessing()
 				&& ( ph->type() == PlayHandle::Type::NotePlayHandle
 					|| !MixHelpers::isSilent( ph->buffer(), fpp ) ) )
 			{
-				m_bufferUsage = true;
-				MixHelpers::add( m_portBuffer, ph->buffer(), fpp );
+				// the first buffer is copied, which saves clearing the port buffer beforehand
+				if( m_bufferUsage )
+				{
+					MixHelpers::add( m_portBuffer, ph->buffer(), fpp );
+				}
+				else
+				{
+					std::copy_n( ph->buffer(), fpp, m_portBuffer );
+					m_bufferUsage = true;
+				}
 			}
 			ph->releaseBuffer(); 	// gets rid of playhandle's buffer and sets
 									// pointer to null, so if it doesn't get re-acquired we know to skip it next time
 		}
 	}
+	m_playHandleLock.unlock();
 
 	if( m_bufferUsage )
 	{
-		// handle volume and panning
-		// has both vol and pan models
-		if( m_volumeModel && m_panningModel )
+		// handle volume and panning, either of which may be sample exact
+		if( m_volumeModel )
 		{
-			ValueBuffer * volBuf = m_volumeModel->valueBuffer();
-			ValueBuffer * panBuf = m_panningModel->valueBuffer();
-
-			// both vol and pan have s.ex.data:
-			if( volBuf && panBuf )
-			{
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					float v = volBuf->values()[ f ] * 0.01f;
-					float p = panBuf->values()[ f ] * 0.01f;
-					m_portBuffer[f][0] *= ( p <= 0 ? 1.0f : 1.0f - p ) * v;
-					m_portBuffer[f][1] *= ( p >= 0 ? 1.0f : 1.0f + p ) * v;
-				}
-			}
-
-			// only vol has s.ex.data:
-			else if( volBuf )
-			{
-				float p = m_panningModel->value() * 0.01f;
-				float l = ( p <= 0 ? 1.0f : 1.0f - p );
-				float r = ( p >= 0 ? 1.0f : 1.0f + p );
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					float v = volBuf->values()[ f ] * 0.01f;
-					m_portBuffer[f][0] *= v * l;
-					m_portBuffer[f][1] *= v * r;
-				}
-			}
-
-			// only pan has s.ex.data:
-			else if( panBuf )
-			{
-				float v = m_volumeModel->value() * 0.01f;
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					float p = panBuf->values()[ f ] * 0.01f;
-					m_portBuffer[f][0] *= ( p <= 0 ? 1.0f : 1.0f - p ) * v;
-					m_portBuffer[f][1] *= ( p >= 0 ? 1.0f : 1.0f + p ) * v;
-				}
-			}
-
-			// neither has s.ex.data:
-			else
-			{
-				float p = m_panningModel->value() * 0.01f;
-				float v = m_volumeModel->value() * 0.01f;
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					m_portBuffer[f][0] *= ( p <= 0 ? 1.0f : 1.0f - p ) * v;
-					m_portBuffer[f][1] *= ( p >= 0 ? 1.0f : 1.0f + p ) * v;
-				}
-			}
-		}
-
-		// has vol model only
-		else if( m_volumeModel )
-		{
-			ValueBuffer * volBuf = m_volumeModel->valueBuffer();
-
-			if( volBuf )
-			{
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					float v = volBuf->values()[ f ] * 0.01f;
-					m_portBuffer[f][0] *= v;
-					m_portBuffer[f][1] *= v;
-				}
-			}
-			else
-			{
-				float v = m_volumeModel->value() * 0.01f;
-				for( f_cnt_t f = 0; f < fpp; ++f )
-				{
-					m_portBuffer[f][0] *= v;
-					m_portBuffer[f][1] *= v;
-				}
-			}
+			MixHelpers::multiplyByVolumeAndPanning( m_portBuffer,
+				m_volumeModel->value(), m_volumeModel->valueBuffer(),
+				m_panningModel ? m_panningModel->value() : 0.0f,
+				m_panningModel ? m_panningModel->valueBuffer() : nullptr, fpp );
 		}
 	}
+	else if( m_effects && m_effects->isRunning() )
+	{
+		// the effects still need a clean buffer to render their tails into,
+		// otherwise the buffer isn't used at all this period
+		zeroSampleFrames(m_portBuffer, fpp);
+	}
 	// as of now there's no situation where we only have panning model but no volume model
 	// if we have neither, we don't have to do anything here - just pass the audio as is
 
 	// handle effects
 	const bool me = processEffects();
+	bool silent = false;
 	if( me || m_bufferUsage )
 	{
+		m_compensation.process( m_portBuffer, m_portBuffer, fpp );
 		Engine::mixer()->mixToChannel( m_portBuffer, m_nextMixerChannel ); 	// send output to mixer
 																			// TODO: improve the flow here - convert to pull model
 		m_bufferUsage = false;
 	}
+	else if( m_compensation.hasPendingOutput() )
+	{
+		// still owe the mixer the end of the delayed signal
+		m_compensation.drain( m_portBuffer, fpp );
+		Engine::mixer()->mixToChannel( m_portBuffer, m_nextMixerChannel );
+	}
+	else
+	{
+		// nothing reaches the mixer, so don't feed the channel or export garbage
+		silent = true;
+	}
+
+	writeStemTap( silent );
+	Engine::audioEngine()->audioPortProcessed();
+}
+
+
+
+
+void AudioPort::writeStemTap( bool silent )
+{
+	if( m_stemTap == nullptr )
+	{
+		return;
+	}
+
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+	SampleFrame* period = m_stemTap->beginWrite();
+	if( silent )
+	{
+		zeroSampleFrames( period, fpp );
+	}
+	else
+	{
+		std::copy( m_portBuffer, m_portBuffer + fpp, period );
+	}
+	m_stemTap->endWrite();
 }
 
 
 void AudioPort::addPlayHandle( PlayHandle * handle )
 {
-	m_playHandleLock.lock();
+	XrunForensics::lock( m_playHandleLock );
 		m_playHandles.append( handle );
 	m_playHandleLock.unlock();
 }
@@ -241,7 +253,7 @@ void AudioPort::addPlayHandle( PlayHandle * handle )
 
 void AudioPort::removePlayHandle( PlayHandle * handle )
 {
-	m_playHandleLock.lock();
+	XrunForensics::lock( m_playHandleLock );
 		PlayHandleList::Iterator it =	std::find( m_playHandles.begin(), m_playHandles.end(), handle );
 		if( it != m_playHandles.end() )
 		{
@@ -44,7 +44,7 @@ constexpr auto InputDeviceSDL = "inputdevice";
 
 AudioSdl::AudioSdl( bool & _success_ful, AudioEngine*  _audioEngine ) :
 	AudioDevice( DEFAULT_CHANNELS, _audioEngine ),
-	m_outBuf(new SampleFrame[audioEngine()->framesPerPeriod()])
+	m_outBuf(nullptr)
 {
 	_success_ful = false;
 
@@ -131,7 +131,6 @@ AudioSdl::~AudioSdl()
 
 	SDL_Quit();
 
-	delete[] m_outBuf;
 }
 
 
@@ -189,7 +188,7 @@ void AudioSdl::sdlAudioCallback( Uint8 * _buf, int _len )
 		if( m_currentBufferFramePos == 0 )
 		{
 			// frames depend on the sample rate
-			const fpp_t frames = getNextBuffer( m_outBuf );
+			const fpp_t frames = getNextBufferView( m_outBuf );
 			if( !frames )
 			{
 				memset( _buf, 0, _len );
@@ -213,6 +213,16 @@ bool Lv2ControlBase::hasNoteInput() const
 
 
 
+f_cnt_t Lv2ControlBase::latency() const
+{
+	f_cnt_t frames = 0;
+	for (const auto& c : m_procs) { frames = std::max(frames, c->latency()); }
+	return frames;
+}
+
+
+
+
 void Lv2ControlBase::handleMidiInputEvent(const MidiEvent &event,
 	const TimePos &time, f_cnt_t offset)
 {
@@ -130,6 +130,8 @@ std::vector<PluginIssue> Meta::get(const LilvPlugin *plugin,
 		issue(PluginIssueType::UnknownPortFlow, portName);
 	}
 
+	m_reportsLatency = m_flow == Flow::Output && hasProperty(LV2_CORE__reportsLatency);
+
 	m_def = .0f;
 	m_min = std::numeric_limits<decltype(m_min)>::lowest();
 	m_max = std::numeric_limits<decltype(m_max)>::max();
@@ -497,6 +497,14 @@ bool Lv2Proc::hasNoteInput() const
 
 
 
+f_cnt_t Lv2Proc::latency() const
+{
+	return m_latencyPort ? static_cast<f_cnt_t>(std::max(m_latencyPort->m_val, 0.f)) : 0;
+}
+
+
+
+
 void Lv2Proc::initMOptions()
 {
 	/*
@@ -651,6 +659,10 @@ void Lv2Proc::createPort(std::size_t portNum)
 				}
 
 			} // if m_flow == Input
+			else if (meta.m_reportsLatency)
+			{
+				m_latencyPort = ctrl;
+			}
 			port = ctrl;
 			break;
 		}
@@ -177,6 +177,8 @@ void printHelp()
 		"  -c, --config <configfile>      Get the configuration from <configfile>\n"
 		"  -h, --help                     Show this usage information and exit.\n"
 		"  -v, --version                  Show version information and exit.\n"
+		"      --xrun-log <file>          Whenever the audio engine misses a deadline,\n"
+		"          append the timing of the last periods to <file> (JSON lines)\n"
 		"\nOptions if no action is given:\n"
 		"      --geometry <geometry>      Specify the size and position of\n"
 		"          the main window\n"
@@ -207,11 +209,21 @@ void printHelp()
 		"          For \"rendertracks\", provide a directory path\n"
 		"          If not specified, render will overwrite the input file\n"
 		"          For \"rendertracks\", this might be required\n"
-		"  -p, --profile <out>            Dump profiling information to file <out>\n"
+		"  -p, --profile <out>            Record a performance trace of the audio engine\n"
+		"          to <out> (Chrome trace JSON, can be opened in Perfetto)\n"
+		"  --parallel <jobs>              For \"render\", split the song at silent\n"
+		"          gaps and render up to <jobs> segments in parallel (experimental)\n"
+		"  --range <begin>:<end>          Only render the ticks from <begin> to <end>\n"
 		"  -s, --samplerate <samplerate>  Specify output samplerate in Hz\n"
 		"          Range: 44100 (default) to 192000\n"
 		"          Possible values: 1, 2, 4, 8\n"
-		"          Default: 2\n\n",
+		"          Default: 2\n"
+		"  --stems                        For \"rendertracks\", render the song only\n"
+		"          once and write the output of each track\n"
+		"  --mixerstems                   Like --stems, but also write the output\n"
+		"          of each mixer channel\n"
+		"  --verify                       With --parallel, also render sequentially\n"
+		"          and report the difference\n\n",
 		LMMS_VERSION, LMMS_PROJECT_COPYRIGHT );
 }
 
@@ -258,8 +270,14 @@ int main( int argc, char * * argv )
 	bool exitAfterImport = false;
 	bool allowRoot = false;
 	bool renderLoop = false;
+	bool renderStems = false;
+	bool renderMixerStems = false;
+	int renderJobs = 1;
+	bool renderVerify = false;
+	tick_t renderRangeBegin = 0;
+	tick_t renderRangeEnd = 0;
 	bool renderTracks = false;
-	QString fileToLoad, fileToImport, renderOut, profilerOutputFile, configFile;
+	QString fileToLoad, fileToImport, renderOut, profilerOutputFile, xrunLogFile, configFile;
 
 	// first of two command-line parsing stages
 	for (int i = 1; i < argc; ++i)
@@ -491,6 +509,56 @@ int main( int argc, char * * argv )
 		{
 			renderLoop = true;
 		}
+		else if( arg == "--stems" )
+		{
+			renderStems = true;
+		}
+		else if( arg == "--mixerstems" )
+		{
+			renderStems = true;
+			renderMixerStems = true;
+		}
+		else if( arg == "--parallel" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No number of jobs specified" );
+			}
+
+			renderJobs = QString( argv[i] ).toInt();
+			if( renderJobs < 1 )
+			{
+				return usageError( QString( "Invalid number of jobs %1" ).arg( argv[i] ) );
+			}
+		}
+		else if( arg == "--verify" )
+		{
+			renderVerify = true;
+		}
+		else if( arg == "--range" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No range specified" );
+			}
+
+			const QStringList range = QString( argv[i] ).split( ':' );
+			bool beginOk = false;
+			bool endOk = false;
+			if( range.size() == 2 )
+			{
+				renderRangeBegin = range[0].toInt( &beginOk );
+				renderRangeEnd = range[1].toInt( &endOk );
+			}
+			if( !beginOk || !endOk || renderRangeBegin < 0 || renderRangeEnd <= renderRangeBegin )
+			{
+				return usageError( QString( "Invalid range %1" ).arg( argv[i] ) );
+			}
+		}
 		else if( arg == "--output" || arg == "-o" )
 		{
 			++i;
@@ -678,6 +746,17 @@ int main( int argc, char * * argv )
 
 			profilerOutputFile = QString::fromLocal8Bit( argv[i] );
 		}
+		else if( arg == "--xrun-log" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No xrun log specified" );
+			}
+
+			xrunLogFile = QString::fromLocal8Bit( argv[i] );
+		}
 		else if( arg == "--config" || arg == "-c" )
 		{
 			++i;
@@ -767,6 +846,13 @@ int main( int argc, char * * argv )
 
 		Engine::getSong()->setExportLoop( renderLoop );
 
+		if( renderRangeEnd > renderRangeBegin )
+		{
+			Engine::getSong()->getTimeline(Song::PlayMode::Song).setLoopPoints(
+				TimePos( renderRangeBegin ), TimePos( renderRangeEnd ) );
+			Engine::getSong()->setRenderBetweenMarkers( true );
+		}
+
 		// when rendering multiple tracks, renderOut is a directory
 		// otherwise, it is a file, so we need to append the file extension
 		if ( !renderTracks )
@@ -786,16 +872,30 @@ int main( int argc, char * * argv )
 				SLOT(updateConsoleProgress()));
 		t->start( 200 );
 
-		if( profilerOutputFile.isEmpty() == false )
+		if( profilerOutputFile.isEmpty() == false
+			&& !Engine::audioEngine()->profiler().setOutputFile( profilerOutputFile ) )
+		{
+			printf( "Could not write profile to %s\n", qPrintable( profilerOutputFile ) );
+		}
+		if( xrunLogFile.isEmpty() == false
+			&& !Engine::audioEngine()->profiler().setXrunLogFile( xrunLogFile ) )
 		{
-			Engine::audioEngine()->profiler().setOutputFile( profilerOutputFile );
+			printf( "Could not write xrun log to %s\n", qPrintable( xrunLogFile ) );
 		}
 
 		// start now!
-		if ( renderTracks )
+		if ( renderTracks && renderStems )
+		{
+			r->renderStems( renderMixerStems );
+		}
+		else if ( renderTracks )
 		{
 			r->renderTracks();
 		}
+		else if ( renderJobs > 1 && !renderLoop )
+		{
+			r->renderProjectParallel( renderJobs, renderVerify );
+		}
 		else
 		{
 			r->renderProject();
@@ -807,6 +907,17 @@ int main( int argc, char * * argv )
 
 		new GuiApplication();
 
+		if( profilerOutputFile.isEmpty() == false
+			&& !Engine::audioEngine()->profiler().setOutputFile( profilerOutputFile ) )
+		{
+			printf( "Could not write profile to %s\n", qPrintable( profilerOutputFile ) );
+		}
+		if( xrunLogFile.isEmpty() == false
+			&& !Engine::audioEngine()->profiler().setXrunLogFile( xrunLogFile ) )
+		{
+			printf( "Could not write xrun log to %s\n", qPrintable( xrunLogFile ) );
+		}
+
 		// re-intialize RNG - shared libraries might have srand() or
 		// srandom() calls in their init procedure
 		srand( getpid() + time( 0 ) );
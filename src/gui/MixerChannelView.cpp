@@ -31,6 +31,7 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QPainter>
+#include <QToolTip>
 #include <cassert>
 
 #include "CaptionMenu.h"
@@ -241,6 +242,22 @@ bool MixerChannelView::eventFilter(QObject*, QEvent* event)
 	return false;
 }
 
+bool MixerChannelView::event(QEvent* event)
+{
+	// append how much of the DSP time the channel currently uses to the tooltip
+	if (event->type() == QEvent::ToolTip && !m_inRename)
+	{
+		const auto helpEvent = static_cast<QHelpEvent*>(event);
+		const auto& cpuTime = Engine::mixer()->mixerChannel(m_channelIndex)->m_cpuTime;
+		const auto load = tr("DSP: %1% (peak %2%)")
+			.arg(cpuTime.load(), 0, 'f', 1)
+			.arg(cpuTime.peakLoad(), 0, 'f', 1);
+		QToolTip::showText(helpEvent->globalPos(), toolTip().isEmpty() ? load : toolTip() + "\n" + load, this);
+		return true;
+	}
+	return QWidget::event(event);
+}
+
 void MixerChannelView::setChannelIndex(int index)
 {
 	MixerChannel* mixerChannel = Engine::mixer()->mixerChannel(index);
@@ -896,6 +896,7 @@ void AutomationEditor::mouseMoveEvent(QMouseEvent * mouseEvent )
 					{
 						it.value().setInTangent(newTangent);
 					}
+					m_clip->updateSnapshot();
 				}
 				else if (m_mouseDownRight && m_action == Action::ResetTangents)
 				{
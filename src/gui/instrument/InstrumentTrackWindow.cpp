@@ -118,6 +118,12 @@ InstrumentTrackWindow::InstrumentTrackWindow( InstrumentTrackView * _itv ) :
 	// m_leftRightNav->setShortcuts();
 	nameAndChangeTrackLayout->addWidget(m_leftRightNav);
 
+	// how much of the DSP time the instrument currently uses
+	m_cpuLoadLabel = new QLabel(this);
+	m_cpuLoadLabel->setStyleSheet("font-size: 10px;");
+	nameAndChangeTrackLayout->addWidget(m_cpuLoadLabel);
+	connect(getGUI()->mainWindow(), &MainWindow::periodicUpdate, this, &InstrumentTrackWindow::updateCpuLoad);
+
 	nameAndChangeTrackWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
 	generalSettingsLayout->addWidget( nameAndChangeTrackWidget );
 
@@ -467,6 +473,21 @@ void InstrumentTrackWindow::updateName()
 
 
 
+void InstrumentTrackWindow::updateCpuLoad()
+{
+	const auto instrument = m_track ? m_track->instrument() : nullptr;
+	if (!isVisible() || !instrument) { return; }
+
+	const auto& cpuTime = instrument->cpuTime();
+	const auto text = tr("DSP: %1% (peak %2%)")
+		.arg(cpuTime.load(), 0, 'f', 1)
+		.arg(cpuTime.peakLoad(), 0, 'f', 1);
+	if (m_cpuLoadLabel->text() != text) { m_cpuLoadLabel->setText(text); }
+}
+
+
+
+
 void InstrumentTrackWindow::updateInstrumentView()
 {
 	delete m_instrumentView;
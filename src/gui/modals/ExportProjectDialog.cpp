@@ -100,6 +100,9 @@ ExportProjectDialog::ExportProjectDialog( const QString & _file_name,
 
 	connect( startButton, SIGNAL(clicked()),
 			this, SLOT(startBtnClicked()));
+
+	// stems are only an option when exporting tracks
+	exportStemsCB->setVisible( m_multiExport );
 }
 
 
@@ -196,7 +199,12 @@ void ExportProjectDialog::startExport()
 	connect( m_renderManager.get(), SIGNAL(finished()),
 			getGUI()->mainWindow(), SLOT(resetWindowTitle()));
 
-	if ( m_multiExport )
+	if ( m_multiExport && exportStemsCB->isChecked() )
+	{
+		// render the song once, writing all tracks at the same time
+		m_renderManager->renderStems();
+	}
+	else if ( m_multiExport )
 	{
 		m_renderManager->renderTracks();
 	}
@@ -144,6 +144,8 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 			"app", "nanhandler", "1").toInt()),
 	m_bufferSize(ConfigManager::inst()->value(
 			"audioengine", "framesperaudiobuffer").toInt()),
+	m_pipelined(ConfigManager::inst()->value(
+			"audioengine", "pipelined").toInt()),
 	m_midiAutoQuantize(ConfigManager::inst()->value(
 			"midi", "autoquantize", "0").toInt() != 0),
 	m_workingDir(QDir::toNativeSeparators(ConfigManager::inst()->workingDir())),
@@ -595,6 +597,11 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 
 	setBufferSize(m_bufferSizeSlider->value());
 
+	auto pipelinedCheckBox = addCheckBox(tr("Render instruments while the previous period is mixed"), bufferSizeBox,
+		bufferSizeLayout, m_pipelined, SLOT(togglePipelined(bool)), false);
+	pipelinedCheckBox->setToolTip(tr("Uses more CPU cores at the cost of one buffer of additional latency. "
+		"Exports always render this way."));
+
 
 	// Audio layout ordering.
 	audio_layout->addWidget(audioInterfaceBox);
@@ -965,6 +972,13 @@ void SetupDialog::accept()
 					QString::number(m_NaNHandler));
 	ConfigManager::inst()->setValue("audioengine", "framesperaudiobuffer",
 					QString::number(m_bufferSize));
+	ConfigManager::inst()->setValue("audioengine", "pipelined",
+					QString::number(m_pipelined));
+	// unlike the buffer size, this can change while running
+	if (Engine::audioEngine()->isPipelined() != m_pipelined)
+	{
+		Engine::audioEngine()->setPipelined(m_pipelined);
+	}
 	ConfigManager::inst()->setValue("audioengine", "mididev",
 					m_midiIfaceNames[m_midiInterfaces->currentText()]);
 	ConfigManager::inst()->setValue("midi", "midiautoassign",
@@ -1165,6 +1179,12 @@ void SetupDialog::toggleDisableAutoQuit(bool enabled)
 	m_disableAutoQuit = enabled;
 }
 
+
+void SetupDialog::togglePipelined(bool enabled)
+{
+	m_pipelined = enabled;
+}
+
 void SetupDialog::audioInterfaceChanged(const QString & iface)
 {
 	for(AswMap::iterator it = m_audioIfaceSetupWidgets.begin();
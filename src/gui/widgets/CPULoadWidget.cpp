@@ -25,12 +25,17 @@
 
 
 #include <algorithm>
+#include <QCursor>
+#include <QMessageBox>
 #include <QPainter>
 
 #include "AudioEngine.h"
+#include "AudioEngineTracer.h"
+#include "CaptionMenu.h"
 #include "CPULoadWidget.h"
 #include "embed.h"
 #include "Engine.h"
+#include "FileDialog.h"
 
 
 namespace lmms::gui
@@ -89,6 +94,32 @@ void CPULoadWidget::paintEvent( QPaintEvent *  )
 
 
 
+void CPULoadWidget::contextMenuEvent( QContextMenuEvent * )
+{
+	CaptionMenu contextMenu( tr( "DSP load" ) );
+	if( AudioEngineTracer::isEnabled() )
+	{
+		contextMenu.addAction( tr( "Stop performance trace" ), [] { AudioEngineTracer::stop(); } );
+	}
+	else
+	{
+		contextMenu.addAction( tr( "Record performance trace..." ), this, [this]
+		{
+			const QString fileName = FileDialog::getSaveFileName( this, tr( "Save performance trace" ), "",
+				tr( "Chrome trace (*.json)" ) );
+			if( !fileName.isEmpty() && !Engine::audioEngine()->profiler().setOutputFile( fileName ) )
+			{
+				QMessageBox::warning( this, tr( "Performance trace" ),
+					tr( "Could not write to %1." ).arg( fileName ) );
+			}
+		} );
+	}
+	contextMenu.exec( QCursor::pos() );
+}
+
+
+
+
 void CPULoadWidget::updateCpuLoad()
 {
 	// Additional display smoothing for the main load-value. Stronger averaging
@@ -99,13 +130,24 @@ void CPULoadWidget::updateCpuLoad()
 	if (new_load != m_currentLoad)
 	{
 		auto engine = Engine::audioEngine();
-		setToolTip(
+		QString toolTip =
 			tr("DSP total: %1%").arg(new_load) + "\n"
 			+ tr(" - Notes and setup: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::NoteSetup)) + "\n"
 			+ tr(" - Instruments: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Instruments)) + "\n"
 			+ tr(" - Effects: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Effects)) + "\n"
-			+ tr(" - Mixing: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Mixing))
-		);
+			+ tr(" - Mixing: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Mixing));
+
+		const auto pluginLoads = AudioEngineProfiler::pluginLoads();
+		if (!pluginLoads.empty())
+		{
+			toolTip += "\n" + tr("Heaviest plugins:");
+			for (std::size_t i = 0; i < std::min<std::size_t>(pluginLoads.size(), 3); ++i)
+			{
+				toolTip += "\n" + tr(" - %1: %2% (peak %3%)").arg(pluginLoads[i].name,
+					QString::number(pluginLoads[i].load, 'f', 1), QString::number(pluginLoads[i].peakLoad, 'f', 1));
+			}
+		}
+		setToolTip(toolTip);
 		m_currentLoad = new_load;
 		m_changed = true;
 		update();
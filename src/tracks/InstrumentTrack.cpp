@@ -581,7 +581,10 @@ void InstrumentTrack::playNote( NotePlayHandle* n, SampleFrame* workingBuffer )
 	if( n->isMasterNote() == false && m_instrument != nullptr )
 	{
 		// all is done, so now lets play the note!
-		m_instrument->playNote( n, workingBuffer );
+		{
+			CpuTimeCounter::Scope cpuTime( m_instrument->cpuTime() );
+			m_instrument->playNote( n, workingBuffer );
+		}
 
 		// This is effectively the same as checking if workingBuffer is not a nullptr.
 		// Calling processAudioBuffer with a nullptr leads to crashes. Hence the check.
@@ -753,25 +756,11 @@ bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 			cur_start -= c->startPosition();
 		}
 
-		// get all notes from the given clip...
-		const NoteVector & notes = c->notes();
-		// ...and set our index to zero
-		auto nit = notes.begin();
-
-		// very effective algorithm for playing notes that are
-		// posated within the current sample-frame
-
-
-		if( cur_start > 0 )
-		{
-			// skip notes which are posated before start-bar
-			while( nit != notes.end() && ( *nit )->pos() < cur_start )
-			{
-				++nit;
-			}
-		}
+		// get the notes starting right now, the clip remembers where it
+		// left off so this doesn't rescan the notes before cur_start
+		const auto [notesBegin, notesEnd] = c->notesStartingAt( cur_start );
 
-		while (nit != notes.end() && (*nit)->pos() == cur_start)
+		for (auto nit = notesBegin; nit != notesEnd; ++nit)
 		{
 			const auto currentNote = *nit;
 
@@ -793,7 +782,6 @@ bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 
 			Engine::audioEngine()->addPlayHandle( notePlayHandle );
 			played_a_note = true;
-			++nit;
 		}
 	}
 	unlock();
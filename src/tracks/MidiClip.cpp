@@ -43,7 +43,8 @@ MidiClip::MidiClip( InstrumentTrack * _instrument_track ) :
 	Clip( _instrument_track ),
 	m_instrumentTrack( _instrument_track ),
 	m_clipType( Type::BeatClip ),
-	m_steps( TimePos::stepsPerBar() )
+	m_steps( TimePos::stepsPerBar() ),
+	m_playCursor( 0 )
 {
 	if (_instrument_track->trackContainer()	== Engine::patternStore())
 	{
@@ -60,7 +61,8 @@ MidiClip::MidiClip( const MidiClip& other ) :
 	Clip( other.m_instrumentTrack ),
 	m_instrumentTrack( other.m_instrumentTrack ),
 	m_clipType( other.m_clipType ),
-	m_steps( other.m_steps )
+	m_steps( other.m_steps ),
+	m_playCursor( 0 )
 {
 	for (const auto& note : other.m_notes)
 	{
@@ -259,6 +261,35 @@ Note * MidiClip::noteAtStep(int step)
 
 
 
+std::pair<NoteVector::const_iterator, NoteVector::const_iterator> MidiClip::notesStartingAt( const TimePos& time )
+{
+	const auto startsBefore = []( const Note* note, const TimePos& pos ) { return note->pos() < pos; };
+
+	// the cursor still points to the first note not before time, unless
+	// playback jumped or notes were edited since the last call
+	auto first = m_notes.cbegin() + std::min( m_playCursor, m_notes.size() );
+	if( first != m_notes.cbegin() && ( *( first - 1 ) )->pos() >= time )
+	{
+		first = std::lower_bound( m_notes.cbegin(), first, time, startsBefore );
+	}
+	else if( first != m_notes.cend() && ( *first )->pos() < time )
+	{
+		first = std::lower_bound( first, m_notes.cend(), time, startsBefore );
+	}
+
+	auto last = first;
+	while( last != m_notes.cend() && ( *last )->pos() == time )
+	{
+		++last;
+	}
+	m_playCursor = last - m_notes.cbegin();
+
+	return { first, last };
+}
+
+
+
+
 void MidiClip::rearrangeAllNotes()
 {
 	// sort notes by start time
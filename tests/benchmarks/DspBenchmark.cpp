@@ -0,0 +1,299 @@
+/*
+ * DspBenchmark.cpp - throughput of the per-voice DSP primitives
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QByteArray>
+#include <QCoreApplication>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <numbers>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "AutomatableModel.h"
+#include "BasicFilters.h"
+#include "Engine.h"
+#include "EnvelopeAndLfoParameters.h"
+#include "Oscillator.h"
+#include "Sample.h"
+#include "SampleBuffer.h"
+#include "SampleFrame.h"
+
+using namespace lmms;
+
+namespace
+{
+
+constexpr auto MinDuration = std::chrono::milliseconds{50};
+
+const char* const WaveShapeNames[] = {
+	"Sine", "Triangle", "Saw", "Square", "MoogSaw", "Exponential", "WhiteNoise", "UserDefined"
+};
+static_assert(std::size(WaveShapeNames) == Oscillator::NumWaveShapes);
+
+const char* const ModulationAlgoNames[] = {
+	"PhaseModulation", "AmplitudeModulation", "SignalMix", "SynchronizedBySubOsc", "FrequencyModulation"
+};
+static_assert(std::size(ModulationAlgoNames) == Oscillator::NumModulationAlgos);
+
+const char* const FilterTypeNames[] = {
+	"LowPass", "HiPass", "BandPass_CSG", "BandPass_CZPG", "Notch", "AllPass", "Moog", "DoubleLowPass",
+	"Lowpass_RC12", "Bandpass_RC12", "Highpass_RC12", "Lowpass_RC24", "Bandpass_RC24", "Highpass_RC24",
+	"Formantfilter", "DoubleMoog", "Lowpass_SV", "Bandpass_SV", "Highpass_SV", "Notch_SV", "FastFormant",
+	"Tripole"
+};
+static_assert(std::size(FilterTypeNames) == static_cast<std::size_t>(BasicFilters<>::FilterType::Tripole) + 1);
+
+const struct
+{
+	const char* name;
+	int mode;
+} InterpolationModes[] = {
+	{ "ZeroOrderHold", SRC_ZERO_ORDER_HOLD },
+	{ "Linear", SRC_LINEAR },
+	{ "SincFastest", SRC_SINC_FASTEST },
+	{ "SincMedium", SRC_SINC_MEDIUM_QUALITY },
+	{ "SincBest", SRC_SINC_BEST_QUALITY },
+};
+
+const char* onlyPrimitive = nullptr;
+
+//! Runs the given period-sized job for at least MinDuration and returns the throughput in million frames per second
+template<typename Job>
+double measure(int frames, Job&& job)
+{
+	using clock = std::chrono::steady_clock;
+	long long iterations = 0;
+	const auto start = clock::now();
+	auto elapsed = clock::duration{};
+	do
+	{
+		for (int i = 0; i < 64; ++i)
+		{
+			job();
+		}
+		iterations += 64;
+		elapsed = clock::now() - start;
+	} while (elapsed < MinDuration);
+
+	const auto seconds = std::chrono::duration<double>(elapsed).count();
+	return static_cast<double>(iterations) * frames / seconds / 1e6;
+}
+
+template<typename Prepare>
+void run(const char* primitive, const char* variant, Prepare&& prepare)
+{
+	if (onlyPrimitive && std::strcmp(onlyPrimitive, primitive) != 0) { return; }
+
+	for (int frames = 32; frames <= 4096; frames *= 2)
+	{
+		std::printf("%s,%s,%d,%.2f\n", primitive, variant, frames, measure(frames, prepare(frames)));
+		std::fflush(stdout);
+	}
+}
+
+//! A second of a detuned saw chord, so playback has something to interpolate
+std::vector<SampleFrame> makeSignal(int sampleRate)
+{
+	auto signal = std::vector<SampleFrame>(sampleRate);
+	for (auto i = std::size_t{0}; i < signal.size(); ++i)
+	{
+		const auto t = static_cast<float>(i) / sampleRate;
+		const auto left = t * 220.f - std::floor(t * 220.f);
+		const auto right = t * 331.f - std::floor(t * 331.f);
+		signal[i] = SampleFrame{left - 0.5f, right - 0.5f};
+	}
+	return signal;
+}
+
+void benchmarkOscillators()
+{
+	const auto sampleRate = Engine::audioEngine()->outputSampleRate();
+
+	// one cycle of a sine for the user defined shape
+	auto userCycle = std::vector<SampleFrame>(256);
+	for (auto i = std::size_t{0}; i < userCycle.size(); ++i)
+	{
+		const auto value = std::sin(2 * std::numbers::pi_v<float> * i / userCycle.size());
+		userCycle[i] = SampleFrame{value, value};
+	}
+	const auto userWave = std::make_shared<const SampleBuffer>(std::move(userCycle), sampleRate);
+	const std::shared_ptr<const OscillatorConstants::waveform_t> userTable =
+		Oscillator::generateAntiAliasUserWaveTable(userWave.get());
+
+	// values the oscillators keep references to, set up like TripleOscillator does
+	const float frequency = 440.f;
+	const float subFrequency = 220.f;
+	const float detuning = 1.f / sampleRate;
+	const float phaseOffset = 0.f;
+	const float volume = 0.5f;
+
+	constexpr auto LastShape = static_cast<int>(Oscillator::NumWaveShapes) - 1;
+	constexpr auto LastAlgo = static_cast<int>(Oscillator::NumModulationAlgos) - 1;
+	const auto subShape = IntModel{static_cast<int>(Oscillator::WaveShape::Sine), 0, LastShape};
+	const auto subAlgo = IntModel{0, 0, LastAlgo};
+
+	for (auto shape = std::size_t{0}; shape < Oscillator::NumWaveShapes; ++shape)
+	{
+		const auto shapeModel = IntModel{static_cast<int>(shape), 0, LastShape};
+
+		// modulated by a sine sub oscillator with each algorithm, then alone like the last one of a chain
+		for (auto algo = std::size_t{0}; algo <= Oscillator::NumModulationAlgos; ++algo)
+		{
+			const auto algoModel = IntModel{static_cast<int>(algo % Oscillator::NumModulationAlgos), 0, LastAlgo};
+			const auto variant = QByteArray{WaveShapeNames[shape]} + '/'
+				+ (algo == Oscillator::NumModulationAlgos ? "None" : ModulationAlgoNames[algo]);
+
+			run("Oscillator::update", variant.constData(), [&](int frames) {
+				auto sub = algo == Oscillator::NumModulationAlgos
+					? nullptr
+					: new Oscillator(&subShape, &subAlgo, subFrequency, detuning, phaseOffset, volume);
+				auto osc = std::make_shared<Oscillator>(&shapeModel, &algoModel, frequency, detuning, phaseOffset,
+					volume, sub);
+				osc->setUseWaveTable(true);
+				osc->setUserWave(userWave);
+				osc->setUserAntiAliasWaveTable(userTable);
+
+				auto buffer = std::make_shared<std::vector<SampleFrame>>(frames);
+				return [osc, buffer, frames] {
+					osc->update(buffer->data(), frames, 0);
+					osc->update(buffer->data(), frames, 1);
+				};
+			});
+		}
+	}
+}
+
+void benchmarkFilters()
+{
+	const auto sampleRate = Engine::audioEngine()->outputSampleRate();
+	const auto signal = makeSignal(sampleRate);
+
+	for (auto type = std::size_t{0}; type < std::size(FilterTypeNames); ++type)
+	{
+		// a fixed cutoff, and one swept every frame like an envelope on the cutoff does in InstrumentSoundShaping
+		for (const bool modulated : { false, true })
+		{
+			const auto variant = QByteArray{FilterTypeNames[type]} + (modulated ? "/modulated" : "");
+
+			run("BasicFilters::update", variant.constData(), [&](int frames) {
+				auto filter = std::make_shared<BasicFilters<>>(sampleRate);
+				filter->setFilterType(static_cast<BasicFilters<>::FilterType>(type));
+				filter->calcFilterCoeffs(2000.f, 0.5f);
+
+				auto buffer = std::make_shared<std::vector<SampleFrame>>(signal.begin(), signal.begin() + frames);
+				return [filter, buffer, frames, modulated] {
+					for (int f = 0; f < frames; ++f)
+					{
+						if (modulated) { filter->calcFilterCoeffs(1000.f + f % 64 * 100.f, 0.5f); }
+						auto& frame = (*buffer)[f];
+						frame[0] = filter->update(frame[0], 0);
+						frame[1] = filter->update(frame[1], 1);
+					}
+				};
+			});
+		}
+	}
+}
+
+void benchmarkSamples()
+{
+	const auto sampleRate = Engine::audioEngine()->outputSampleRate();
+	const auto sample = std::make_shared<Sample>(std::make_shared<const SampleBuffer>(makeSignal(sampleRate),
+		sampleRate));
+
+	// playing at the original pitch only copies the frames, without resampling
+	run("Sample::play", "Raw", [&](int frames) {
+		auto state = std::make_shared<Sample::PlaybackState>();
+		auto buffer = std::make_shared<std::vector<SampleFrame>>(frames);
+		return [sample, state, buffer, frames] {
+			sample->play(buffer->data(), state.get(), frames, DefaultBaseFreq, Sample::Loop::On);
+		};
+	});
+
+	// a fifth up, so every mode has to interpolate
+	for (const auto& interpolation : InterpolationModes)
+	{
+		run("Sample::play", interpolation.name, [&](int frames) {
+			auto state = std::make_shared<Sample::PlaybackState>(false, interpolation.mode);
+			auto buffer = std::make_shared<std::vector<SampleFrame>>(frames);
+			return [sample, state, buffer, frames] {
+				sample->play(buffer->data(), state.get(), frames, DefaultBaseFreq * 1.5f, Sample::Loop::On);
+			};
+		});
+	}
+}
+
+void benchmarkEnvelopes()
+{
+	for (const bool lfo : { false, true })
+	{
+		run("EnvelopeAndLfoParameters::fillLevel", lfo ? "Envelope+LFO" : "Envelope", [&](int frames) {
+			auto parameters = std::make_shared<EnvelopeAndLfoParameters>(0.f, nullptr);
+			parameters->getAmountModel().setValue(1.f);
+			parameters->getLfoAmountModel().setValue(lfo ? 1.f : 0.f);
+
+			// walk through attack, hold, decay, sustain and release of a note over and over
+			const auto releaseBegin = parameters->PAHD_Frames() + frames;
+			const auto noteFrames = releaseBegin + parameters->releaseFrames();
+			auto frame = std::make_shared<f_cnt_t>(0);
+			auto buffer = std::make_shared<std::vector<float>>(frames);
+			return [parameters, frame, buffer, frames, releaseBegin, noteFrames] {
+				parameters->fillLevel(buffer->data(), *frame, releaseBegin, frames);
+				*frame = *frame + frames < noteFrames ? *frame + frames : 0;
+			};
+		});
+	}
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	if (argc > 2 || (argc == 2 && argv[1][0] == '-'))
+	{
+		std::fprintf(stderr, "Usage: %s [primitive]\n", argv[0]);
+		return 1;
+	}
+	onlyPrimitive = argc == 2 ? argv[1] : nullptr;
+
+	Engine::init(true);
+
+	std::printf("# sample rate: %d\n", static_cast<int>(Engine::audioEngine()->outputSampleRate()));
+	std::printf("primitive,variant,frames,mframes_per_s\n");
+
+	benchmarkOscillators();
+	benchmarkFilters();
+	benchmarkSamples();
+	benchmarkEnvelopes();
+
+	Engine::destroy();
+	return 0;
+}
@@ -0,0 +1,437 @@
+/*
+ * EngineBenchmark.cpp - renders synthetic projects and reports how fast the engine is
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <numbers>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "AutomationClip.h"
+#include "AutomationTrack.h"
+#include "Effect.h"
+#include "Engine.h"
+#include "Instrument.h"
+#include "InstrumentTrack.h"
+#include "LocklessPool.h"
+#include "MidiClip.h"
+#include "Mixer.h"
+#include "ProjectRenderer.h"
+#include "Song.h"
+#include "lmmsversion.h"
+
+using namespace lmms;
+
+namespace
+{
+
+std::atomic_size_t s_allocations = 0;
+
+} // namespace
+
+// count every heap allocation made while rendering, by any thread
+void* operator new(std::size_t size)
+{
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size == 0 ? 1 : size)) { return ptr; }
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+	return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+
+//! What a synthetic project consists of
+struct Scenario
+{
+	const char* name;
+	int voices; //!< TripleOscillator notes playing at the same time
+	int samples; //!< AudioFileProcessor tracks, each playing a sample on every beat
+	int effectChains; //!< Mixer channels with a chain of effects, the tracks are spread over them
+	int sendDepth; //!< Mixer channels each sending to the next one before reaching the master
+	int automatedTracks; //!< Tracks whose volume and panning are automated throughout the song
+};
+
+const Scenario Scenarios[] = {
+	{ "oscillators", 64, 0, 0, 0, 0 },
+	{ "samples", 0, 32, 0, 0, 0 },
+	{ "effects", 16, 0, 16, 0, 0 },
+	{ "sends", 16, 0, 0, 32, 0 },
+	{ "automation", 16, 8, 0, 0, 24 },
+	{ "full", 64, 32, 16, 32, 48 },
+};
+
+constexpr int VoicesPerTrack = 8;
+constexpr int EffectsPerChain = 4;
+const char* const EffectNames[EffectsPerChain] = { "amplifier", "bassbooster", "delay", "reverbsc" };
+// distance between automation points, in ticks
+constexpr int AutomationStep = 12;
+
+//! Writes half a second of a decaying tone as 16 bit stereo WAV file
+bool writeSample(const QString& fileName, sample_rate_t sampleRate)
+{
+	QFile file(fileName);
+	if (!file.open(QFile::WriteOnly)) { return false; }
+
+	const auto frames = static_cast<quint32>(sampleRate / 2);
+	const quint32 dataSize = frames * 2 * sizeof(qint16);
+
+	QDataStream out(&file);
+	out.setByteOrder(QDataStream::LittleEndian);
+	out.writeRawData("RIFF", 4);
+	out << quint32(36 + dataSize);
+	out.writeRawData("WAVEfmt ", 8);
+	out << quint32(16) << quint16(1) << quint16(2) << quint32(sampleRate)
+		<< quint32(sampleRate * 2 * sizeof(qint16)) << quint16(2 * sizeof(qint16)) << quint16(16);
+	out.writeRawData("data", 4);
+	out << dataSize;
+	for (quint32 i = 0; i < frames; ++i)
+	{
+		const double t = static_cast<double>(i) / sampleRate;
+		const auto value = static_cast<qint16>(20000 * std::exp(-6 * t) * std::sin(2 * std::numbers::pi * 220 * t));
+		out << value << value;
+	}
+	return out.status() == QDataStream::Ok;
+}
+
+InstrumentTrack* addInstrumentTrack(Song* song, const char* plugin)
+{
+	auto track = dynamic_cast<InstrumentTrack*>(Track::create(Track::Type::Instrument, song));
+	const Instrument* instrument = track->loadInstrument(plugin);
+	if (!instrument || qstrcmp(instrument->descriptor()->name, plugin) != 0)
+	{
+		std::fprintf(stderr, "warning: instrument %s is not available, set LMMS_PLUGIN_DIR\n", plugin);
+	}
+	return track;
+}
+
+//! Fills \p track with chords of \p voices notes, one per beat
+void addChords(InstrumentTrack* track, int voices, int bars)
+{
+	auto clip = dynamic_cast<MidiClip*>(track->createClip(TimePos{0}));
+	const int ticksPerBeat = TimePos::ticksPerBar() / 4;
+	for (int beat = 0; beat < bars * 4; ++beat)
+	{
+		for (int voice = 0; voice < voices; ++voice)
+		{
+			clip->addNote(Note{TimePos{ticksPerBeat - 1}, TimePos{beat * ticksPerBeat}, 48 + 3 * voice}, false);
+		}
+	}
+}
+
+void addAutomation(Song* song, InstrumentTrack* track, int bars)
+{
+	auto automationTrack = Track::create(Track::Type::Automation, song);
+	for (FloatModel* model : { track->volumeModel(), track->panningModel() })
+	{
+		auto clip = dynamic_cast<AutomationClip*>(automationTrack->createClip(TimePos{0}));
+		clip->setProgressionType(AutomationClip::ProgressionType::Linear);
+		clip->addObject(model);
+		for (int tick = 0; tick <= bars * TimePos::ticksPerBar(); tick += AutomationStep)
+		{
+			const float phase = static_cast<float>(tick) / TimePos::ticksPerBar();
+			clip->putValue(TimePos{tick}, model->minValue()
+				+ (model->maxValue() - model->minValue()) * (0.5f + 0.25f * std::sin(phase)), false);
+		}
+	}
+}
+
+void buildProject(const Scenario& scenario, int bars, const QString& sampleFile)
+{
+	Song* song = Engine::getSong();
+	Mixer* mixer = Engine::mixer();
+	song->clearProject();
+
+	std::vector<InstrumentTrack*> tracks;
+	for (int voices = scenario.voices; voices > 0; voices -= VoicesPerTrack)
+	{
+		auto track = addInstrumentTrack(song, "tripleoscillator");
+		addChords(track, std::min(voices, VoicesPerTrack), bars);
+		tracks.push_back(track);
+	}
+	for (int i = 0; i < scenario.samples; ++i)
+	{
+		auto track = addInstrumentTrack(song, "audiofileprocessor");
+		track->instrument()->loadFile(sampleFile);
+		addChords(track, 1, bars);
+		tracks.push_back(track);
+	}
+
+	// a chain of channels sending into each other, the last one into the master
+	int sendHead = 0;
+	for (int i = 0; i < scenario.sendDepth; ++i)
+	{
+		const int channel = mixer->createChannel();
+		if (sendHead != 0)
+		{
+			mixer->deleteChannelSend(channel, 0);
+			mixer->createChannelSend(channel, sendHead);
+		}
+		sendHead = channel;
+	}
+
+	std::vector<int> effectChannels;
+	for (int i = 0; i < scenario.effectChains; ++i)
+	{
+		const int channel = mixer->createChannel();
+		if (sendHead != 0)
+		{
+			mixer->deleteChannelSend(channel, 0);
+			mixer->createChannelSend(channel, sendHead);
+		}
+		EffectChain& chain = mixer->mixerChannel(channel)->m_fxChain;
+		for (const char* name : EffectNames)
+		{
+			Effect* effect = Effect::instantiate(name, &chain, nullptr);
+			if (qstrcmp(effect->descriptor()->name, name) != 0)
+			{
+				std::fprintf(stderr, "warning: effect %s is not available, set LMMS_PLUGIN_DIR\n", name);
+			}
+			chain.appendEffect(effect);
+		}
+		effectChannels.push_back(channel);
+	}
+
+	for (std::size_t i = 0; i < tracks.size(); ++i)
+	{
+		if (!effectChannels.empty())
+		{
+			tracks[i]->mixerChannelModel()->setValue(effectChannels[i % effectChannels.size()]);
+		}
+		else
+		{
+			tracks[i]->mixerChannelModel()->setValue(sendHead);
+		}
+		if (static_cast<int>(i) < scenario.automatedTracks)
+		{
+			addAutomation(song, tracks[i], bars);
+		}
+	}
+
+	song->updateLength();
+}
+
+struct Result
+{
+	double wallSeconds;
+	double audioSeconds;
+	std::array<double, AudioEngineProfiler::DetailCount> stageMs;
+	std::size_t allocations;
+	std::size_t poolExhaustions;
+};
+
+Result render(const AudioEngine::qualitySettings& qualitySettings, const OutputSettings& outputSettings,
+	bool pipelined)
+{
+	AudioEngine* engine = Engine::audioEngine();
+	engine->storeAudioDevice();
+
+	// without stems, the renderer discards the output instead of encoding it
+	ProjectRenderer renderer(qualitySettings, outputSettings, ProjectRenderer::ExportFileFormat::Wave,
+		std::vector<ProjectRenderer::Stem>{});
+	renderer.setPipelined(pipelined);
+	engine->profiler().resetTotals();
+	const auto exhaustions = LocklessPool::totalExhaustions();
+	s_allocations = 0;
+	const auto begin = std::chrono::steady_clock::now();
+
+	renderer.startProcessing();
+	renderer.wait();
+
+	Result result;
+	result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	result.allocations = s_allocations.load();
+	result.poolExhaustions = LocklessPool::totalExhaustions() - exhaustions;
+	result.audioSeconds = static_cast<double>(engine->profiler().periodCount()) * engine->framesPerPeriod()
+		/ engine->outputSampleRate();
+	for (std::size_t i = 0; i < AudioEngineProfiler::DetailCount; ++i)
+	{
+		result.stageMs[i] = engine->profiler().detailTotal(static_cast<AudioEngineProfiler::DetailType>(i)) / 1000.0;
+	}
+
+	engine->restoreAudioDevice();
+	return result;
+}
+
+int usage()
+{
+	std::fprintf(stderr,
+		"Usage: lmms-bench [options...]\n"
+		"  --scenario <name>   Only run the given scenario (default: all)\n"
+		"  --bars <bars>       Length of the projects (default: 16)\n"
+		"  --voices <n>        Override the number of TripleOscillator voices\n"
+		"  --samples <n>       Override the number of AudioFileProcessor tracks\n"
+		"  --effects <n>       Override the number of effect chains\n"
+		"  --sends <n>         Override the depth of the mixer send chain\n"
+		"  --automation <n>    Override the number of automated tracks\n"
+		"  --mode <mode>       Render in serial or pipelined mode (default: serial)\n"
+		"  --output <file>     Write the JSON report to <file> instead of stdout\n"
+		"Scenarios:");
+	for (const Scenario& scenario : Scenarios)
+	{
+		std::fprintf(stderr, " %s", scenario.name);
+	}
+	std::fprintf(stderr, "\n");
+	return EXIT_FAILURE;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	// find the plugins of the build tree unless told otherwise
+	if (!qEnvironmentVariableIsSet("LMMS_PLUGIN_DIR"))
+	{
+		qputenv("LMMS_PLUGIN_DIR", LMMS_BENCH_PLUGIN_DIR);
+	}
+
+	const char* onlyScenario = nullptr;
+	int bars = 16;
+	int overrides[5] = { -1, -1, -1, -1, -1 };
+	const char* const overrideNames[5] = { "--voices", "--samples", "--effects", "--sends", "--automation" };
+	QString outputFile;
+	bool pipelined = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const QByteArray arg = argv[i];
+		if (i + 1 == argc) { return usage(); }
+		const char* value = argv[++i];
+
+		if (arg == "--scenario") { onlyScenario = value; }
+		else if (arg == "--bars") { bars = std::max(1, std::atoi(value)); }
+		else if (arg == "--mode")
+		{
+			if (qstrcmp(value, "serial") != 0 && qstrcmp(value, "pipelined") != 0) { return usage(); }
+			pipelined = qstrcmp(value, "pipelined") == 0;
+		}
+		else if (arg == "--output") { outputFile = QString::fromLocal8Bit(value); }
+		else
+		{
+			const auto name = std::find_if(std::begin(overrideNames), std::end(overrideNames),
+				[&arg](const char* name) { return arg == name; });
+			if (name == std::end(overrideNames)) { return usage(); }
+			overrides[name - std::begin(overrideNames)] = std::max(0, std::atoi(value));
+		}
+	}
+
+	Engine::init(true);
+
+	QTemporaryDir tempDir;
+	const QString sampleFile = tempDir.filePath("sample.wav");
+	if (!tempDir.isValid() || !writeSample(sampleFile, Engine::audioEngine()->outputSampleRate()))
+	{
+		std::fprintf(stderr, "Could not write the sample for AudioFileProcessor\n");
+		return EXIT_FAILURE;
+	}
+
+	const auto qualitySettings = AudioEngine::qualitySettings{AudioEngine::qualitySettings::Interpolation::Linear};
+	const auto outputSettings = OutputSettings{Engine::audioEngine()->outputSampleRate(),
+		OutputSettings::BitRateSettings{160, false}, OutputSettings::BitDepth::Depth16Bit};
+
+	QByteArray report = "{\"lmmsVersion\":\"" LMMS_VERSION "\""
+		",\"sampleRate\":" + QByteArray::number(Engine::audioEngine()->outputSampleRate())
+		+ ",\"framesPerPeriod\":" + QByteArray::number(Engine::audioEngine()->framesPerPeriod())
+		+ ",\"bars\":" + QByteArray::number(bars)
+		+ ",\"mode\":\"" + (pipelined ? "pipelined" : "serial") + "\""
+		+ ",\"results\":[";
+
+	bool first = true;
+	for (Scenario scenario : Scenarios)
+	{
+		if (onlyScenario && qstrcmp(onlyScenario, scenario.name) != 0) { continue; }
+
+		int* sizes[5] = { &scenario.voices, &scenario.samples, &scenario.effectChains,
+			&scenario.sendDepth, &scenario.automatedTracks };
+		for (int i = 0; i < 5; ++i)
+		{
+			if (overrides[i] >= 0) { *sizes[i] = overrides[i]; }
+		}
+
+		std::fprintf(stderr, "Rendering %s...\n", scenario.name);
+		buildProject(scenario, bars, sampleFile);
+		const Result result = render(qualitySettings, outputSettings, pipelined);
+
+		report += first ? "\n{" : ",\n{";
+		first = false;
+		report += "\"scenario\":\"" + QByteArray(scenario.name) + "\""
+			+ ",\"voices\":" + QByteArray::number(scenario.voices)
+			+ ",\"samples\":" + QByteArray::number(scenario.samples)
+			+ ",\"effectChains\":" + QByteArray::number(scenario.effectChains)
+			+ ",\"sendDepth\":" + QByteArray::number(scenario.sendDepth)
+			+ ",\"automatedTracks\":" + QByteArray::number(scenario.automatedTracks)
+			+ ",\"audioSeconds\":" + QByteArray::number(result.audioSeconds, 'f', 3)
+			+ ",\"wallSeconds\":" + QByteArray::number(result.wallSeconds, 'f', 3)
+			+ ",\"realtimeFactor\":" + QByteArray::number(result.audioSeconds / result.wallSeconds, 'f', 2)
+			+ ",\"stagesMs\":{\"noteSetup\":" + QByteArray::number(result.stageMs[0], 'f', 1)
+			+ ",\"instruments\":" + QByteArray::number(result.stageMs[1], 'f', 1)
+			+ ",\"effects\":" + QByteArray::number(result.stageMs[2], 'f', 1)
+			+ ",\"mixing\":" + QByteArray::number(result.stageMs[3], 'f', 1)
+			+ "},\"allocations\":" + QByteArray::number(static_cast<qulonglong>(result.allocations))
+			+ ",\"poolExhaustions\":" + QByteArray::number(static_cast<qulonglong>(result.poolExhaustions))
+			+ "}";
+	}
+	report += "\n]}\n";
+
+	Engine::getSong()->clearProject();
+	Engine::destroy();
+
+	if (outputFile.isEmpty())
+	{
+		std::fputs(report.constData(), stdout);
+	}
+	else
+	{
+		QFile file(outputFile);
+		if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(report) != report.size())
+		{
+			std::fprintf(stderr, "Could not write %s\n", qPrintable(outputFile));
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
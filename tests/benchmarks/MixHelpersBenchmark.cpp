@@ -0,0 +1,172 @@
+/*
+ * MixHelpersBenchmark.cpp - throughput of the MixHelpers kernels
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "MixHelpers.h"
+#include "SampleFrame.h"
+#include "ValueBuffer.h"
+
+using namespace lmms;
+
+namespace
+{
+
+struct Kernel
+{
+	const char* name;
+	//! Bytes read and written per frame
+	int bytesPerFrame;
+	std::function<void(SampleFrame*, const SampleFrame*, ValueBuffer*, ValueBuffer*, int)> run;
+};
+
+constexpr auto FrameSize = static_cast<int>(sizeof(SampleFrame));
+constexpr auto MinDuration = std::chrono::milliseconds{50};
+
+const Kernel Kernels[] = {
+	{ "add", 3 * FrameSize, [](SampleFrame* dst, const SampleFrame* src, ValueBuffer*, ValueBuffer*, int frames) {
+		MixHelpers::add(dst, src, frames);
+	} },
+	{ "multiply", 2 * FrameSize, [](SampleFrame* dst, const SampleFrame*, ValueBuffer*, ValueBuffer*, int frames) {
+		MixHelpers::multiply(dst, 1.0f, frames);
+	} },
+	{ "addMultiplied", 3 * FrameSize, [](SampleFrame* dst, const SampleFrame* src, ValueBuffer*, ValueBuffer*, int frames) {
+		MixHelpers::addMultiplied(dst, src, 0.5f, frames);
+	} },
+	{ "addSwappedMultiplied", 3 * FrameSize,
+		[](SampleFrame* dst, const SampleFrame* src, ValueBuffer*, ValueBuffer*, int frames) {
+		MixHelpers::addSwappedMultiplied(dst, src, 0.5f, frames);
+	} },
+	{ "addMultipliedByBuffer", 3 * FrameSize + static_cast<int>(sizeof(float)),
+		[](SampleFrame* dst, const SampleFrame* src, ValueBuffer* buf1, ValueBuffer*, int frames) {
+		MixHelpers::addMultipliedByBuffer(dst, src, 0.01f, buf1, frames);
+	} },
+	{ "addMultipliedByBuffers", 3 * FrameSize + 2 * static_cast<int>(sizeof(float)),
+		[](SampleFrame* dst, const SampleFrame* src, ValueBuffer* buf1, ValueBuffer* buf2, int frames) {
+		MixHelpers::addMultipliedByBuffers(dst, src, buf1, buf2, frames);
+	} },
+	{ "addMultipliedStereo", 3 * FrameSize,
+		[](SampleFrame* dst, const SampleFrame* src, ValueBuffer*, ValueBuffer*, int frames) {
+		MixHelpers::addMultipliedStereo(dst, src, 0.5f, 0.25f, frames);
+	} },
+	{ "multiplyAndAddMultiplied", 3 * FrameSize,
+		[](SampleFrame* dst, const SampleFrame* src, ValueBuffer*, ValueBuffer*, int frames) {
+		MixHelpers::multiplyAndAddMultiplied(dst, src, 0.5f, 0.5f, frames);
+	} },
+	{ "multiplyAndAddMultipliedJoined", 3 * FrameSize,
+		[](SampleFrame* dst, const SampleFrame* src, ValueBuffer*, ValueBuffer*, int frames) {
+		// the first and second half of the source stand in for the separate channel buffers
+		const auto left = src[0].data();
+		MixHelpers::multiplyAndAddMultipliedJoined(dst, left, left + frames, 0.5f, 0.5f, frames);
+	} },
+	{ "addSanitizedMultiplied", 3 * FrameSize,
+		[](SampleFrame* dst, const SampleFrame* src, ValueBuffer*, ValueBuffer*, int frames) {
+		MixHelpers::addSanitizedMultiplied(dst, src, 0.5f, frames);
+	} },
+	{ "addSanitizedMultipliedByBuffer", 3 * FrameSize + static_cast<int>(sizeof(float)),
+		[](SampleFrame* dst, const SampleFrame* src, ValueBuffer* buf1, ValueBuffer*, int frames) {
+		MixHelpers::addSanitizedMultipliedByBuffer(dst, src, 0.01f, buf1, frames);
+	} },
+	{ "addSanitizedMultipliedByBuffers", 3 * FrameSize + 2 * static_cast<int>(sizeof(float)),
+		[](SampleFrame* dst, const SampleFrame* src, ValueBuffer* buf1, ValueBuffer* buf2, int frames) {
+		MixHelpers::addSanitizedMultipliedByBuffers(dst, src, buf1, buf2, frames);
+	} },
+	{ "multiplyByVolumeAndPanning", 2 * FrameSize + 2 * static_cast<int>(sizeof(float)),
+		[](SampleFrame* dst, const SampleFrame*, ValueBuffer* volumes, ValueBuffer* pannings, int frames) {
+		MixHelpers::multiplyByVolumeAndPanning(dst, 100.0f, volumes, 0.0f, pannings, frames);
+	} },
+	{ "sanitize", 2 * FrameSize, [](SampleFrame* dst, const SampleFrame*, ValueBuffer*, ValueBuffer*, int frames) {
+		MixHelpers::sanitize(dst, frames);
+	} },
+	{ "isSilent", FrameSize, [](SampleFrame*, const SampleFrame*, ValueBuffer*, ValueBuffer*, int frames) {
+		// a silent buffer has to be scanned to the end, anything else returns at the first frame
+		static const auto silence = std::vector<SampleFrame>(4096);
+		[[maybe_unused]] static volatile bool silent;
+		silent = MixHelpers::isSilent(silence.data(), frames);
+	} },
+};
+
+double measure(const Kernel& kernel, int frames)
+{
+	// small enough to stay in cache, like the per-period buffers in the engine
+	auto src = std::vector<SampleFrame>(frames, SampleFrame{0.25f, -0.25f});
+	auto dst = std::vector<SampleFrame>(frames, SampleFrame{0.5f, -0.5f});
+	// unity gains as volume and panning in percent, so repeated runs don't decay into denormals
+	auto buf1 = ValueBuffer(frames);
+	auto buf2 = ValueBuffer(frames);
+	buf1.fill(100.0f);
+	buf2.fill(0.0f);
+
+	using clock = std::chrono::steady_clock;
+	long long iterations = 0;
+	const auto start = clock::now();
+	auto elapsed = clock::duration{};
+	do
+	{
+		for (int i = 0; i < 256; ++i)
+		{
+			kernel.run(dst.data(), src.data(), &buf1, &buf2, frames);
+		}
+		iterations += 256;
+		elapsed = clock::now() - start;
+	} while (elapsed < MinDuration);
+
+	const auto seconds = std::chrono::duration<double>(elapsed).count();
+	return static_cast<double>(iterations) * frames * kernel.bytesPerFrame / seconds / 1e9;
+}
+
+} // namespace
+
+int main()
+{
+	using MixHelpers::InstructionSet;
+
+	// make sure the sanitizing kernels take their checking path
+	MixHelpers::setNaNHandler(true);
+
+	const auto best = MixHelpers::instructionSet();
+	std::printf("# best instruction set: %s\n", MixHelpers::instructionSetName(best));
+	std::printf("kernel,isa,frames,gb_per_s\n");
+
+	for (const auto set : { InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX2,
+		InstructionSet::AVX512, InstructionSet::NEON })
+	{
+		if (!MixHelpers::setInstructionSet(set)) { continue; }
+
+		for (const auto& kernel : Kernels)
+		{
+			for (int frames = 32; frames <= 4096; frames *= 2)
+			{
+				std::printf("%s,%s,%d,%.2f\n", kernel.name, MixHelpers::instructionSetName(set), frames,
+					measure(kernel, frames));
+			}
+		}
+	}
+
+	MixHelpers::setInstructionSet(best);
+	return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * SampleBenchmark.cpp - throughput of many voices playing one sample
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QCoreApplication>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "Sample.h"
+#include "SampleFrame.h"
+
+using namespace lmms;
+
+namespace
+{
+
+constexpr auto MinDuration = std::chrono::milliseconds{50};
+
+const struct
+{
+	const char* name;
+	float frequency;
+	int interpolation;
+} Variants[] = {
+	// the original pitch only copies the frames, a fifth up has to interpolate
+	{ "Raw", DefaultBaseFreq, SRC_LINEAR },
+	{ "Linear", DefaultBaseFreq * 1.5f, SRC_LINEAR },
+	{ "SincFastest", DefaultBaseFreq * 1.5f, SRC_SINC_FASTEST },
+	{ "SincMedium", DefaultBaseFreq * 1.5f, SRC_SINC_MEDIUM_QUALITY },
+};
+
+//! Plays one period of \p voices voices over and over for at least MinDuration and returns the
+//! throughput in million voice frames per second
+double measure(const Sample& sample, float frequency, int interpolation, int voices)
+{
+	using clock = std::chrono::steady_clock;
+	const auto fpp = Engine::audioEngine()->framesPerPeriod();
+	// the states hold their resamplers, so they can't be copied into a vector
+	auto states = std::vector<std::unique_ptr<Sample::PlaybackState>>(voices);
+	for (auto& state : states)
+	{
+		state = std::make_unique<Sample::PlaybackState>(false, interpolation);
+	}
+	auto out = std::vector<SampleFrame>(fpp);
+
+	long long periods = 0;
+	const auto start = clock::now();
+	auto elapsed = clock::duration{};
+	do
+	{
+		for (auto& state : states)
+		{
+			sample.play(out.data(), state.get(), fpp, frequency, Sample::Loop::On);
+		}
+		++periods;
+		elapsed = clock::now() - start;
+	} while (elapsed < MinDuration);
+
+	const auto seconds = std::chrono::duration<double>(elapsed).count();
+	return static_cast<double>(periods) * voices * fpp / seconds / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	Engine::init(true);
+
+	const auto fpp = Engine::audioEngine()->framesPerPeriod();
+	auto data = std::vector<SampleFrame>(fpp * 64);
+	for (auto i = std::size_t{0}; i < data.size(); ++i)
+	{
+		data[i] = SampleFrame(std::sin(i * 0.01f));
+	}
+	const auto sample = Sample(data.data(), data.size());
+
+	std::printf("# frames per period: %d\n", static_cast<int>(fpp));
+	std::printf("variant,voices,mframes_per_s\n");
+
+	for (const auto& variant : Variants)
+	{
+		for (int voices = 1; voices <= 256; voices *= 4)
+		{
+			std::printf("%s,%d,%.2f\n", variant.name, voices,
+				measure(sample, variant.frequency, variant.interpolation, voices));
+			std::fflush(stdout);
+		}
+	}
+
+	Engine::destroy();
+	return 0;
+}
@@ -24,8 +24,14 @@
 
 
 #include <QtTest/QtTest>
+
+#include <algorithm>
+#include <vector>
+
 #include "AutomatableModel.h"
 #include "ComboBoxModel.h"
+#include "Controller.h"
+#include "ControllerConnection.h"
 #include "Engine.h"
 
 class AutomatableModelTest : public QObject
@@ -114,6 +120,157 @@ private slots: // tests
 		QVERIFY(m2.value());
 		QVERIFY(!m3.value());
 	}
+
+	//! A written model is queued and gets its buffer computed once, in the next period
+	void QueuedValueBufferTests()
+	{
+		using namespace lmms;
+
+		FloatModel model(0.f, 0.f, 1.f, 0.25f);
+		AutomatableModel::updateValueBuffers();
+		AutomatableModel::incrementPeriodCounter();
+
+		model.setValue(1.f);
+		AutomatableModel::updateValueBuffers();
+		QVERIFY(model.valueBuffer() != nullptr);
+		QCOMPARE(model.valueBuffer()->values()[0], 0.f);
+		QVERIFY(model.valueBuffer()->values()[model.valueBuffer()->length() - 1] > 0.5f);
+
+		// computing it again would find no change and drop the buffer
+		AutomatableModel::updateValueBuffers();
+		QVERIFY(model.valueBuffer() != nullptr);
+		QCOMPARE(model.valueBuffer()->values()[0], 0.f);
+		AutomatableModel::incrementPeriodCounter();
+
+		// it's not queued anymore
+		AutomatableModel::updateValueBuffers();
+		QVERIFY(model.valueBuffer() == nullptr);
+		QCOMPARE(model.value(), 1.f);
+		AutomatableModel::incrementPeriodCounter();
+
+		model.setValue(0.5f);
+		AutomatableModel::updateValueBuffers();
+		QVERIFY(model.valueBuffer() != nullptr);
+		QCOMPARE(model.valueBuffer()->values()[0], 1.f);
+		AutomatableModel::incrementPeriodCounter();
+	}
+
+	//! Linked models copy the buffer of a partner driven by a controller
+	void LinkedValueBufferTests()
+	{
+		using namespace lmms;
+
+		Controller controller(Controller::ControllerType::Dummy, nullptr, "Controller");
+		controller.setSampleExact(true);
+		FloatModel controlled(0.f, 0.f, 2.f, 0.25f);
+		FloatModel linked(0.f, 0.f, 2.f, 0.25f);
+		controlled.setControllerConnection(new ControllerConnection(&controller));
+		AutomatableModel::linkModels(&linked, &controlled);
+
+		AutomatableModel::updateValueBuffers();
+		QVERIFY(controlled.valueBuffer() != nullptr);
+		QVERIFY(linked.valueBuffer() != nullptr);
+		// the dummy controller stays at 0.5
+		QCOMPARE(controlled.valueBuffer()->values()[0], 1.f);
+		QCOMPARE(linked.valueBuffer()->values()[0], 1.f);
+		AutomatableModel::incrementPeriodCounter();
+
+		// both are recomputed every period, even without any write
+		AutomatableModel::updateValueBuffers();
+		QVERIFY(controlled.valueBuffer() != nullptr);
+		QVERIFY(linked.valueBuffer() != nullptr);
+		AutomatableModel::incrementPeriodCounter();
+
+		AutomatableModel::unlinkModels(&linked, &controlled);
+	}
+
+	//! A model destroyed while it's queued must leave the queue intact
+	void DestroyedWhileQueuedTests()
+	{
+		using namespace lmms;
+
+		FloatModel first(0.f, 0.f, 1.f, 0.25f);
+		auto doomed = new FloatModel(0.f, 0.f, 1.f, 0.25f);
+		FloatModel last(0.f, 0.f, 1.f, 0.25f);
+		AutomatableModel::updateValueBuffers();
+		AutomatableModel::incrementPeriodCounter();
+
+		first.setValue(1.f);
+		doomed->setValue(1.f);
+		last.setValue(1.f);
+		delete doomed;
+
+		AutomatableModel::updateValueBuffers();
+		QVERIFY(first.valueBuffer() != nullptr);
+		QVERIFY(last.valueBuffer() != nullptr);
+		AutomatableModel::incrementPeriodCounter();
+	}
+
+	//! In pipelined mode, the effects of a period must see what its
+	//! instruments were set up with, even if the model is written meanwhile
+	void PipelinedPeriodsTests()
+	{
+		using namespace lmms;
+		using PreviousPeriodScope = AutomatableModel::PreviousPeriodScope;
+
+		AutomatableModel::setPipelined(true);
+		FloatModel model(0.f, 0.f, 1.f, 0.25f);
+		FloatModel idle(0.f, 0.f, 1.f, 0.25f);
+
+		AutomatableModel::updateValueBuffers();
+		AutomatableModel::incrementPeriodCounter();
+
+		// automation moves the model before the period is set up, the GUI
+		// while its instruments render
+		model.setValue(0.25f);
+		AutomatableModel::updateValueBuffers();
+		const float instrumentsSaw = model.value();
+		QVERIFY(model.valueBuffer() != nullptr);
+		const auto bufferSaw = std::vector<float>(model.valueBuffer()->values(),
+			model.valueBuffer()->values() + model.valueBuffer()->length());
+		model.setValue(0.5f);
+		QCOMPARE(model.value(), 0.5f);
+		{
+			const PreviousPeriodScope previousPeriod;
+			QCOMPARE(model.value(), 0.f);
+			QVERIFY(model.valueBuffer() == nullptr);
+		}
+		AutomatableModel::incrementPeriodCounter();
+
+		// the next period only sees what has been written since
+		model.setValue(0.75f);
+		AutomatableModel::updateValueBuffers();
+		QCOMPARE(model.value(), 0.75f);
+		{
+			const PreviousPeriodScope previousPeriod;
+			QCOMPARE(model.value(), instrumentsSaw);
+			QVERIFY(model.valueBuffer() != nullptr);
+			QVERIFY(std::equal(bufferSaw.begin(), bufferSaw.end(), model.valueBuffer()->values()));
+		}
+
+		// models which haven't been updated for a while keep the old value as well
+		idle.setValue(1.f);
+		QCOMPARE(idle.value(), 1.f);
+		{
+			const PreviousPeriodScope previousPeriod;
+			QCOMPARE(idle.value(), 0.f);
+		}
+		AutomatableModel::incrementPeriodCounter();
+		AutomatableModel::updateValueBuffers();
+		{
+			// the write to idle was made while that period rendered
+			const PreviousPeriodScope previousPeriod;
+			QCOMPARE(model.value(), 0.75f);
+			QCOMPARE(idle.value(), 0.f);
+		}
+		AutomatableModel::incrementPeriodCounter();
+
+		AutomatableModel::setPipelined(false);
+		{
+			const PreviousPeriodScope previousPeriod;
+			QCOMPARE(idle.value(), 1.f);
+		}
+	}
 };
 
 QTEST_GUILESS_MAIN(AutomatableModelTest)
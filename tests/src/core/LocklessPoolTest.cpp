@@ -0,0 +1,178 @@
+/*
+ * LocklessPoolTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "LocklessPool.h"
+
+class LocklessPoolTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void AllocAndFree()
+	{
+		using namespace lmms;
+		auto pool = LocklessPool(100, 64);
+		QCOMPARE(pool.statistics().capacity, std::size_t{64});
+
+		// blocks are distinct, aligned and can be written in full
+		auto blocks = std::vector<void*>();
+		for (int i = 0; i < 64; ++i)
+		{
+			void* block = pool.alloc();
+			QVERIFY(block != nullptr);
+			QCOMPARE(reinterpret_cast<std::uintptr_t>(block) % LocklessPool::CacheLineSize, std::uintptr_t{0});
+			std::memset(block, i, 100);
+			blocks.push_back(block);
+		}
+		for (int i = 0; i < 64; ++i)
+		{
+			QCOMPARE(static_cast<unsigned char*>(blocks[i])[99], static_cast<unsigned char>(i));
+		}
+		std::sort(blocks.begin(), blocks.end());
+		QVERIFY(std::adjacent_find(blocks.begin(), blocks.end()) == blocks.end());
+		QCOMPARE(pool.statistics().inUse, std::size_t{64});
+
+		for (void* block : blocks) { pool.free(block); }
+		pool.free(nullptr);
+		QCOMPARE(pool.statistics().inUse, std::size_t{0});
+		QCOMPARE(pool.statistics().highWaterMark, std::size_t{64});
+
+		// freed blocks are reused instead of growing the pool
+		pool.free(pool.alloc());
+		QCOMPARE(pool.statistics().capacity, std::size_t{64});
+		QCOMPARE(pool.statistics().exhaustions, std::size_t{0});
+	}
+
+	void GrowsWhenExhausted()
+	{
+		using namespace lmms;
+		auto pool = LocklessPool(16);
+		const auto totalExhaustions = LocklessPool::totalExhaustions();
+
+		auto blocks = std::vector<void*>();
+		for (int i = 0; i < 100; ++i)
+		{
+			blocks.push_back(pool.alloc());
+			QVERIFY(blocks.back() != nullptr);
+		}
+		const auto statistics = pool.statistics();
+		QVERIFY(statistics.capacity >= 100);
+		QVERIFY(statistics.exhaustions > 0);
+		QCOMPARE(statistics.unpooled, std::size_t{0});
+		QCOMPARE(LocklessPool::totalExhaustions(), totalExhaustions + statistics.exhaustions);
+
+		for (void* block : blocks) { pool.free(block); }
+		QCOMPARE(pool.statistics().inUse, std::size_t{0});
+	}
+
+	void AllocatesOnItsOwnWhenFull()
+	{
+		using namespace lmms;
+		// the pool can't grow any further, so the block beyond gets allocated on its own
+		auto pool = LocklessPool(16);
+		auto blocks = std::vector<void*>();
+		void* block = nullptr;
+		while (pool.statistics().unpooled == 0)
+		{
+			block = pool.alloc();
+			QVERIFY(block != nullptr);
+			blocks.push_back(block);
+		}
+		const auto capacity = pool.statistics().capacity;
+		QCOMPARE(pool.statistics().inUse, capacity + 1);
+
+		std::memset(block, 0xff, 16);
+		const auto totalExhaustions = LocklessPool::totalExhaustions();
+		pool.free(block);
+		blocks.pop_back();
+		QCOMPARE(pool.statistics().inUse, capacity);
+
+		// a freed slab block is preferred over another one of its own
+		pool.free(blocks.back());
+		blocks.back() = pool.alloc();
+		QCOMPARE(pool.statistics().unpooled, std::size_t{1});
+		QCOMPARE(LocklessPool::totalExhaustions(), totalExhaustions);
+
+		for (void* b : blocks) { pool.free(b); }
+		QCOMPARE(pool.statistics().inUse, std::size_t{0});
+	}
+
+	void FreesFromOtherThreads()
+	{
+		using namespace lmms;
+		constexpr int Blocks = 10000;
+		auto pool = LocklessPool(32, 128, 32);
+
+		// one thread allocates, another one frees, both touch the blocks
+		constexpr int MaxInFlight = 256;
+		auto handedOver = std::vector<std::atomic<void*>>(Blocks);
+		auto freed = std::atomic<int>(0);
+		auto producer = std::thread([&] {
+			for (int i = 0; i < Blocks; ++i)
+			{
+				while (i - freed.load(std::memory_order_acquire) >= MaxInFlight)
+				{
+					std::this_thread::yield();
+				}
+				auto block = static_cast<int*>(pool.alloc());
+				*block = i;
+				handedOver[i].store(block, std::memory_order_release);
+			}
+		});
+		auto mismatches = 0;
+		auto consumer = std::thread([&] {
+			for (int i = 0; i < Blocks; ++i)
+			{
+				void* block;
+				while ((block = handedOver[i].load(std::memory_order_acquire)) == nullptr)
+				{
+					std::this_thread::yield();
+				}
+				if (*static_cast<int*>(block) != i) { ++mismatches; }
+				pool.free(block);
+				freed.store(i + 1, std::memory_order_release);
+			}
+		});
+		producer.join();
+		consumer.join();
+
+		QCOMPARE(mismatches, 0);
+		QCOMPARE(pool.statistics().inUse, std::size_t{0});
+		// blocks went back to the pool, so it didn't have to hold all of them at once
+		QVERIFY(pool.statistics().highWaterMark <= static_cast<std::size_t>(MaxInFlight));
+		QVERIFY(pool.statistics().capacity < static_cast<std::size_t>(Blocks));
+	}
+};
+
+QTEST_GUILESS_MAIN(LocklessPoolTest)
+#include "LocklessPoolTest.moc"
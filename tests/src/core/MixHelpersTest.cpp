@@ -0,0 +1,157 @@
+/*
+ * MixHelpersTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "MixHelpers.h"
+#include "SampleFrame.h"
+#include "ValueBuffer.h"
+
+Q_DECLARE_METATYPE(lmms::MixHelpers::InstructionSet)
+
+class MixHelpersTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		lmms::MixHelpers::setNaNHandler(true);
+	}
+
+	void cleanupTestCase()
+	{
+		lmms::MixHelpers::setInstructionSet(lmms::MixHelpers::InstructionSet::Scalar);
+	}
+
+	void SanitizedAccumulateSkipsBadSamples_data()
+	{
+		instructionSets();
+	}
+
+	void SanitizedAccumulateSkipsBadSamples()
+	{
+		using namespace lmms;
+		QFETCH(MixHelpers::InstructionSet, set);
+		if (!MixHelpers::setInstructionSet(set)) { QSKIP("not supported on this CPU"); }
+
+		// an odd length covers both the vector loop and the scalar tail of every instruction set
+		constexpr int Frames = 37;
+		auto src = std::vector<SampleFrame>(Frames, SampleFrame(0.5f, -0.5f));
+		src[3].setLeft(std::numeric_limits<float>::quiet_NaN());
+		src[Frames - 1].setRight(std::numeric_limits<float>::infinity());
+
+		auto dst = std::vector<SampleFrame>(Frames, SampleFrame(1.f, 1.f));
+		MixHelpers::addSanitizedMultiplied(dst.data(), src.data(), 0.5f, Frames);
+
+		auto coeffs1 = ValueBuffer(Frames);
+		auto coeffs2 = ValueBuffer(Frames);
+		for (int f = 0; f < Frames; ++f)
+		{
+			coeffs1.values()[f] = f % 2 ? 2.f : 1.f;
+			coeffs2.values()[f] = 0.5f;
+		}
+		MixHelpers::addSanitizedMultipliedByBuffers(dst.data(), src.data(), &coeffs1, &coeffs2, Frames);
+
+		for (int f = 0; f < Frames; ++f)
+		{
+			const float gain = 0.5f + (f % 2 ? 1.f : 0.5f);
+			QCOMPARE(dst[f].left(), f == 3 ? 1.f : 1.f + 0.5f * gain);
+			QCOMPARE(dst[f].right(), f == Frames - 1 ? 1.f : 1.f - 0.5f * gain);
+		}
+	}
+
+	void SanitizeClampsOrClears_data()
+	{
+		instructionSets();
+	}
+
+	void SanitizeClampsOrClears()
+	{
+		using namespace lmms;
+		QFETCH(MixHelpers::InstructionSet, set);
+		if (!MixHelpers::setInstructionSet(set)) { QSKIP("not supported on this CPU"); }
+
+		constexpr int Frames = 21;
+		auto buf = std::vector<SampleFrame>(Frames, SampleFrame(2000.f, -0.25f));
+		QVERIFY(!MixHelpers::sanitize(buf.data(), Frames));
+		QCOMPARE(buf[Frames - 1].left(), 1000.f);
+		QCOMPARE(buf[0].right(), -0.25f);
+
+		buf[Frames - 1].setRight(-std::numeric_limits<float>::infinity());
+		QVERIFY(MixHelpers::sanitize(buf.data(), Frames));
+		for (const auto& frame : buf)
+		{
+			QCOMPARE(frame.left(), 0.f);
+			QCOMPARE(frame.right(), 0.f);
+		}
+	}
+
+	void VolumeAndPanningMatchesPanLaw_data()
+	{
+		instructionSets();
+	}
+
+	void VolumeAndPanningMatchesPanLaw()
+	{
+		using namespace lmms;
+		QFETCH(MixHelpers::InstructionSet, set);
+		if (!MixHelpers::setInstructionSet(set)) { QSKIP("not supported on this CPU"); }
+
+		constexpr int Frames = 35;
+		auto pannings = ValueBuffer(Frames);
+		for (int f = 0; f < Frames; ++f)
+		{
+			pannings.values()[f] = f % 2 ? 50.f : -50.f;
+		}
+
+		// panning attenuates the opposite side only
+		auto buf = std::vector<SampleFrame>(Frames, SampleFrame(1.f, 1.f));
+		MixHelpers::multiplyByVolumeAndPanning(buf.data(), 50.f, nullptr, 0.f, &pannings, Frames);
+		for (int f = 0; f < Frames; ++f)
+		{
+			QCOMPARE(buf[f].left(), f % 2 ? 0.25f : 0.5f);
+			QCOMPARE(buf[f].right(), f % 2 ? 0.5f : 0.25f);
+		}
+	}
+
+private:
+	static void instructionSets()
+	{
+		using lmms::MixHelpers::InstructionSet;
+		QTest::addColumn<InstructionSet>("set");
+		for (auto set : { InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX2,
+			InstructionSet::AVX512, InstructionSet::NEON })
+		{
+			QTest::newRow(lmms::MixHelpers::instructionSetName(set)) << set;
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(MixHelpersTest)
+#include "MixHelpersTest.moc"
@@ -0,0 +1,132 @@
+/*
+ * PeriodRingTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "PeriodRing.h"
+#include "SampleFrame.h"
+
+class PeriodRingTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void WrapsAround()
+	{
+		using namespace lmms;
+		constexpr fpp_t Frames = 4;
+		auto ring = PeriodRing(3, Frames);
+
+		// keep two periods in flight, so reads and writes cross the end of the ring at different times
+		auto write = [&ring](float value) {
+			SampleFrame* period = ring.beginWrite();
+			std::fill(period, period + Frames, SampleFrame(value, -value));
+			ring.endWrite();
+		};
+		write(0.f);
+		for (int i = 1; i < 10; ++i)
+		{
+			write(static_cast<float>(i));
+			QCOMPARE(ring.fillLevel(), std::size_t{2});
+
+			const SampleFrame* period = ring.beginRead();
+			QVERIFY(period != nullptr);
+			for (fpp_t f = 0; f < Frames; ++f)
+			{
+				QCOMPARE(period[f].left(), static_cast<float>(i - 1));
+				QCOMPARE(period[f].right(), -static_cast<float>(i - 1));
+			}
+			ring.endRead();
+		}
+		QCOMPARE(ring.fillLevel(), std::size_t{1});
+		QCOMPARE(ring.statistics().underruns, std::size_t{0});
+		QCOMPARE(ring.statistics().minFillLevel, std::size_t{2});
+	}
+
+	void BlocksWhenFullOrEmpty()
+	{
+		using namespace lmms;
+		using namespace std::chrono_literals;
+		auto ring = PeriodRing(2, 4);
+
+		// the reader waits for the first period and counts an underrun
+		auto started = std::atomic<bool>(false);
+		auto read = std::atomic<bool>(false);
+		auto reader = std::thread([&] {
+			started = true;
+			ring.beginRead();
+			ring.endRead();
+			read = true;
+		});
+		while (!started) { std::this_thread::yield(); }
+		std::this_thread::sleep_for(50ms);
+		QVERIFY(!read);
+		ring.beginWrite();
+		ring.endWrite();
+		reader.join();
+		QVERIFY(read);
+		QCOMPARE(ring.statistics().underruns, std::size_t{1});
+		QCOMPARE(ring.fillLevel(), std::size_t{0});
+
+		// the writer waits for a free slot
+		for (int i = 0; i < 2; ++i)
+		{
+			ring.beginWrite();
+			ring.endWrite();
+		}
+		QCOMPARE(ring.fillLevel(), ring.capacity());
+		auto written = std::atomic<bool>(false);
+		auto writer = std::thread([&] {
+			ring.beginWrite();
+			ring.endWrite();
+			written = true;
+		});
+		std::this_thread::sleep_for(50ms);
+		QVERIFY(!written);
+		ring.beginRead();
+		ring.endRead();
+		writer.join();
+		QVERIFY(written);
+		QCOMPARE(ring.fillLevel(), ring.capacity());
+
+		// the end of the stream comes after what has been written before
+		auto closer = std::thread([&] { ring.close(); });
+		QVERIFY(ring.beginRead() != nullptr);
+		ring.endRead();
+		QVERIFY(ring.beginRead() != nullptr);
+		ring.endRead();
+		QVERIFY(ring.beginRead() == nullptr);
+		ring.endRead();
+		closer.join();
+		QCOMPARE(ring.fillLevel(), std::size_t{0});
+	}
+};
+
+QTEST_GUILESS_MAIN(PeriodRingTest)
+#include "PeriodRingTest.moc"
@@ -0,0 +1,188 @@
+/*
+ * SampleCacheTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+#include <QDataStream>
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+#include <chrono>
+#include <filesystem>
+
+#include "Engine.h"
+#include "SampleBuffer.h"
+#include "SampleCache.h"
+
+class SampleCacheTest : public QObject
+{
+	Q_OBJECT
+private:
+	QTemporaryDir m_dir;
+
+	QString path(const QString& name) const
+	{
+		return m_dir.filePath(name);
+	}
+
+	//! Write a 16 bit mono WAV file holding \p frames times \p value
+	static void writeWav(const QString& fileName, int frames, qint16 value)
+	{
+		auto file = QFile{fileName};
+		QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+
+		auto stream = QDataStream{&file};
+		stream.setByteOrder(QDataStream::LittleEndian);
+		const auto dataSize = static_cast<quint32>(frames * 2);
+		stream.writeRawData("RIFF", 4);
+		stream << quint32{36 + dataSize};
+		stream.writeRawData("WAVEfmt ", 8);
+		stream << quint32{16} << quint16{1} << quint16{1} << quint32{44100} << quint32{44100 * 2}
+			<< quint16{2} << quint16{16};
+		stream.writeRawData("data", 4);
+		stream << dataSize;
+		for (int f = 0; f < frames; ++f) { stream << value; }
+	}
+
+	static auto lastWriteTime(const QString& fileName)
+	{
+		return std::filesystem::last_write_time(fileName.toStdString());
+	}
+
+	static void setLastWriteTime(const QString& fileName, std::filesystem::file_time_type time)
+	{
+		std::filesystem::last_write_time(fileName.toStdString(), time);
+	}
+
+private slots:
+	void initTestCase()
+	{
+		using namespace lmms;
+		Engine::init(true);
+		QVERIFY(m_dir.isValid());
+	}
+
+	void cleanupTestCase()
+	{
+		using namespace lmms;
+		Engine::destroy();
+	}
+
+	void SameFileIsShared()
+	{
+		using namespace lmms;
+		writeWav(path("hit.wav"), 100, 1000);
+
+		const auto first = SampleCache::get(path("hit.wav"));
+		const auto second = SampleCache::get(path("hit.wav"));
+		QCOMPARE(second, first);
+		QCOMPARE(first->size(), std::size_t{100});
+
+		// the path is cleaned before the lookup
+		const auto third = SampleCache::get(m_dir.path() + "/./hit.wav");
+		QCOMPARE(third, first);
+		QCOMPARE(SampleCache::size(), std::size_t{1});
+	}
+
+	void SpellingOfThePathDoesNotMatter()
+	{
+		using namespace lmms;
+		writeWav(path("spelling.wav"), 100, 1000);
+
+		// whoever loads the file first must not decide which path the others save
+		const auto first = SampleCache::get(m_dir.path() + "/./spelling.wav");
+		const auto second = SampleCache::get(path("spelling.wav"));
+		QCOMPARE(second, first);
+		QCOMPARE(first->audioFile(), SampleBuffer{path("spelling.wav")}.audioFile());
+	}
+
+	void DifferentFilesAreNotShared()
+	{
+		using namespace lmms;
+		writeWav(path("a.wav"), 100, 1000);
+		writeWav(path("b.wav"), 100, 1000);
+
+		const auto a = SampleCache::get(path("a.wav"));
+		const auto b = SampleCache::get(path("b.wav"));
+		QVERIFY(a != b);
+		QCOMPARE(SampleCache::size(), std::size_t{2});
+	}
+
+	void ChangedModificationTimeReloads()
+	{
+		using namespace lmms;
+		writeWav(path("mtime.wav"), 100, 1000);
+		const auto time = lastWriteTime(path("mtime.wav"));
+		const auto first = SampleCache::get(path("mtime.wav"));
+
+		// same size, different content and a later modification time
+		writeWav(path("mtime.wav"), 100, -1000);
+		setLastWriteTime(path("mtime.wav"), time + std::chrono::hours{1});
+
+		const auto second = SampleCache::get(path("mtime.wav"));
+		QVERIFY(second != first);
+		QCOMPARE(second->size(), first->size());
+		QVERIFY(first->data()[0][0] > 0.f);
+		QVERIFY(second->data()[0][0] < 0.f);
+	}
+
+	void ChangedSizeReloads()
+	{
+		using namespace lmms;
+		writeWav(path("size.wav"), 100, 1000);
+		const auto time = lastWriteTime(path("size.wav"));
+		const auto first = SampleCache::get(path("size.wav"));
+
+		// keep the modification time, so only the size tells the files apart
+		writeWav(path("size.wav"), 200, 1000);
+		setLastWriteTime(path("size.wav"), time);
+
+		const auto second = SampleCache::get(path("size.wav"));
+		QVERIFY(second != first);
+		QCOMPARE(first->size(), std::size_t{100});
+		QCOMPARE(second->size(), std::size_t{200});
+	}
+
+	void UnusedBuffersExpire()
+	{
+		using namespace lmms;
+		writeWav(path("expire.wav"), 100, 1000);
+
+		auto buffer = SampleCache::get(path("expire.wav"));
+		auto weak = std::weak_ptr<const SampleBuffer>{buffer};
+		QCOMPARE(SampleCache::size(), std::size_t{1});
+
+		// the cache doesn't keep the buffer alive
+		buffer.reset();
+		QVERIFY(weak.expired());
+		QCOMPARE(SampleCache::size(), std::size_t{0});
+
+		// and decodes the file again on the next request
+		buffer = SampleCache::get(path("expire.wav"));
+		QCOMPARE(buffer->size(), std::size_t{100});
+		QCOMPARE(SampleCache::size(), std::size_t{1});
+	}
+};
+
+QTEST_GUILESS_MAIN(SampleCacheTest)
+#include "SampleCacheTest.moc"
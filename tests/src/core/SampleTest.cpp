@@ -0,0 +1,137 @@
+/*
+ * SampleTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "Sample.h"
+
+namespace
+{
+
+// counts the allocations of the current thread while enabled
+thread_local bool s_countAllocations = false;
+std::atomic<int> s_allocations = 0;
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+	if (s_countAllocations) { ++s_allocations; }
+	if (void* ptr = std::malloc(size ? size : 1)) { return ptr; }
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+class SampleTest : public QObject
+{
+	Q_OBJECT
+private:
+	static std::vector<lmms::SampleFrame> sine(std::size_t frames)
+	{
+		auto data = std::vector<lmms::SampleFrame>(frames);
+		for (auto i = std::size_t{0}; i < frames; ++i)
+		{
+			data[i] = lmms::SampleFrame(std::sin(i * 0.01f));
+		}
+		return data;
+	}
+
+private slots:
+	void initTestCase()
+	{
+		using namespace lmms;
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		using namespace lmms;
+		Engine::destroy();
+	}
+
+	void PlayAtOriginalPitchCopiesFrames()
+	{
+		using namespace lmms;
+		const auto fpp = Engine::audioEngine()->framesPerPeriod();
+		const auto data = sine(fpp * 4);
+		const auto sample = Sample(data.data(), data.size());
+
+		auto state = Sample::PlaybackState{};
+		auto out = std::vector<SampleFrame>(fpp);
+		for (auto period = std::size_t{0}; period < 4; ++period)
+		{
+			QVERIFY(sample.play(out.data(), &state, fpp));
+			for (auto f = std::size_t{0}; f < fpp; ++f)
+			{
+				QCOMPARE(out[f][0], data[period * fpp + f][0]);
+			}
+		}
+		QVERIFY(!sample.play(out.data(), &state, fpp));
+	}
+
+	void PlayDoesNotAllocate()
+	{
+		using namespace lmms;
+		const auto fpp = Engine::audioEngine()->framesPerPeriod();
+		const auto data = sine(fpp * 64);
+		const auto sample = Sample(data.data(), data.size());
+		auto out = std::vector<SampleFrame>(fpp);
+
+		// original pitch, a fifth and two octaves up, looped so the sample doesn't run out
+		for (const float frequency : {DefaultBaseFreq, DefaultBaseFreq * 1.5f, DefaultBaseFreq * 4.f})
+		{
+			auto state = Sample::PlaybackState{false, SRC_SINC_FASTEST};
+			sample.play(out.data(), &state, fpp, frequency, Sample::Loop::On);
+
+			s_allocations = 0;
+			s_countAllocations = true;
+			for (int period = 0; period < 1000; ++period)
+			{
+				sample.play(out.data(), &state, fpp, frequency, Sample::Loop::On);
+			}
+			s_countAllocations = false;
+			QCOMPARE(s_allocations.load(), 0);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(SampleTest)
+#include "SampleTest.moc"
@@ -24,9 +24,14 @@
 
 #include <QtTest/QtTest>
 
+#include <cmath>
+#include <memory>
+#include <vector>
+
 #include "QCoreApplication"
 
 #include "AutomationClip.h"
+#include "AutomationTimeline.h"
 #include "AutomationTrack.h"
 #include "DetuningHelper.h"
 #include "InstrumentTrack.h"
@@ -150,6 +155,33 @@ private slots:
 		QCOMPARE(song->automatedValuesAt(100)[&model], 0.5f);
 	}
 
+	void testFillBlock()
+	{
+		using namespace lmms;
+
+		AutomationClip c(nullptr);
+		c.setProgressionType(AutomationClip::ProgressionType::Linear);
+		c.putValue(0, 0.0, false);
+		c.putValue(100, 1.0, false);
+		c.setAutoResize(true);
+
+		const auto framesPerTick = Engine::framesPerTick();
+		const auto frames = static_cast<fpp_t>(framesPerTick * 200);
+		auto values = std::vector<float>(frames);
+		c.fillBlock(10, frames, values.data());
+
+		QCOMPARE(values[0], c.valueAt(10));
+		for (fpp_t frame = 0; frame < frames; ++frame)
+		{
+			const auto expected = std::min((10 + frame / framesPerTick) / 100, 1.f);
+			QVERIFY(std::abs(values[frame] - expected) < 1e-4f);
+		}
+
+		// edits are visible right away
+		c.putValue(100, 0.5, false);
+		QCOMPARE(c.valueAt(100), 0.5f);
+	}
+
 	void testInlineAutomation()
 	{
 		using namespace lmms;
@@ -240,6 +272,148 @@ private slots:
 		QCOMPARE(song->automatedValuesAt(0)[&model], 50.0f);
 	}
 
+	void testTimelineMatchesTracks()
+	{
+		using namespace lmms;
+
+		auto song = Engine::getSong();
+		AutomationTrack track(song);
+		AutomationTrack mutedTrack(song);
+		mutedTrack.setMuted(true);
+
+		FloatModel model1;
+		FloatModel model2;
+		std::vector<std::unique_ptr<AutomationClip>> clips;
+		for (int i = 0; i < 8; ++i)
+		{
+			auto clip = std::make_unique<AutomationClip>(i % 3 == 2 ? &mutedTrack : &track);
+			clip->setProgressionType(AutomationClip::ProgressionType::Linear);
+			clip->putValue(0, 0.1f * i, false);
+			clip->putValue(40, 0.1f * i + 0.05f, false);
+			clip->movePosition(i * 25);
+			clip->changeLength(40);
+			clip->addObject(i % 2 ? &model1 : &model2);
+			clips.push_back(std::move(clip));
+		}
+		clips[3]->addObject(&model2);
+		clips[4]->clear();
+
+		AutomationTimeline timeline(song);
+		const auto compare = [&](int time) {
+			QCOMPARE(timeline.valuesAt(time), song->automatedValuesAt(time));
+		};
+
+		for (int time = 0; time < 300; time += 5) { compare(time); }
+		compare(30);
+		compare(260);
+
+		// edits made after the index was built
+		clips[4]->putValue(0, 0.9f, false);
+		compare(260);
+		clips[6]->movePosition(10);
+		compare(270);
+		clips[7]->toggleMute();
+		compare(280);
+		clips[5].reset();
+		compare(280);
+		auto added = std::make_unique<AutomationClip>(&track);
+		added->putValue(0, 0.7f, false);
+		added->movePosition(250);
+		added->changeLength(40);
+		added->addObject(&model1);
+		compare(270);
+	}
+
+	void testClipsInRange()
+	{
+		using namespace lmms;
+
+		auto song = Engine::getSong();
+		AutomationTrack track(song);
+		std::vector<std::unique_ptr<AutomationClip>> clips;
+		for (int i = 0; i < 6; ++i)
+		{
+			clips.push_back(std::make_unique<AutomationClip>(&track));
+			clips.back()->movePosition(i * 100);
+			clips.back()->changeLength(50);
+		}
+		// a long clip overlapping the later ones
+		clips[1]->changeLength(350);
+
+		const auto range = [&](int start, int end) {
+			Track::clipVector result;
+			track.getClipsInRange(result, start, end);
+			return result;
+		};
+		using Result = Track::clipVector;
+
+		QCOMPARE(range(0, 10), (Result{clips[0].get()}));
+		QCOMPARE(range(60, 90), Result{});
+		QCOMPARE(range(320, 330), (Result{clips[1].get(), clips[3].get()}));
+		QCOMPARE(range(460, 470), Result{});
+		QCOMPARE(range(10, 20), (Result{clips[0].get()}));
+
+		// index must follow edits
+		clips[5]->movePosition(0);
+		QCOMPARE(range(10, 20), (Result{clips[0].get(), clips[5].get()}));
+		clips[1]->changeLength(50);
+		QCOMPARE(range(320, 330), (Result{clips[3].get()}));
+	}
+
+	void benchmarkAutomatedValuesFromTracks()
+	{
+		using namespace lmms;
+
+		auto song = Engine::getSong();
+		AutomationTrack track(song);
+		FloatModel model;
+		auto clips = createClips(track, model, 2000);
+
+		int time = 0;
+		QBENCHMARK
+		{
+			song->automatedValuesAt(time);
+			time = (time + 1) % (2000 * 48);
+		}
+	}
+
+	void benchmarkAutomationTimeline()
+	{
+		using namespace lmms;
+
+		auto song = Engine::getSong();
+		AutomationTrack track(song);
+		FloatModel model;
+		auto clips = createClips(track, model, 2000);
+
+		AutomationTimeline timeline(song);
+		int time = 0;
+		QBENCHMARK
+		{
+			timeline.valuesAt(time);
+			time = (time + 1) % (2000 * 48);
+		}
+	}
+
+private:
+	static std::vector<std::unique_ptr<lmms::AutomationClip>> createClips(
+		lmms::AutomationTrack& track, lmms::FloatModel& model, int count)
+	{
+		using namespace lmms;
+
+		auto clips = std::vector<std::unique_ptr<AutomationClip>>{};
+		for (int i = 0; i < count; ++i)
+		{
+			auto clip = std::make_unique<AutomationClip>(&track);
+			clip->putValue(0, 0.f, false);
+			clip->putValue(24, 1.f, false);
+			clip->movePosition(i * 48);
+			clip->changeLength(48);
+			clip->addObject(&model);
+			clips.push_back(std::move(clip));
+		}
+		return clips;
+	}
 };
 
 QTEST_GUILESS_MAIN(AutomationTrackTest)
@@ -0,0 +1,123 @@
+/*
+ * MidiClipTest.cpp
+ *
+ * Copyright (c) 2026 LMMS Developers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "InstrumentTrack.h"
+#include "MidiClip.h"
+
+#include "Engine.h"
+#include "Song.h"
+
+class MidiClipTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		using namespace lmms;
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		using namespace lmms;
+		Engine::destroy();
+	}
+
+	void testNotesStartingAt()
+	{
+		using namespace lmms;
+
+		InstrumentTrack track(Engine::getSong());
+		MidiClip clip(&track);
+		for (int pos : {0, 0, 12, 24, 24, 24, 96})
+		{
+			clip.addNote(Note(TimePos(12), TimePos(pos)), false);
+		}
+
+		// number of notes found, -1 if one of them doesn't start at time
+		const auto count = [&](int time) {
+			const auto [begin, end] = clip.notesStartingAt(time);
+			const bool allStart = std::all_of(begin, end, [time](const Note* note) { return note->pos() == time; });
+			return allStart ? static_cast<int>(end - begin) : -1;
+		};
+
+		// linear playback
+		std::vector<int> counts;
+		for (int time = 0; time <= 100; ++time) { counts.push_back(count(time)); }
+		QCOMPARE(counts[0], 2);
+		QCOMPARE(counts[12], 1);
+		QCOMPARE(counts[24], 3);
+		QCOMPARE(counts[96], 1);
+		QCOMPARE(std::accumulate(counts.begin(), counts.end(), 0), 7);
+
+		// jumps in both directions
+		QCOMPARE(count(24), 3);
+		QCOMPARE(count(0), 2);
+		QCOMPARE(count(96), 1);
+		QCOMPARE(count(13), 0);
+
+		// edits between two calls
+		QCOMPARE(count(12), 1);
+		clip.addNote(Note(TimePos(12), TimePos(5)), false);
+		clip.addNote(Note(TimePos(12), TimePos(13)), false);
+		QCOMPARE(count(13), 1);
+		clip.removeNote(clip.notes().front());
+		QCOMPARE(count(0), 1);
+		QCOMPARE(count(5), 1);
+	}
+
+	void benchmarkDenseClip()
+	{
+		using namespace lmms;
+
+		// roughly what importing a dense piano performance gives:
+		// 20000 notes, mostly in chords, over about 80 bars
+		InstrumentTrack track(Engine::getSong());
+		MidiClip clip(&track);
+		const int length = 20000 / 4 * 3;
+		for (int pos = 0; pos < length; pos += 3)
+		{
+			for (int key = 0; key < 4; ++key)
+			{
+				clip.addNote(Note(TimePos(6), TimePos(pos), 48 + key * 4), false);
+			}
+		}
+
+		int time = 0;
+		QBENCHMARK
+		{
+			clip.notesStartingAt(time);
+			time = (time + 1) % length;
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(MidiClipTest)
+#include "MidiClipTest.moc"